@@ -60,7 +60,7 @@ private:
     const float scale = 0.47f;
 
     C2D_Text multiSelectText, multiDeselectText;
-    C2D_TextBuf staticBuf, dynamicBuf;
+    C2D_TextBuf staticBuf;
 };
 
 #endif
\ No newline at end of file
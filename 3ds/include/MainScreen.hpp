@@ -67,7 +67,7 @@ private:
     C2D_Text checkpoint, version;
     // instructions text
     C2D_Text top_move, top_a, top_y, top_my, top_b, bot_ts, bot_x, coins;
-    C2D_TextBuf dynamicBuf, staticBuf;
+    C2D_TextBuf staticBuf;
 
     const float scaleInst = 0.7f;
     C2D_ImageTint checkboxTint;
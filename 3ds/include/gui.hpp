@@ -28,9 +28,12 @@
 #define GUI_HPP
 
 #include "colors.hpp"
+#include "framescheduler.hpp"
 #include "main.hpp"
+#include "profiler.hpp"
 #include "sprites.h"
 #include <citro2d.h>
+#include <string>
 
 inline C3D_RenderTarget* g_top;
 inline C3D_RenderTarget* g_bottom;
@@ -43,6 +46,13 @@ namespace Gui {
     void init(void);
     void exit(void);
     void frameEnd(void);
+    // parsed text that stays valid until the end of the frame, reparsed only when the content is new
+    const C2D_Text& text(const std::string& str);
+    float textCacheHitRate(void);
+    // brightness of the pulsing selectors, it marks the frame as animated
+    float highlightMultiplier(void);
+    // stage timings of the last frames on the top screen, toggled with SELECT and down
+    void drawProfiler(void);
 
     void drawPulsingOutline(u32 x, u32 y, u16 w, u16 h, u8 size, u32 color);
     void drawOutline(u32 x, u32 y, u16 w, u16 h, u8 size, u32 color);
@@ -41,7 +41,6 @@ public:
 
     virtual ~Scrollable(void) {}
 
-    void c2dText(size_t i, const std::string& v);
     void draw(bool condition = false) override;
     void setIndex(size_t i);
     void push_back(u32 color, u32 colorMessage, const std::string& message, bool selected) override;
@@ -38,6 +38,7 @@
 #include "util.hpp"
 #include <algorithm>
 #include <citro2d.h>
+#include <numeric>
 #include <string>
 #include <vector>
 
@@ -72,6 +73,8 @@ public:
     FS_MediaType mediaType(void);
     std::string mediaTypeString(void);
     void refreshDirectories(void);
+    void invalidateDirectories(void);
+    bool directoriesOutdated(void);
     std::u16string savePath(void);
     std::u16string fullSavePath(size_t index);
     std::vector<std::u16string> saves(void);
@@ -95,6 +98,7 @@ private:
     std::vector<std::u16string> mFullSavePaths;
     std::vector<std::u16string> mExtdata;
     std::vector<std::u16string> mFullExtdataPaths;
+    bool mDirectoriesLoaded;
     u64 mId;
     FS_MediaType mMedia;
     FS_CardType mCard;
@@ -32,10 +32,9 @@
 #include "configuration.hpp"
 #include "gui.hpp"
 #include "logger.hpp"
+#include "textlayout.hpp"
 #include <3ds.h>
 #include <citro2d.h>
-#include <map>
-#include <queue>
 #include <sys/stat.h>
 
 extern "C" {
@@ -48,7 +47,6 @@ Result servicesInit(void);
 namespace StringUtils {
     std::u16string removeForbiddenCharacters(std::u16string src);
     std::u16string UTF8toUTF16(const char* src);
-    std::string splitWord(const std::string& text, float scaleX, float maxWidth);
     float textWidth(const std::string& text, float scaleX);
     float textWidth(const C2D_Text& text, float scaleX);
     std::string wrap(const std::string& text, float scaleX, float maxWidth);
@@ -57,8 +57,7 @@ CheatManagerOverlay::CheatManagerOverlay(Screen& screen, const std::string& mkey
         i++;
     }
 
-    staticBuf  = C2D_TextBufNew(48);
-    dynamicBuf = C2D_TextBufNew(16);
+    staticBuf = C2D_TextBufNew(48);
     C2D_TextParse(&multiSelectText, staticBuf, "\uE003 to select all cheats");
     C2D_TextParse(&multiDeselectText, staticBuf, "\uE003 to deselect all cheats");
     C2D_TextOptimize(&multiSelectText);
@@ -68,17 +67,12 @@ CheatManagerOverlay::CheatManagerOverlay(Screen& screen, const std::string& mkey
 CheatManagerOverlay::~CheatManagerOverlay(void)
 {
     C2D_TextBufDelete(staticBuf);
-    C2D_TextBufDelete(dynamicBuf);
 }
 
 void CheatManagerOverlay::drawTop(void) const
 {
-    C2D_TextBufClear(dynamicBuf);
-
     C2D_DrawRectSolid(0, 0, 0.5f, 400, 240, COLOR_OVERLAY);
-    C2D_Text page;
-    C2D_TextParse(&page, dynamicBuf, StringUtils::format("%d/%d", scrollable->index() + 1, scrollable->size()).c_str());
-    C2D_TextOptimize(&page);
+    const C2D_Text& page = Gui::text(StringUtils::format("%d/%d", scrollable->index() + 1, scrollable->size()));
     C2D_DrawRectSolid(0, 0, 0.5f, 400, 240, COLOR_GREY_DARK);
     scrollable->draw(true);
     C2D_DrawText(&page, C2D_WithColor, ceilf(396 - page.width * scale), 224, 0.5f, scale, scale, COLOR_WHITE);
@@ -101,7 +95,7 @@ void CheatManagerOverlay::update(touchPosition* touch)
         else {
             cellName = SELECTED_MAGIC + cellName;
         }
-        scrollable->c2dText(scrollable->index(), cellName);
+        scrollable->cellName(scrollable->index(), cellName);
     }
 
     if (hidKeysDown() & KEY_Y) {
@@ -110,7 +104,7 @@ void CheatManagerOverlay::update(touchPosition* touch)
                 std::string cellName = scrollable->cellName(j);
                 if (cellName.compare(0, MAGIC_LEN, SELECTED_MAGIC) == 0) {
                     cellName = cellName.substr(strlen(SELECTED_MAGIC), cellName.length());
-                    scrollable->c2dText(j, cellName);
+                    scrollable->cellName(j, cellName);
                 }
             }
             multiSelected = false;
@@ -120,7 +114,7 @@ void CheatManagerOverlay::update(touchPosition* touch)
                 std::string cellName = scrollable->cellName(j);
                 if (cellName.compare(0, MAGIC_LEN, SELECTED_MAGIC) != 0) {
                     cellName = SELECTED_MAGIC + cellName;
-                    scrollable->c2dText(j, cellName);
+                    scrollable->cellName(j, cellName);
                 }
             }
             multiSelected = true;
@@ -33,8 +33,7 @@ MainScreen::MainScreen(void) : hid(rowlen * collen, collen)
     selectionTimer = 0;
     refreshTimer   = 0;
 
-    staticBuf  = C2D_TextBufNew(256);
-    dynamicBuf = C2D_TextBufNew(256);
+    staticBuf = C2D_TextBufNew(256);
 
     buttonBackup    = std::make_unique<Clickable>(204, 102, 110, 35, COLOR_GREY_DARKER, COLOR_WHITE, "Backup \uE004", true);
     buttonRestore   = std::make_unique<Clickable>(204, 139, 110, 35, COLOR_GREY_DARKER, COLOR_WHITE, "Restore \uE005", true);
@@ -89,7 +88,6 @@ MainScreen::MainScreen(void) : hid(rowlen * collen, collen)
 
 MainScreen::~MainScreen(void)
 {
-    C2D_TextBufDelete(dynamicBuf);
     C2D_TextBufDelete(staticBuf);
 }
 
@@ -106,9 +104,7 @@ void MainScreen::drawTop(void) const
     C2D_DrawRectSolid(0, 0, 0.5f, 400, 19, COLOR_GREY_DARK);
     C2D_DrawRectSolid(0, 221, 0.5f, 400, 19, COLOR_GREY_DARK);
 
-    C2D_Text timeText;
-    C2D_TextParse(&timeText, dynamicBuf, DateTime::timeStr().c_str());
-    C2D_TextOptimize(&timeText);
+    const C2D_Text& timeText = Gui::text(DateTime::timeStr());
     C2D_DrawText(&timeText, C2D_WithColor, 4.0f, 3.0f, 0.5f, 0.45f, 0.45f, COLOR_GREY_LIGHT);
 
     for (size_t k = hid.page() * entries; k < hid.page() * entries + max; k++) {
@@ -169,9 +165,7 @@ void MainScreen::drawTop(void) const
         C2D_DrawRectSolid(0, 0, 0.5f, 400, 240, COLOR_OVERLAY);
 
         float size = 0.7f;
-        C2D_Text text;
-        C2D_TextParse(&text, dynamicBuf, StringUtils::UTF16toUTF8(g_currentFile).c_str());
-        C2D_TextOptimize(&text);
+        const C2D_Text& text = Gui::text(StringUtils::UTF16toUTF8(g_currentFile));
         C2D_DrawText(&text, C2D_WithColor, ceilf((400 - StringUtils::textWidth(text, size)) / 2),
             ceilf((240 - size * fontGetInfo(NULL)->lineFeed) / 2), 0.9f, size, size, COLOR_WHITE);
     }
@@ -179,8 +173,6 @@ void MainScreen::drawTop(void) const
 
 void MainScreen::drawBottom(void) const
 {
-    C2D_TextBufClear(dynamicBuf);
-
     const Mode_t mode = Archive::mode();
 
     C2D_DrawRectSolid(0, 0, 0.5f, 320, 19, COLOR_GREY_DARK);
@@ -189,28 +181,25 @@ void MainScreen::drawBottom(void) const
         Title title;
         getTitle(title, hid.fullIndex());
 
-        directoryList->flush();
         std::vector<std::u16string> dirs = mode == MODE_SAVE ? title.saves() : title.extdata();
         static std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t> convert;
 
+        std::vector<std::string> names;
         for (size_t i = 0; i < dirs.size(); i++) {
-            directoryList->push_back(COLOR_GREY_DARKER, COLOR_WHITE, convert.to_bytes(dirs.at(i)), i == directoryList->index());
+            names.push_back(convert.to_bytes(dirs.at(i)));
+        }
+        directoryList->assign(names, COLOR_GREY_DARKER, COLOR_WHITE);
+        for (size_t i = 0; i < directoryList->size(); i++) {
+            directoryList->selectRow(i, i == directoryList->index());
         }
-
-        C2D_Text shortDesc, longDesc, id, prodCode, media;
 
         char lowid[18];
         snprintf(lowid, 9, "%08X", (int)title.lowId());
 
-        C2D_TextParse(&shortDesc, dynamicBuf, title.shortDescription().c_str());
-        C2D_TextParse(&longDesc, dynamicBuf, title.longDescription().c_str());
-        C2D_TextParse(&id, dynamicBuf, lowid);
-        C2D_TextParse(&media, dynamicBuf, title.mediaTypeString().c_str());
-
-        C2D_TextOptimize(&shortDesc);
-        C2D_TextOptimize(&longDesc);
-        C2D_TextOptimize(&id);
-        C2D_TextOptimize(&media);
+        const C2D_Text& shortDesc = Gui::text(title.shortDescription());
+        const C2D_Text& longDesc  = Gui::text(title.longDescription());
+        const C2D_Text& id        = Gui::text(lowid);
+        const C2D_Text& media     = Gui::text(title.mediaTypeString());
 
         float longDescHeight, lowidWidth;
         C2D_TextGetDimensions(&longDesc, 0.55f, 0.55f, NULL, &longDescHeight);
@@ -223,8 +212,7 @@ void MainScreen::drawBottom(void) const
         C2D_DrawText(&id, C2D_WithColor, 25, 31 + longDescHeight, 0.5f, 0.5f, 0.5f, COLOR_WHITE);
 
         snprintf(lowid, 18, "(%s)", title.productCode);
-        C2D_TextParse(&prodCode, dynamicBuf, lowid);
-        C2D_TextOptimize(&prodCode);
+        const C2D_Text& prodCode = Gui::text(lowid);
         C2D_DrawText(&prodCode, C2D_WithColor, 30 + lowidWidth, 32 + longDescHeight, 0.5f, 0.42f, 0.42f, COLOR_GREY_LIGHT);
         C2D_DrawText(&c2dMediatype, C2D_WithColor, 4, 47 + longDescHeight, 0.5f, 0.5f, 0.5f, COLOR_GREY_LIGHT);
         C2D_DrawText(&media, C2D_WithColor, 75, 47 + longDescHeight, 0.5f, 0.5f, 0.5f, COLOR_WHITE);
@@ -506,7 +494,7 @@ void MainScreen::drawSelector(void) const
     static const int w         = 2;
     const int x                = selectorX(hid.index());
     const int y                = selectorY(hid.index());
-    float highlight_multiplier = fmax(0.0, fabs(fmod(g_timer, 1.0) - 0.5) / 0.5);
+    float highlight_multiplier = Gui::highlightMultiplier();
     u8 r                       = COLOR_SELECTOR & 0xFF;
     u8 g                       = (COLOR_SELECTOR >> 8) & 0xFF;
     u8 b                       = (COLOR_SELECTOR >> 16) & 0xFF;
@@ -26,14 +26,6 @@
 
 #include "clickable.hpp"
 
-void Clickable::c2dText(const std::string& v)
-{
-    text(v);
-    mTextBuf = C2D_TextBufNew(64);
-    C2D_TextParse(&mC2dText, mTextBuf, v.c_str());
-    C2D_TextOptimize(&mC2dText);
-}
-
 bool Clickable::held()
 {
     touchPosition touch;
@@ -67,7 +59,8 @@ void Clickable::draw(float size, u32 overlay)
     const u8 g                = (overlay >> 8) & 0xFF;
     const u8 b                = (overlay >> 16) & 0xFF;
     const float messageHeight = ceilf(size * fontGetInfo(NULL)->lineFeed);
-    const float messageWidth  = mCentered ? mC2dText.width * size : mw - 8;
+    const C2D_Text& c2dText   = Gui::text(mText);
+    const float messageWidth  = mCentered ? c2dText.width * size : mw - 8;
 
     C2D_DrawRectSolid(mx, my, 0.5f, mw, mh, mColorBg);
     if (mCanChangeColorWhenSelected && held()) {
@@ -80,7 +73,7 @@ void Clickable::draw(float size, u32 overlay)
         C2D_DrawRectSolid(mx, my, 0.5f, mw, mh, C2D_Color32(r, g, b, 100));
     }
     int offset = ceilf(mx + (mw - messageWidth) / 2) + (!mCentered ? 8 : 0);
-    C2D_DrawText(&mC2dText, C2D_WithColor, offset, ceilf(my + (mh - messageHeight) / 2), 0.5f, size, size, mColorText);
+    C2D_DrawText(&c2dText, C2D_WithColor, offset, ceilf(my + (mh - messageHeight) / 2), 0.5f, size, size, mColorText);
 }
 
 void Clickable::drawOutline(u32 color)
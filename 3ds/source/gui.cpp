@@ -25,6 +25,36 @@
  */
 
 #include "gui.hpp"
+#include <algorithm>
+#include <list>
+#include <unordered_map>
+
+#define TEXT_CACHE_GLYPHS 4096
+
+struct CachedText {
+    std::string key;
+    C2D_TextBuf buf;
+    C2D_Text text;
+    size_t glyphs;
+    u32 frame;
+};
+
+// parsed and optimized texts keyed by content, most recently drawn first: the least
+// recently drawn ones are released once their glyphs don't fit in the budget anymore
+static std::list<CachedText> textCache;
+static std::unordered_map<std::string, std::list<CachedText>::iterator> textCacheIndex;
+static size_t textCacheGlyphs = 0;
+static u32 textCacheHits      = 0;
+static u32 textCacheMisses    = 0;
+static u32 textFrame          = 0;
+
+static void releaseText(void)
+{
+    C2D_TextBufDelete(textCache.back().buf);
+    textCacheGlyphs -= textCache.back().glyphs;
+    textCacheIndex.erase(textCache.back().key);
+    textCache.pop_back();
+}
 
 C2D_Image Gui::noIcon(void)
 {
@@ -51,6 +81,9 @@ void Gui::init(void)
 
 void Gui::exit(void)
 {
+    while (!textCache.empty()) {
+        releaseText();
+    }
     C2D_SpriteSheetFree(spritesheet);
     C2D_Fini();
     C3D_Fini();
@@ -61,6 +94,86 @@ void Gui::frameEnd(void)
 {
     C3D_FrameEnd(0);
     g_timer += 0.025f;
+    textFrame++;
+}
+
+const C2D_Text& Gui::text(const std::string& str)
+{
+    auto it = textCacheIndex.find(str);
+    if (it != textCacheIndex.end()) {
+        textCache.splice(textCache.begin(), textCache, it->second);
+        it->second->frame = textFrame;
+        textCacheHits++;
+        return it->second->text;
+    }
+    textCacheMisses++;
+
+    // a text handed out during this frame may still be waiting to be drawn, the budget
+    // can only be exceeded by the texts of a single frame
+    const size_t glyphs = std::max(str.length(), (size_t)1);
+    while (!textCache.empty() && textCacheGlyphs + glyphs > TEXT_CACHE_GLYPHS && textCache.back().frame != textFrame) {
+        releaseText();
+    }
+
+    textCache.push_front({str, C2D_TextBufNew(glyphs), {}, glyphs, textFrame});
+    CachedText& entry = textCache.front();
+    C2D_TextParse(&entry.text, entry.buf, str.c_str());
+    C2D_TextOptimize(&entry.text);
+    textCacheGlyphs += glyphs;
+    textCacheIndex.emplace(str, textCache.begin());
+    return entry.text;
+}
+
+float Gui::textCacheHitRate(void)
+{
+    return textCacheHits + textCacheMisses == 0 ? 0 : (float)textCacheHits / (textCacheHits + textCacheMisses);
+}
+
+float Gui::highlightMultiplier(void)
+{
+    // the pulse stops once the app is idle, so that the frame doesn't need to be redrawn
+    FrameScheduler::getInstance().animate();
+    return FrameScheduler::getInstance().idle() ? 0 : fmax(0.0, fabs(fmod(g_timer, 1.0) - 0.5) / 0.5);
+}
+
+void Gui::drawProfiler(void)
+{
+    static C2D_TextBuf buf     = C2D_TextBufNew(512);
+    static const char* columns = "last   min    avg    p99";
+    const float x = 180, y = 24, w = 212, rowh = 12, graphh = 40;
+
+    const auto report = Profiler::getInstance().report();
+    const auto frames = Profiler::getInstance().history("frame");
+    const float h     = rowh * (report.size() + 2) + graphh + 16;
+
+    C2D_TextBufClear(buf);
+    C2D_DrawRectSolid(x, y, 0.5f, w, h, COLOR_OVERLAY);
+
+    C2D_Text text;
+    C2D_TextParse(&text, buf, columns);
+    C2D_TextOptimize(&text);
+    C2D_DrawText(&text, C2D_WithColor, x + 64, y + 2, 0.5f, 0.4f, 0.4f, COLOR_GOLD);
+    for (size_t i = 0; i < report.size(); i++) {
+        const float rowy         = y + 2 + rowh * (i + 1);
+        const Profiler::Stats& s = report[i].second;
+        C2D_TextParse(&text, buf, report[i].first.c_str());
+        C2D_TextOptimize(&text);
+        C2D_DrawText(&text, C2D_WithColor, x + 4, rowy, 0.5f, 0.4f, 0.4f, COLOR_WHITE);
+        C2D_TextParse(&text, buf, StringUtils::format("%5.2f %5.2f %5.2f %5.2f", s.last, s.min, s.avg, s.p99).c_str());
+        C2D_TextOptimize(&text);
+        C2D_DrawText(&text, C2D_WithColor, x + 60, rowy, 0.5f, 0.4f, 0.4f, COLOR_WHITE);
+    }
+    C2D_TextParse(&text, buf, StringUtils::format("text cache hits %.1f%%", textCacheHitRate() * 100).c_str());
+    C2D_TextOptimize(&text);
+    C2D_DrawText(&text, C2D_WithColor, x + 4, y + 2 + rowh * (report.size() + 1), 0.5f, 0.4f, 0.4f, COLOR_WHITE);
+
+    // one bar per frame, the full height is two frames at 60 fps
+    const float graphx = x + 16, graphy = y + h - 6;
+    for (size_t i = 0; i < frames.size(); i++) {
+        const float barh = std::min(graphh, frames[i] * graphh / 33.3f);
+        C2D_DrawRectSolid(graphx + 1.5f * i, graphy - barh, 0.5f, 1, barh, frames[i] > 16.7f ? COLOR_RED : COLOR_WHITE);
+    }
+    C2D_DrawRectSolid(graphx, graphy - graphh / 2, 0.5f, 1.5f * Profiler::HISTORY_SIZE, 1, COLOR_WHITEMASK);
 }
 
 void Gui::drawPulsingOutline(u32 x, u32 y, u16 w, u16 h, u8 size, u32 color)
@@ -68,7 +181,7 @@ void Gui::drawPulsingOutline(u32 x, u32 y, u16 w, u16 h, u8 size, u32 color)
     u8 r                       = color & 0xFF;
     u8 g                       = (color >> 8) & 0xFF;
     u8 b                       = (color >> 16) & 0xFF;
-    float highlight_multiplier = fmax(0.0, fabs(fmod(g_timer, 1.0) - 0.5) / 0.5);
+    float highlight_multiplier = highlightMultiplier();
     color = C2D_Color32(r + (255 - r) * highlight_multiplier, g + (255 - g) * highlight_multiplier, b + (255 - b) * highlight_multiplier, 255);
     drawOutline(x, y, w, h, size, color);
 }
@@ -26,6 +26,8 @@
 
 #include "main.hpp"
 #include "MainScreen.hpp"
+#include "framescheduler.hpp"
+#include "profiler.hpp"
 #include "thread.hpp"
 #include "util.hpp"
 
@@ -41,10 +43,20 @@ int main()
     Threads::create((ThreadFunc)Threads::titles);
     ATEXIT(Threads::destroy);
 
+    FrameScheduler& scheduler = FrameScheduler::getInstance();
+    Profiler& profiler        = Profiler::getInstance();
+    const auto frameStage     = profiler.stage("frame");
     while (aptMainLoop()) {
         touchPosition touch;
-        hidScanInput();
-        hidTouchRead(&touch);
+        {
+            ProfileScope scope("input");
+            hidScanInput();
+            hidTouchRead(&touch);
+        }
+
+        if ((hidKeysHeld() & KEY_SELECT) && (hidKeysDown() & KEY_DOWN)) {
+            profiler.toggle();
+        }
 
         if (hidKeysDown() & KEY_START) {
             if (!g_isLoadingTitles) {
@@ -56,12 +68,42 @@ int main()
         //     updateCard();
         // }
 
-        C3D_FrameBegin(C3D_FRAME_SYNCDRAW);
-        g_screen->doDrawTop();
-        C2D_SceneBegin(g_bottom);
-        g_screen->doDrawBottom();
-        Gui::frameEnd();
-        g_screen->doUpdate(&touch);
+        if (hidKeysDown() || hidKeysHeld() || hidKeysUp() || g_isLoadingTitles) {
+            scheduler.invalidate();
+        }
+
+        if (scheduler.beginFrame(osGetTime())) {
+            const u64 frameStart = Profiler::now();
+            {
+                // waits for the previous frame to be done on the GPU
+                ProfileScope scope("present");
+                C3D_FrameBegin(C3D_FRAME_SYNCDRAW);
+            }
+            {
+                ProfileScope scope("draw");
+                g_screen->doDrawTop();
+                if (profiler.visible()) {
+                    Gui::drawProfiler();
+                }
+                C2D_SceneBegin(g_bottom);
+                g_screen->doDrawBottom();
+            }
+            {
+                ProfileScope scope("present");
+                Gui::frameEnd();
+            }
+            profiler.add(frameStage, Profiler::now() - frameStart);
+            profiler.endFrame();
+            scheduler.endFrame(osGetTime());
+        }
+        else {
+            svcSleepThread(scheduler.sleepTime() * 1000000ULL);
+        }
+
+        {
+            ProfileScope scope("input");
+            g_screen->doUpdate(&touch);
+        }
     }
 
     Logger::getInstance().flush();
@@ -92,6 +92,7 @@ void Title::load(void)
     mAccessibleExtdata = false;
     mSaves.clear();
     mExtdata.clear();
+    mDirectoriesLoaded = false;
 }
 
 void Title::load(u64 id, u8* _productCode, bool accessibleSave, bool accessibleExtdata, std::u16string shortDescription,
@@ -107,6 +108,7 @@ void Title::load(u64 id, u8* _productCode, bool accessibleSave, bool accessibleE
     mMedia             = media;
     mCard              = cardType;
     mCardType          = card;
+    mDirectoriesLoaded = false;
 
     memcpy(productCode, _productCode, 16);
 }
@@ -221,7 +223,8 @@ bool Title::load(u64 _id, FS_MediaType _media, FS_CardType _card)
         }
     }
 
-    refreshDirectories();
+    // backup lists are built lazily, the first time the title gets focused
+    mDirectoriesLoaded = false;
     return loadTitle;
 }
 
@@ -381,6 +384,18 @@ void Title::refreshDirectories(void)
             }
         }
     }
+
+    mDirectoriesLoaded = true;
+}
+
+void Title::invalidateDirectories(void)
+{
+    mDirectoriesLoaded = false;
+}
+
+bool Title::directoriesOutdated(void)
+{
+    return !mDirectoriesLoaded;
 }
 
 u32 Title::highId(void)
@@ -489,8 +504,32 @@ static bool validId(u64 id)
     return !Configuration::getInstance().filter(id);
 }
 
+static void sortTitles(std::vector<Title>& list)
+{
+    // compute the sort keys once per title instead of twice per comparison
+    std::vector<std::pair<bool, std::string>> keys;
+    keys.reserve(list.size());
+    for (auto& title : list) {
+        std::string name = title.shortDescription();
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        keys.push_back(std::make_pair(!Configuration::getInstance().favorite(title.id()), name));
+    }
+
+    std::vector<size_t> order(list.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&keys](size_t l, size_t r) { return keys.at(l) < keys.at(r); });
+
+    std::vector<Title> sorted;
+    sorted.reserve(list.size());
+    for (size_t i : order) {
+        sorted.push_back(list.at(i));
+    }
+    list.swap(sorted);
+}
+
 void loadTitles(bool forceRefresh)
 {
+    ProfileScope scope("titles");
     static const std::u16string savecachePath    = StringUtils::UTF8toUTF16("/3ds/Checkpoint/fullsavecache");
     static const std::u16string extdatacachePath = StringUtils::UTF8toUTF16("/3ds/Checkpoint/fullextdatacache");
 
@@ -537,12 +576,6 @@ void loadTitles(bool forceRefresh)
     if (optimizedLoad && !forceRefresh) {
         // deserialize data
         importTitleListCache();
-        for (auto& title : titleSaves) {
-            title.refreshDirectories();
-        }
-        for (auto& title : titleExtdatas) {
-            title.refreshDirectories();
-        }
     }
     else {
         u32 count = 0;
@@ -603,23 +636,8 @@ void loadTitles(bool forceRefresh)
         }
     }
 
-    std::sort(titleSaves.begin(), titleSaves.end(), [](Title& l, Title& r) {
-        if (Configuration::getInstance().favorite(l.id()) != Configuration::getInstance().favorite(r.id())) {
-            return Configuration::getInstance().favorite(l.id());
-        }
-        else {
-            return l.shortDescription() < r.shortDescription();
-        }
-    });
-
-    std::sort(titleExtdatas.begin(), titleExtdatas.end(), [](Title& l, Title& r) {
-        if (Configuration::getInstance().favorite(l.id()) != Configuration::getInstance().favorite(r.id())) {
-            return Configuration::getInstance().favorite(l.id());
-        }
-        else {
-            return l.shortDescription() < r.shortDescription();
-        }
-    });
+    sortTitles(titleSaves);
+    sortTitles(titleExtdatas);
 
     // serialize data
     exportTitleListCache(titleSaves, savecachePath);
@@ -661,7 +679,11 @@ void getTitle(Title& dst, int i)
 {
     const Mode_t mode = Archive::mode();
     if (i < getTitleCount()) {
-        dst = mode == MODE_SAVE ? titleSaves.at(i) : titleExtdatas.at(i);
+        Title& title = mode == MODE_SAVE ? titleSaves.at(i) : titleExtdatas.at(i);
+        if (title.directoriesOutdated()) {
+            title.refreshDirectories();
+        }
+        dst = title;
     }
 }
 
@@ -714,19 +736,15 @@ static C2D_Image loadTextureIcon(smdh_s* smdh)
 
 void refreshDirectories(u64 id)
 {
-    const Mode_t mode = Archive::mode();
-    if (mode == MODE_SAVE) {
-        for (size_t i = 0; i < titleSaves.size(); i++) {
-            if (titleSaves.at(i).id() == id) {
-                titleSaves.at(i).refreshDirectories();
-            }
+    // the same title may be listed in both modes, drop both cached lists
+    for (size_t i = 0; i < titleSaves.size(); i++) {
+        if (titleSaves.at(i).id() == id) {
+            titleSaves.at(i).invalidateDirectories();
         }
     }
-    else {
-        for (size_t i = 0; i < titleExtdatas.size(); i++) {
-            if (titleExtdatas.at(i).id() == id) {
-                titleExtdatas.at(i).refreshDirectories();
-            }
+    for (size_t i = 0; i < titleExtdatas.size(); i++) {
+        if (titleExtdatas.at(i).id() == id) {
+            titleExtdatas.at(i).invalidateDirectories();
         }
     }
 }
@@ -137,99 +137,16 @@ std::u16string StringUtils::removeForbiddenCharacters(std::u16string src)
     return src;
 }
 
-static std::map<u16, charWidthInfo_s*> widthCache;
-static std::queue<u16> widthCacheOrder;
-
-std::string StringUtils::splitWord(const std::string& text, float scaleX, float maxWidth)
+static float systemCharWidth(uint32_t codepoint)
 {
-    std::string word = text;
-    if (StringUtils::textWidth(word, scaleX) > maxWidth) {
-        float currentWidth = 0.0f;
-        for (size_t i = 0; i < word.size(); i++) {
-            u16 codepoint = 0xFFFF;
-            int iMod      = 0;
-            if (word[i] & 0x80 && word[i] & 0x40 && word[i] & 0x20 && !(word[i] & 0x10) && i + 2 < word.size()) {
-                codepoint = word[i] & 0x0F;
-                codepoint = codepoint << 6 | (word[i + 1] & 0x3F);
-                codepoint = codepoint << 6 | (word[i + 2] & 0x3F);
-                iMod      = 2;
-            }
-            else if (word[i] & 0x80 && word[i] & 0x40 && !(word[i] & 0x20) && i + 1 < word.size()) {
-                codepoint = word[i] & 0x1F;
-                codepoint = codepoint << 6 | (word[i + 1] & 0x3F);
-                iMod      = 1;
-            }
-            else if (!(word[i] & 0x80)) {
-                codepoint = word[i];
-            }
-            float charWidth;
-            auto width = widthCache.find(codepoint);
-            if (width != widthCache.end()) {
-                charWidth = width->second->charWidth * scaleX;
-            }
-            else {
-                widthCache.insert_or_assign(codepoint, fontGetCharWidthInfo(NULL, fontGlyphIndexFromCodePoint(NULL, codepoint)));
-                widthCacheOrder.push(codepoint);
-                if (widthCache.size() > 512) {
-                    widthCache.erase(widthCacheOrder.front());
-                    widthCacheOrder.pop();
-                }
-                charWidth = widthCache[codepoint]->charWidth * scaleX;
-            }
-            currentWidth += charWidth;
-            if (currentWidth > maxWidth) {
-                word.insert(i, 1, '\n');
-                currentWidth = charWidth;
-            }
-
-            i += iMod; // Yay, variable width encodings
-        }
-    }
-    return word;
+    return fontGetCharWidthInfo(NULL, fontGlyphIndexFromCodePoint(NULL, codepoint))->charWidth;
 }
 
+static TextMetrics metrics(systemCharWidth);
+
 float StringUtils::textWidth(const std::string& text, float scaleX)
 {
-    float ret        = 0.0f;
-    float largestRet = 0.0f;
-    for (size_t i = 0; i < text.size(); i++) {
-        if (text[i] == '\n') {
-            largestRet = std::max(largestRet, ret);
-            ret        = 0.0f;
-            continue;
-        }
-        u16 codepoint = 0xFFFF;
-        if (text[i] & 0x80 && text[i] & 0x40 && text[i] & 0x20 && !(text[i] & 0x10) && i + 2 < text.size()) {
-            codepoint = text[i] & 0x0F;
-            codepoint = codepoint << 6 | (text[i + 1] & 0x3F);
-            codepoint = codepoint << 6 | (text[i + 2] & 0x3F);
-            i += 2;
-        }
-        else if (text[i] & 0x80 && text[i] & 0x40 && !(text[i] & 0x20) && i + 1 < text.size()) {
-            codepoint = text[i] & 0x1F;
-            codepoint = codepoint << 6 | (text[i + 1] & 0x3F);
-            i += 1;
-        }
-        else if (!(text[i] & 0x80)) {
-            codepoint = text[i];
-        }
-        float charWidth;
-        auto width = widthCache.find(codepoint);
-        if (width != widthCache.end()) {
-            charWidth = width->second->charWidth * scaleX;
-        }
-        else {
-            widthCache.insert_or_assign(codepoint, fontGetCharWidthInfo(NULL, fontGlyphIndexFromCodePoint(NULL, codepoint)));
-            widthCacheOrder.push(codepoint);
-            if (widthCache.size() > 1000) {
-                widthCache.erase(widthCacheOrder.front());
-                widthCacheOrder.pop();
-            }
-            charWidth = widthCache[codepoint]->charWidth * scaleX;
-        }
-        ret += charWidth;
-    }
-    return std::max(largestRet, ret);
+    return metrics.width(text, scaleX);
 }
 
 float StringUtils::textWidth(const C2D_Text& text, float scaleX)
@@ -239,59 +156,7 @@ float StringUtils::textWidth(const C2D_Text& text, float scaleX)
 
 std::string StringUtils::wrap(const std::string& text, float scaleX, float maxWidth)
 {
-    if (textWidth(text, scaleX) <= maxWidth) {
-        return text;
-    }
-    std::string dst, line, word;
-    dst = line = word = "";
-
-    for (std::string::const_iterator it = text.begin(); it != text.end(); ++it) {
-        word += *it;
-        if (*it == ' ') {
-            // split single words that are bigger than maxWidth
-            if (StringUtils::textWidth(line + word, scaleX) <= maxWidth) {
-                line += word;
-            }
-            else {
-                if (StringUtils::textWidth(word, scaleX) > maxWidth) {
-                    line += word;
-                    line = StringUtils::splitWord(line, scaleX, maxWidth);
-                    word = line.substr(line.find('\n') + 1, std::string::npos);
-                    line = line.substr(0, line.find('\n')); // Split line on first newLine; assign second part to word and first to line
-                }
-                if (line[line.size() - 1] == ' ') {
-                    dst += line.substr(0, line.size() - 1) + '\n';
-                }
-                else {
-                    dst += line + '\n';
-                }
-                line = word;
-            }
-            word = "";
-        }
-    }
-
-    // "Another iteration" of the loop b/c it probably won't end with a space
-    // If it does, no harm done
-    // word = StringUtils::splitWord(word, scaleX, maxWidth);
-    if (StringUtils::textWidth(line + word, scaleX) <= maxWidth) {
-        dst += line + word;
-    }
-    else {
-        if (StringUtils::textWidth(word, scaleX) > maxWidth) {
-            line += word;
-            line = StringUtils::splitWord(line, scaleX, maxWidth);
-            word = line.substr(line.find('\n') + 1, std::string::npos);
-            line = line.substr(0, line.find('\n'));
-        }
-        if (line[line.size() - 1] == ' ') {
-            dst += line.substr(0, line.size() - 1) + '\n' + word;
-        }
-        else {
-            dst += line + '\n' + word;
-        }
-    }
-    return dst;
+    return TextLayout::join(text, TextLayout::wrap(text, maxWidth, metrics, scaleX));
 }
 
 float StringUtils::textHeight(const std::string& text, float scaleY)
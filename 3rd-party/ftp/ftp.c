@@ -14,6 +14,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/socket.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
 #include <sys/stat.h>
 #include <sys/statvfs.h>
 #include <time.h>
@@ -27,12 +30,16 @@
 #define POLL_UNKNOWN    (~(POLLIN|POLLPRI|POLLOUT))
 #define XFER_BUFFERSIZE 65536
 #define SOCK_BUFFERSIZE 65536
-#define FILE_BUFFERSIZE 1048576
+#define RING_BUFFERSIZE 1048576 /* must be a power of two */
 #define CMD_BUFFERSIZE  4096
 #define LISTEN_PORT     50000
 #define DATA_PORT       0 /* ephemeral port */
+#define LISTING_CACHE   8 /* directory snapshots kept for MLSD */
+#define LISTING_TTL     10 /* seconds a snapshot is trusted to reflect changes made by others */
+#define LISTING_MAX     1048576 /* larger snapshots are sent but not kept */
 
 typedef struct ftp_session_t ftp_session_t;
+typedef struct ftp_listing_t ftp_listing_t;
 
 #define FTP_DECLARE(x) static void x(ftp_session_t *session, const char *args)
 FTP_DECLARE(ABOR);
@@ -93,6 +100,9 @@ typedef enum {
   SESSION_SEND   = BIT(4), /*!< data transfer in sink mode */
   SESSION_RENAME = BIT(5), /*!< last command was RNFR and buffer contains path */
   SESSION_URGENT = BIT(6), /*!< in telnet urgent mode */
+  SESSION_EOF    = BIT(7), /*!< file or data connection reached its end */
+  SESSION_COPY   = BIT(8), /*!< file can't be sent with sendfile */
+  SESSION_MOUNT  = BIT(9), /*!< the listed directory holds the virtual namespace */
 } session_flags_t;
 
 /*! ftp_xfer_dir mode */
@@ -131,15 +141,36 @@ struct ftp_session_t {
 
   loop_status_t (*transfer)(ftp_session_t*);  /*! data transfer callback */
   char     buffer[XFER_BUFFERSIZE];      /*! persistent data between callbacks */
-  char     file_buffer[FILE_BUFFERSIZE]; /*! stdio file buffer */
+  char     ring[RING_BUFFERSIZE];        /*! file data read ahead of the data socket, or received ahead of the file */
   char     cmd_buffer[CMD_BUFFERSIZE];   /*! command buffer */
   size_t   bufferpos;                    /*! persistent buffer position between callbacks */
   size_t   buffersize;                   /*! persistent buffer size between callbacks */
   size_t   cmd_buffersize;
+  size_t   ring_head;                    /*! bytes put into the ring buffer */
+  size_t   ring_tail;                    /*! bytes taken out of the ring buffer */
   uint64_t filepos;                      /*! persistent file position between callbacks */
   uint64_t filesize;                     /*! persistent file size between callbacks */
-  FILE     *fp;                          /*! persistent open file pointer between callbacks */
+  uint64_t xfer_start;                   /*! when the open file transfer started, 0 without one */
+  uint64_t restpos;                      /*! offset set by REST for the next file transfer */
+  int      fd;                           /*! persistent open file descriptor between callbacks */
   DIR      *dp;                          /*! persistent open directory pointer between callbacks */
+  void     *vfile;                       /*! open file of the virtual namespace */
+  void     *vdir;                        /*! open directory of the virtual namespace */
+  ftp_listing_t *listing;                /*! MLSD snapshot being sent */
+  size_t   listingpos;                   /*! bytes of the snapshot sent */
+};
+
+/*! MLSD listing of a directory, shared by the cache and the sessions sending it */
+struct ftp_listing_t {
+  char                 path[4096]; /*!< listed directory */
+  session_mlst_flags_t flags;      /*!< MLST facts it was built with */
+  time_t               mtime;      /*!< directory mtime when built */
+  time_t               created;    /*!< when it was built */
+  uint32_t             generation; /*!< listing_generation when built */
+  int                  refs;       /*!< references from the cache and sessions */
+  char                 *data;      /*!< the listing */
+  size_t               size;       /*!< listing length */
+  size_t               capacity;   /*!< allocated size of data */
 };
 
 /*! ftp command descriptor */
@@ -225,6 +256,95 @@ static ftp_session_t      *sessions = NULL;
 static int                sock_buffersize = SOCK_BUFFERSIZE;
 /*! server start time */
 static time_t             start_time = 0;
+/*! transfer counters */
+static ftp_stats_t        stats;
+/*! MLSD snapshots of recently listed directories */
+static ftp_listing_t      *listings[LISTING_CACHE];
+/*! changes whenever the server modifies the file system */
+static uint32_t           listing_generation = 0;
+/*! read-only namespace mounted over the file system */
+static const ftp_vfs_t    *vfs = NULL;
+
+/*! check whether a path belongs to the virtual namespace
+ *
+ *  @param[in] path absolute path
+ *
+ *  @returns whether it is the mount point or below it
+ */
+static bool ftp_vfs_owns(const char *path) {
+  size_t len;
+
+  if(vfs == NULL)
+    return false;
+
+  len = strlen(vfs->root);
+  return strncmp(path, vfs->root, len) == 0
+      && (path[len] == 0 || path[len] == '/');
+}
+
+/*! get the name of the mount point within a directory
+ *
+ *  @param[in] path absolute path of the directory
+ *
+ *  @returns mount point name, NULL if the directory doesn't hold it
+ */
+static const char* ftp_vfs_entry(const char *path) {
+  const char *name;
+  size_t     len;
+
+  if(vfs == NULL)
+    return NULL;
+
+  name = strrchr(vfs->root, '/');
+  len  = name - vfs->root;
+
+  /* a mount point like /checkpoint is held by the root directory */
+  if(len == 0)
+    return strcmp(path, "/") == 0 ? name + 1 : NULL;
+
+  if(strncmp(path, vfs->root, len) == 0 && path[len] == 0)
+    return name + 1;
+
+  return NULL;
+}
+
+/*! stat a path of the file system or the virtual namespace
+ *
+ *  @param[in]  path path to stat
+ *  @param[out] st   stat data
+ *
+ *  @returns -1 for error
+ */
+static int ftp_stat(const char *path, struct stat *st) {
+  if(ftp_vfs_owns(path))
+    return vfs->stat(path, st);
+
+  return stat(path, st);
+}
+
+/*! lstat a path of the file system or the virtual namespace
+ *
+ *  @param[in]  path path to lstat
+ *  @param[out] st   stat data
+ *
+ *  @returns -1 for error
+ */
+static int ftp_lstat(const char *path, struct stat *st) {
+  if(ftp_vfs_owns(path))
+    return vfs->stat(path, st);
+
+  return lstat(path, st);
+}
+
+/*! get monotonic time
+ *
+ *  @returns microseconds
+ */
+static uint64_t ftp_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
 
 /*! Allocate a new data port
  *
@@ -368,13 +488,64 @@ static void ftp_session_close_data(ftp_session_t *session) {
  *  @param[in] session ftp session
  */
 static void ftp_session_close_file(ftp_session_t *session) {
-  if(session->fp != NULL)
+  if(session->fd >= 0)
+  {
+    close(session->fd);
+  }
+
+  if(session->vfile != NULL)
+  {
+    vfs->close(session->vfile);
+    session->vfile = NULL;
+  }
+
+  if(session->xfer_start != 0)
   {
-    fclose(session->fp);
+    stats.transfers++;
+    stats.transfer_usec += ftp_now() - session->xfer_start;
+    session->xfer_start = 0;
   }
 
-  session->fp      = NULL;
-  session->filepos = 0;
+  session->fd        = -1;
+  session->filepos   = 0;
+  session->ring_head = 0;
+  session->ring_tail = 0;
+}
+
+/*! get the contiguous free space of the ring buffer
+ *
+ *  @param[in]  session ftp session
+ *  @param[out] p       start of the free space
+ *
+ *  @returns free bytes at p
+ */
+static size_t ftp_session_ring_space(ftp_session_t *session, char **p) {
+  size_t off = session->ring_head & (RING_BUFFERSIZE - 1);
+  size_t len = RING_BUFFERSIZE - (session->ring_head - session->ring_tail);
+
+  if(len > RING_BUFFERSIZE - off)
+    len = RING_BUFFERSIZE - off;
+
+  *p = session->ring + off;
+  return len;
+}
+
+/*! get the contiguous data of the ring buffer
+ *
+ *  @param[in]  session ftp session
+ *  @param[out] p       start of the data
+ *
+ *  @returns buffered bytes at p
+ */
+static size_t ftp_session_ring_data(ftp_session_t *session, char **p) {
+  size_t off = session->ring_tail & (RING_BUFFERSIZE - 1);
+  size_t len = session->ring_head - session->ring_tail;
+
+  if(len > RING_BUFFERSIZE - off)
+    len = RING_BUFFERSIZE - off;
+
+  *p = session->ring + off;
+  return len;
 }
 
 /*! open file for reading for ftp session
@@ -387,19 +558,49 @@ static int ftp_session_open_file_read(ftp_session_t *session) {
   int         rc;
   struct stat st;
 
+  if(ftp_vfs_owns(session->buffer))
+  {
+    /* files of the virtual namespace are generated as they are read */
+    if(vfs->stat(session->buffer, &st) != 0)
+      return -1;
+    if(!S_ISREG(st.st_mode))
+    {
+      errno = EISDIR;
+      return -1;
+    }
+
+    session->vfile = vfs->open(session->buffer);
+    if(session->vfile == NULL)
+    {
+      return -1;
+    }
+    session->filesize = st.st_size;
+
+    /* the restart offset has to be within the file */
+    if(session->filepos > session->filesize)
+    {
+      errno = ERANGE;
+      return -1;
+    }
+
+    if(session->filepos != 0 && vfs->seek(session->vfile, session->filepos) != 0)
+    {
+      errno = EIO;
+      return -1;
+    }
+
+    return 0;
+  }
+
   /* open file in read mode */
-  session->fp = fopen(session->buffer, "rb");
-  if(session->fp == NULL)
+  session->fd = open(session->buffer, O_RDONLY);
+  if(session->fd < 0)
   {
     return -1;
   }
 
-  /* it's okay if this fails */
-  errno = 0;
-  setvbuf(session->fp, session->file_buffer, _IOFBF, FILE_BUFFERSIZE);
-
   /* get the file size */
-  rc = fstat(fileno(session->fp), &st);
+  rc = fstat(session->fd, &st);
   if(rc != 0)
   {
     return -1;
@@ -408,8 +609,14 @@ static int ftp_session_open_file_read(ftp_session_t *session) {
 
   if(session->filepos != 0)
   {
-    rc = fseek(session->fp, session->filepos, SEEK_SET);
-    if(rc != 0)
+    /* the restart offset has to be within the file */
+    if(session->filepos > session->filesize)
+    {
+      errno = ERANGE;
+      return -1;
+    }
+
+    if(lseek(session->fd, session->filepos, SEEK_SET) < 0)
     {
       return -1;
     }
@@ -418,7 +625,7 @@ static int ftp_session_open_file_read(ftp_session_t *session) {
   return 0;
 }
 
-/*! read from an open file for ftp session
+/*! read ahead from an open file into the ring buffer for ftp session
  *
  *  @param[in] session ftp session
  *
@@ -426,16 +633,22 @@ static int ftp_session_open_file_read(ftp_session_t *session) {
  */
 static ssize_t ftp_session_read_file(ftp_session_t *session) {
   ssize_t rc;
+  char    *p;
+  size_t  len = ftp_session_ring_space(session, &p);
 
   /* read file at current position */
-  rc = fread(session->buffer, 1, sizeof(session->buffer), session->fp);
+  if(session->vfile != NULL)
+    rc = vfs->read(session->vfile, p, len);
+  else
+    rc = read(session->fd, p, len);
   if(rc < 0)
   {
     return -1;
   }
 
   /* adjust file position */
-  session->filepos += rc;
+  session->filepos   += rc;
+  session->ring_head += rc;
 
   return rc;
 }
@@ -450,31 +663,50 @@ static ssize_t ftp_session_read_file(ftp_session_t *session) {
  *  @note truncates file
  */
 static int ftp_session_open_file_write(ftp_session_t *session, bool append) {
-  int        rc;
-  const char *mode = "wb";
+  struct stat st;
+  int         flags = O_WRONLY | O_CREAT | O_TRUNC;
 
   if(append)
-    mode = "ab";
+    flags = O_WRONLY | O_CREAT | O_APPEND;
   else if(session->filepos != 0)
-    mode = "r+b";
+    flags = O_WRONLY;
+
+  /* the virtual namespace is read-only */
+  if(ftp_vfs_owns(session->buffer))
+  {
+    errno = EROFS;
+    return -1;
+  }
 
   /* open file in write mode */
-  session->fp = fopen(session->buffer, mode);
-  if(session->fp == NULL)
+  session->fd = open(session->buffer, flags, 0644);
+  if(session->fd < 0)
   {
     return -1;
   }
 
-  /* it's okay if this fails */
-  errno = 0;
-  rc = setvbuf(session->fp, session->file_buffer, _IOFBF, FILE_BUFFERSIZE);
+  ++listing_generation;
+
+  /* whatever is past the end of the upload is cut off once it completes */
+  session->filesize = 0;
 
   /* check if this had REST but not APPE */
   if(session->filepos != 0 && !append)
   {
+    /* the restart offset has to be within the file */
+    if(fstat(session->fd, &st) != 0)
+    {
+      return -1;
+    }
+    session->filesize = st.st_size;
+    if(session->filepos > session->filesize)
+    {
+      errno = ERANGE;
+      return -1;
+    }
+
     /* seek to the REST offset */
-    rc = fseek(session->fp, session->filepos, SEEK_SET);
-    if(rc != 0)
+    if(lseek(session->fd, session->filepos, SEEK_SET) < 0)
     {
       return -1;
     }
@@ -483,28 +715,102 @@ static int ftp_session_open_file_write(ftp_session_t *session, bool append) {
   return 0;
 }
 
-/*! write to an open file for ftp session
+/*! write the ring buffer to an open file for ftp session
  *
  *  @param[in] session ftp session
  *
- *  @returns bytes written
+ *  @returns -1 for error
  */
-static ssize_t ftp_session_write_file(ftp_session_t *session) {
+static int ftp_session_write_file(ftp_session_t *session) {
   ssize_t rc;
+  char    *p;
+  size_t  len;
 
-  /* write to file at current position */
-  rc = fwrite(session->buffer + session->bufferpos,
-              1, session->buffersize - session->bufferpos,
-              session->fp);
-  if(rc < 0)
+  /* the buffered data may wrap around the end of the ring */
+  while((len = ftp_session_ring_data(session, &p)) > 0)
+  {
+    /* write to file at current position */
+    rc = write(session->fd, p, len);
+    if(rc <= 0)
+    {
+      return -1;
+    }
+
+    /* adjust file position */
+    session->filepos   += rc;
+    session->ring_tail += rc;
+    ++listing_generation;
+  }
+
+  return 0;
+}
+
+/*! release a reference to a directory snapshot
+ *
+ *  @param[in] listing snapshot to release
+ */
+static void ftp_listing_release(ftp_listing_t *listing) {
+  if(listing != NULL && --listing->refs == 0)
+  {
+    free(listing->data);
+    free(listing);
+  }
+}
+
+/*! open a directory of the file system or the virtual namespace for ftp session
+ *
+ *  @param[in] session ftp session
+ *  @param[in] path    directory to open
+ *
+ *  @returns -1 for failure
+ */
+static int ftp_session_open_dir(ftp_session_t *session, const char *path) {
+  if(ftp_vfs_owns(path))
+    session->vdir = vfs->opendir(path);
+  else
+    session->dp = opendir(path);
+
+  if(session->dp == NULL && session->vdir == NULL)
   {
     return -1;
   }
 
-  /* adjust file position */
-  session->filepos += rc;
+  /* the mount point is listed along with the entries of the directory holding it */
+  if(ftp_vfs_entry(path) != NULL)
+    session->flags |= SESSION_MOUNT;
+  else
+    session->flags &= ~SESSION_MOUNT;
 
-  return rc;
+  return 0;
+}
+
+/*! read the directory open for ftp session
+ *
+ *  @param[in] session ftp session
+ *  @param[in] path    directory that was opened
+ *
+ *  @returns name of the next entry, NULL at the end
+ */
+static const char* ftp_session_read_dir(ftp_session_t *session, const char *path) {
+  struct dirent *dent;
+
+  if(session->vdir != NULL)
+    return vfs->readdir(session->vdir);
+
+  while((dent = readdir(session->dp)) != NULL)
+  {
+    /* the mount point hides whatever is at its path */
+    if(!(session->flags & SESSION_MOUNT) || strcmp(dent->d_name, ftp_vfs_entry(path)) != 0)
+      return dent->d_name;
+  }
+
+  if(session->flags & SESSION_MOUNT)
+  {
+    session->flags &= ~SESSION_MOUNT;
+    return ftp_vfs_entry(path);
+  }
+
+  return NULL;
 }
 
 /*! close current working directory for ftp session
@@ -518,6 +824,17 @@ static void ftp_session_close_cwd(ftp_session_t *session) {
     closedir(session->dp);
   }
   session->dp = NULL;
+
+  if(session->vdir != NULL)
+  {
+    vfs->closedir(session->vdir);
+  }
+  session->vdir = NULL;
+
+  /* release the MLSD snapshot */
+  ftp_listing_release(session->listing);
+  session->listing    = NULL;
+  session->listingpos = 0;
 }
 
 /*! open current working directory for ftp session
@@ -528,13 +845,7 @@ static void ftp_session_close_cwd(ftp_session_t *session) {
  */
 static int ftp_session_open_cwd(ftp_session_t *session) {
   /* open current working directory */
-  session->dp = opendir(session->cwd);
-  if(session->dp == NULL)
-  {
-    return -1;
-  }
-
-  return 0;
+  return ftp_session_open_dir(session, session->cwd);
 }
 
 /*! set state for ftp session
@@ -866,7 +1177,7 @@ static int ftp_session_fill_dirent_cdir(ftp_session_t *session, const char *path
   char        *buffer;
   size_t      len;
 
-  rc = stat(path, &st);
+  rc = ftp_stat(path, &st);
   /* double-check this was a directory */
   if(rc == 0 && !S_ISDIR(st.st_mode))
   {
@@ -980,6 +1291,7 @@ static ftp_session_t* ftp_session_destroy(ftp_session_t *session) {
 
   /* deallocate */
   free(session);
+  stats.active_sessions--;
 
   return next;
 }
@@ -1016,11 +1328,14 @@ static void ftp_session_new(int listen_fd) {
   session->cmd_fd     = new_fd;
   session->pasv_fd    = -1;
   session->data_fd    = -1;
+  session->fd         = -1;
   session->mlst_flags = SESSION_MLST_TYPE
                       | SESSION_MLST_SIZE
                       | SESSION_MLST_MODIFY
                       | SESSION_MLST_PERM;
   session->state      = COMMAND_STATE;
+  stats.sessions++;
+  stats.active_sessions++;
 
   /* link to the sessions list */
   if(sessions == NULL)
@@ -1373,16 +1688,15 @@ static void ftp_session_read_command(ftp_session_t *session, int events) {
   }
 }
 
-/*! poll sockets for ftp session
+/*! collect the sockets an ftp session is waiting on
  *
- *  @param[in] session ftp session
+ *  @param[in]  session  ftp session
+ *  @param[out] pollinfo pollfds to fill, the command socket comes first
  *
- *  @returns next session
+ *  @returns number of pollfds filled
  */
-static ftp_session_t* ftp_session_poll(ftp_session_t *session) {
-  int           rc;
-  struct pollfd pollinfo[2];
-  nfds_t        nfds = 1;
+static nfds_t ftp_session_pollfds(ftp_session_t *session, struct pollfd pollinfo[2]) {
+  nfds_t nfds = 1;
 
   /* the first pollfd is the command socket */
   pollinfo[0].fd      = session->cmd_fd;
@@ -1424,65 +1738,68 @@ static ftp_session_t* ftp_session_poll(ftp_session_t *session) {
       break;
   }
 
-  /* poll the selected sockets */
-  rc = poll(pollinfo, nfds, 0);
-  if(rc < 0)
-  {
-    ftp_session_close_cmd(session);
-  }
-  else if(rc > 0)
+  return nfds;
+}
+
+/*! handle the polled sockets of an ftp session
+ *
+ *  @param[in] session  ftp session
+ *  @param[in] pollinfo pollfds filled by ftp_session_pollfds
+ *  @param[in] nfds     number of pollfds
+ *
+ *  @returns next session
+ */
+static ftp_session_t* ftp_session_dispatch(ftp_session_t *session, const struct pollfd *pollinfo, nfds_t nfds) {
+  /* check the command socket */
+  if(pollinfo[0].revents != 0)
   {
-    /* check the command socket */
-    if(pollinfo[0].revents != 0)
+    /* we need to read a new command */
+    if(pollinfo[0].revents & (POLLERR|POLLHUP|POLLNVAL))
     {
-      /* we need to read a new command */
-      if(pollinfo[0].revents & (POLLERR|POLLHUP))
-      {
-        ftp_session_close_cmd(session);
-      }
-      else if(pollinfo[0].revents & (POLLIN | POLLPRI))
-        ftp_session_read_command(session, pollinfo[0].revents);
+      ftp_session_close_cmd(session);
     }
+    else if(pollinfo[0].revents & (POLLIN | POLLPRI))
+      ftp_session_read_command(session, pollinfo[0].revents);
+  }
 
-    /* check the data/pasv socket */
-    if(nfds > 1 && pollinfo[1].revents != 0)
+  /* check the data/pasv socket */
+  if(nfds > 1 && pollinfo[1].revents != 0)
+  {
+    switch(session->state)
     {
-      switch(session->state)
-      {
-        case COMMAND_STATE:
-          /* this shouldn't happen? */
-          break;
+      case COMMAND_STATE:
+        /* this shouldn't happen? */
+        break;
 
-        case DATA_CONNECT_STATE:
-          /* we need to accept the PASV connection */
-          if(pollinfo[1].revents & (POLLERR|POLLHUP))
-          {
+      case DATA_CONNECT_STATE:
+        /* we need to accept the PASV connection */
+        if(pollinfo[1].revents & (POLLERR|POLLHUP))
+        {
+          ftp_session_set_state(session, COMMAND_STATE, CLOSE_PASV | CLOSE_DATA);
+          ftp_send_response(session, 426, "Data connection failed\r\n");
+        }
+        else if(pollinfo[1].revents & POLLIN)
+        {
+          if(ftp_session_accept(session) != 0)
             ftp_session_set_state(session, COMMAND_STATE, CLOSE_PASV | CLOSE_DATA);
-            ftp_send_response(session, 426, "Data connection failed\r\n");
-          }
-          else if(pollinfo[1].revents & POLLIN)
-          {
-            if(ftp_session_accept(session) != 0)
-              ftp_session_set_state(session, COMMAND_STATE, CLOSE_PASV | CLOSE_DATA);
-          }
-          else if(pollinfo[1].revents & POLLOUT)
-          {
-            ftp_session_set_state(session, DATA_TRANSFER_STATE, CLOSE_PASV);
-            ftp_send_response(session, 150, "Ready\r\n");
-          }
-          break;
+        }
+        else if(pollinfo[1].revents & POLLOUT)
+        {
+          ftp_session_set_state(session, DATA_TRANSFER_STATE, CLOSE_PASV);
+          ftp_send_response(session, 150, "Ready\r\n");
+        }
+        break;
 
-        case DATA_TRANSFER_STATE:
-          /* we need to transfer data */
-          if(pollinfo[1].revents & (POLLERR|POLLHUP))
-          {
-            ftp_session_set_state(session, COMMAND_STATE, CLOSE_PASV | CLOSE_DATA);
-            ftp_send_response(session, 426, "Data connection failed\r\n");
-          }
-          else if(pollinfo[1].revents & (POLLIN|POLLOUT))
-            ftp_session_transfer(session);
-          break;
-      }
+      case DATA_TRANSFER_STATE:
+        /* we need to transfer data */
+        if(pollinfo[1].revents & (POLLERR|POLLHUP))
+        {
+          ftp_session_set_state(session, COMMAND_STATE, CLOSE_PASV | CLOSE_DATA);
+          ftp_send_response(session, 426, "Data connection failed\r\n");
+        }
+        else if(pollinfo[1].revents & (POLLIN|POLLOUT))
+          ftp_session_transfer(session);
+        break;
     }
   }
 
@@ -1510,7 +1827,12 @@ int ftp_init(void) {
 
   /* get address to listen on */
   serv_addr.sin_family      = AF_INET;
+#ifdef __linux__
+  /* gethostid is not an address outside of the consoles */
+  serv_addr.sin_addr.s_addr = INADDR_ANY;
+#else
   serv_addr.sin_addr.s_addr = gethostid();
+#endif
   serv_addr.sin_port        = htons(LISTEN_PORT);
 
   /* reuse address */
@@ -1545,56 +1867,145 @@ int ftp_init(void) {
 
 /*! deinitialize ftp subsystem */
 void ftp_exit(void) {
+  size_t i;
+
   /* clean up all sessions */
   while(sessions != NULL)
     ftp_session_destroy(sessions);
 
+  /* drop the directory snapshots */
+  for(i = 0; i < LISTING_CACHE; ++i)
+  {
+    ftp_listing_release(listings[i]);
+    listings[i] = NULL;
+  }
+
   /* stop listening for new clients */
   if(listenfd >= 0)
     ftp_closesocket(listenfd, false);
 }
 
-/*! ftp look
+/*! get the transfer counters
  *
- *  @returns whether to keep looping
+ *  @param[out] out counters to fill
  */
-loop_status_t ftp_loop(void) {
-  int           rc;
-  struct pollfd pollinfo;
+void ftp_stats(ftp_stats_t *out) {
+  *out = stats;
+}
+
+/*! mount a read-only namespace
+ *
+ *  @param[in] ns namespace to mount, NULL to unmount
+ */
+void ftp_mount(const ftp_vfs_t *ns) {
+  vfs = ns;
+  ++listing_generation;
+}
+
+/*! collect the sockets the ftp server is waiting on
+ *
+ *  The listen socket comes first, followed by the sockets of every session.
+ *
+ *  @param[out] fds     pollfds to fill
+ *  @param[in]  max_fds number of pollfds fds can hold
+ *
+ *  @returns number of pollfds needed; only the first max_fds are filled
+ */
+int ftp_pollfds(struct pollfd *fds, int max_fds) {
+  int           nfds = 0;
+  nfds_t        i, n;
+  struct pollfd pollinfo[2];
   ftp_session_t *session;
 
   /* we will poll for new client connections */
-  pollinfo.fd      = listenfd;
-  pollinfo.events  = POLLIN;
-  pollinfo.revents = 0;
-
-  /* poll for a new client */
-  rc = poll(&pollinfo, 1, 0);
-  if(rc < 0)
+  if(nfds < max_fds)
   {
-    /* wifi got disabled */
-    if(errno == ENETDOWN)
-      return LOOP_RESTART;
-
-    return LOOP_EXIT;
+    fds[nfds].fd      = listenfd;
+    fds[nfds].events  = POLLIN;
+    fds[nfds].revents = 0;
   }
-  else if(rc > 0)
+  ++nfds;
+
+  for(session = sessions; session != NULL; session = session->next)
   {
-    if(pollinfo.revents & POLLIN)
+    n = ftp_session_pollfds(session, pollinfo);
+    for(i = 0; i < n; ++i, ++nfds)
     {
-      /* we got a new client */
-      ftp_session_new(listenfd);
+      if(nfds < max_fds)
+        fds[nfds] = pollinfo[i];
     }
   }
 
-  /* poll each session */
+  return nfds;
+}
+
+/*! handle the sockets collected by ftp_pollfds once they have been polled
+ *
+ *  @param[in] fds  pollfds filled by ftp_pollfds
+ *  @param[in] nfds number of pollfds
+ *
+ *  @returns whether to keep looping
+ */
+loop_status_t ftp_dispatch(const struct pollfd *fds, int nfds) {
+  int           i = 1;
+  nfds_t        n;
+  struct pollfd pollinfo[2];
+  ftp_session_t *session;
+
+  if(nfds < 1)
+    return LOOP_CONTINUE;
+
+  /* wifi got disabled */
+  if(fds[0].revents & (POLLERR|POLLNVAL))
+    return LOOP_RESTART;
+
+  /* handle the sessions first, a new client has no pollfds yet */
   session = sessions;
   while(session != NULL)
-    session = ftp_session_poll(session);
+  {
+    n = ftp_session_pollfds(session, pollinfo);
+    if(i + (int)n > nfds || fds[i].fd != session->cmd_fd)
+      break;
+
+    session = ftp_session_dispatch(session, fds + i, n);
+    i += n;
+  }
+
+  if(fds[0].revents & POLLIN)
+  {
+    /* we got a new client */
+    ftp_session_new(listenfd);
+  }
 
   return LOOP_CONTINUE;
 }
 
+/*! ftp look
+ *
+ *  @returns whether to keep looping
+ */
+loop_status_t ftp_loop(void) {
+  int           rc;
+  int           nfds = ftp_pollfds(NULL, 0);
+  struct pollfd fds[nfds];
+
+  /* poll for new clients and session activity */
+  ftp_pollfds(fds, nfds);
+  rc = poll(fds, nfds, 0);
+  if(rc < 0)
+  {
+    /* wifi got disabled */
+    if(errno == ENETDOWN)
+      return LOOP_RESTART;
+
+    return LOOP_EXIT;
+  }
+  else if(rc == 0)
+    return LOOP_CONTINUE;
+
+  return ftp_dispatch(fds, nfds);
+}
+
 /*! change to parent directory
  *
  *  @param[in] session ftp session
@@ -1626,6 +2037,7 @@ static int validate_path(const char *args) {
   {
     if(p[3] == 0 || p[3] == '/')
       return -1;
+    ++p;
   }
 
   /* make sure there are no '//' */
@@ -1706,6 +2118,216 @@ static int build_path(ftp_session_t *session, const char *cwd, const char *args)
   return 0;
 }
 
+/*! append to a directory snapshot
+ *
+ *  @param[in] listing snapshot to append to
+ *  @param[in] data    data to append
+ *  @param[in] len     data length
+ *
+ *  @returns -1 for failure
+ */
+static int ftp_listing_append(ftp_listing_t *listing, const char *data, size_t len) {
+  char   *p;
+  size_t capacity = listing->capacity;
+
+  if(listing->size + len > capacity)
+  {
+    while(listing->size + len > capacity)
+      capacity = capacity ? capacity * 2 : XFER_BUFFERSIZE;
+
+    p = (char*)realloc(listing->data, capacity);
+    if(p == NULL)
+      return -1;
+
+    listing->data     = p;
+    listing->capacity = capacity;
+  }
+
+  memcpy(listing->data + listing->size, data, len);
+  listing->size += len;
+  return 0;
+}
+
+/*! build the MLSD snapshot of a directory
+ *
+ *  @param[in] session ftp session
+ *  @param[in] path    directory to list
+ *  @param[in] dir     stat data of the directory
+ *
+ *  @returns snapshot with one reference, NULL with errno set on failure
+ */
+static ftp_listing_t* ftp_listing_build(ftp_session_t *session, const char *path, const struct stat *dir) {
+  int           rc = 0;
+  size_t        len;
+  char          *buffer;
+  struct stat   st;
+  const char    *name;
+  ftp_listing_t *listing;
+
+  listing = (ftp_listing_t*)calloc(1, sizeof(ftp_listing_t));
+  if(listing == NULL)
+  {
+    errno = ENOMEM;
+    return NULL;
+  }
+
+  strcpy(listing->path, path);
+  listing->flags      = session->mlst_flags;
+  listing->mtime      = dir->st_mtime;
+  listing->created    = time(NULL);
+  listing->generation = listing_generation;
+  listing->refs       = 1;
+
+  if(ftp_session_open_dir(session, path) != 0)
+  {
+    ftp_listing_release(listing);
+    return NULL;
+  }
+
+  /* the listed directory comes first as type=cdir */
+  if(session->mlst_flags & SESSION_MLST_TYPE)
+  {
+    rc = ftp_session_fill_dirent_cdir(session, path);
+    if(rc == 0 && ftp_listing_append(listing, session->buffer, session->buffersize) != 0)
+      rc = ENOMEM;
+  }
+
+  while(rc == 0 && (name = ftp_session_read_dir(session, path)) != NULL)
+  {
+    if(strcmp(name, ".") == 0 || strcmp(name, "..") == 0)
+      continue;
+
+    /* lstat the entry */
+    if(build_path(session, path, name) != 0
+    || ftp_lstat(session->buffer, &st) != 0)
+    {
+      rc = errno;
+      break;
+    }
+
+    /* encode \n in path */
+    len = strlen(name);
+    buffer = encode_path(name, &len, false);
+    if(buffer == NULL)
+    {
+      rc = ENOMEM;
+      break;
+    }
+
+    rc = ftp_session_fill_dirent(session, &st, buffer, len);
+    free(buffer);
+    if(rc == 0 && ftp_listing_append(listing, session->buffer, session->buffersize) != 0)
+      rc = ENOMEM;
+  }
+  ftp_session_close_cwd(session);
+
+  if(rc != 0)
+  {
+    ftp_listing_release(listing);
+    errno = rc;
+    return NULL;
+  }
+
+  return listing;
+}
+
+/*! get the MLSD snapshot of a directory
+ *
+ *  A cached snapshot is reused until the server modifies the file system, the
+ *  directory's mtime changes or it expires, whichever comes first.
+ *
+ *  @param[in] session ftp session
+ *  @param[in] path    directory to list
+ *
+ *  @returns snapshot with a reference for the caller, NULL with errno set on failure
+ */
+static ftp_listing_t* ftp_listing_get(ftp_session_t *session, const char *path) {
+  size_t        i, slot = 0;
+  time_t        now = time(NULL);
+  struct stat   st;
+  ftp_listing_t *listing;
+
+  if(ftp_stat(path, &st) != 0)
+    return NULL;
+
+  for(i = 0; i < LISTING_CACHE; ++i)
+  {
+    listing = listings[i];
+    if(listing != NULL
+    && listing->flags == session->mlst_flags
+    && strcmp(listing->path, path) == 0)
+    {
+      /* changes made by others don't always show in the mtime, so snapshots also expire */
+      if(listing->generation == listing_generation
+      && listing->mtime == st.st_mtime
+      && now >= listing->created
+      && now - listing->created < LISTING_TTL)
+      {
+        ++listing->refs;
+        return listing;
+      }
+
+      ftp_listing_release(listing);
+      listings[i] = listing = NULL;
+    }
+
+    /* replace an empty slot, or else the oldest snapshot */
+    if(listings[slot] != NULL
+    && (listing == NULL || listing->created < listings[slot]->created))
+      slot = i;
+  }
+
+  listing = ftp_listing_build(session, path, &st);
+  if(listing != NULL && listing->size <= LISTING_MAX)
+  {
+    ftp_listing_release(listings[slot]);
+    listings[slot] = listing;
+    ++listing->refs;
+  }
+
+  return listing;
+}
+
+/*! send a directory snapshot
+ *
+ *  @param[in] session ftp session
+ *
+ *  @returns whether to call again
+ */
+static loop_status_t mlsd_transfer(ftp_session_t *session) {
+  ssize_t       rc;
+  ftp_listing_t *listing = session->listing;
+
+  /* check if we sent the whole snapshot */
+  if(session->listingpos == listing->size)
+  {
+    ftp_session_set_state(session, COMMAND_STATE, CLOSE_PASV | CLOSE_DATA);
+    ftp_send_response(session, 226, "OK\r\n");
+    return LOOP_EXIT;
+  }
+
+  /* send any pending data */
+  rc = send(session->data_fd, listing->data + session->listingpos,
+            listing->size - session->listingpos, 0);
+  if(rc <= 0)
+  {
+    /* error sending data */
+    if(rc < 0)
+    {
+      if(errno == EWOULDBLOCK)
+        return LOOP_EXIT;
+    }
+
+    ftp_session_set_state(session, COMMAND_STATE, CLOSE_PASV | CLOSE_DATA);
+    ftp_send_response(session, 426, "Connection broken during transfer\r\n");
+    return LOOP_EXIT;
+  }
+
+  /* we can try to send more data */
+  session->listingpos += rc;
+  return LOOP_CONTINUE;
+}
+
 /*! transfer a directory listing
  *
  *  @param[in] session ftp session
@@ -1717,7 +2339,7 @@ static loop_status_t list_transfer(ftp_session_t *session) {
   size_t        len;
   char          *buffer;
   struct stat   st;
-  struct dirent *dent;
+  const char    *name;
 
   /* check if we sent all available data */
   if(session->bufferpos == session->buffersize)
@@ -1730,7 +2352,7 @@ static loop_status_t list_transfer(ftp_session_t *session) {
     }
 
     /* check if this was for a file */
-    if(session->dp == NULL)
+    if(session->dp == NULL && session->vdir == NULL)
     {
       /* we already sent the file's listing */
       ftp_session_set_state(session, COMMAND_STATE, CLOSE_PASV | CLOSE_DATA);
@@ -1739,8 +2361,8 @@ static loop_status_t list_transfer(ftp_session_t *session) {
     }
 
     /* get the next directory entry */
-    dent = readdir(session->dp);
-    if(dent == NULL)
+    name = ftp_session_read_dir(session, session->lwd);
+    if(name == NULL)
     {
       /* we have exhausted the directory listing */
       ftp_session_set_state(session, COMMAND_STATE, CLOSE_PASV | CLOSE_DATA);
@@ -1749,7 +2371,7 @@ static loop_status_t list_transfer(ftp_session_t *session) {
     }
 
     /* TODO I think we are supposed to return entries for . and .. */
-    if(strcmp(dent->d_name, ".") == 0 || strcmp(dent->d_name, "..") == 0)
+    if(strcmp(name, ".") == 0 || strcmp(name, "..") == 0)
       return LOOP_CONTINUE;
 
     /* check if this was a NLST */
@@ -1757,7 +2379,7 @@ static loop_status_t list_transfer(ftp_session_t *session) {
     {
       /* NLST gives the whole path name */
       session->buffersize = 0;
-      if(build_path(session, session->lwd, dent->d_name) == 0)
+      if(build_path(session, session->lwd, name) == 0)
       {
         /* encode \n in path */
         len = session->buffersize;
@@ -1776,8 +2398,8 @@ static loop_status_t list_transfer(ftp_session_t *session) {
     else
     {
       /* lstat the entry */
-      if((rc = build_path(session, session->lwd, dent->d_name)) != 0) { }
-      else if((rc = lstat(session->buffer, &st)) != 0) { }
+      if((rc = build_path(session, session->lwd, name)) != 0) { }
+      else if((rc = ftp_lstat(session->buffer, &st)) != 0) { }
 
       if(rc != 0)
       {
@@ -1787,8 +2409,8 @@ static loop_status_t list_transfer(ftp_session_t *session) {
         return LOOP_EXIT;
       }
       /* encode \n in path */
-      len = strlen(dent->d_name);
-      buffer = encode_path(dent->d_name, &len, false);
+      len = strlen(name);
+      buffer = encode_path(name, &len, false);
       if(buffer != NULL)
       {
         rc = ftp_session_fill_dirent(session, &st, buffer, len);
@@ -1836,31 +2458,73 @@ static loop_status_t list_transfer(ftp_session_t *session) {
  */
 static loop_status_t retrieve_transfer(ftp_session_t *session) {
   ssize_t rc;
+  char    *p;
+  size_t  len;
 
-  if(session->bufferpos == session->buffersize)
+#ifdef __linux__
+  if(!(session->flags & SESSION_COPY))
+  {
+    /* let the kernel move the file to the socket without copying it through the ring buffer */
+    off_t offset = session->filepos;
+    rc = sendfile(session->data_fd, session->fd, &offset, RING_BUFFERSIZE);
+    if(rc > 0)
+    {
+      session->filepos  = offset;
+      stats.bytes_sent += rc;
+      return LOOP_CONTINUE;
+    }
+    else if(rc == 0)
+    {
+      ftp_session_set_state(session, COMMAND_STATE, CLOSE_PASV | CLOSE_DATA);
+      ftp_send_response(session, 226, "OK\r\n");
+      return LOOP_EXIT;
+    }
+    else if(errno == EWOULDBLOCK)
+      return LOOP_EXIT;
+    else if(errno != EINVAL && errno != ENOSYS)
+    {
+      ftp_session_set_state(session, COMMAND_STATE, CLOSE_PASV | CLOSE_DATA);
+      ftp_send_response(session, 426, "Connection broken during transfer\r\n");
+      return LOOP_EXIT;
+    }
+
+    /* the file system doesn't support it, continue where sendfile stopped */
+    session->flags |= SESSION_COPY;
+    if(lseek(session->fd, session->filepos, SEEK_SET) < 0)
+    {
+      ftp_session_set_state(session, COMMAND_STATE, CLOSE_PASV | CLOSE_DATA);
+      ftp_send_response(session, 451, "Failed to read file\r\n");
+      return LOOP_EXIT;
+    }
+  }
+#endif
+
+  /* read ahead in large chunks once half of the ring buffer has been sent */
+  if(!(session->flags & SESSION_EOF)
+  && session->ring_head - session->ring_tail <= RING_BUFFERSIZE / 2)
   {
-    /* we have sent all the data so read some more */
     rc = ftp_session_read_file(session);
-    if(rc <= 0)
+    if(rc < 0)
     {
-      /* can't read any more data */
       ftp_session_set_state(session, COMMAND_STATE, CLOSE_PASV | CLOSE_DATA);
-      if(rc < 0)
-        ftp_send_response(session, 451, "Failed to read file\r\n");
-      else {
-        ftp_send_response(session, 226, "OK\r\n");
-      }
+      ftp_send_response(session, 451, "Failed to read file\r\n");
       return LOOP_EXIT;
     }
+    else if(rc == 0)
+      session->flags |= SESSION_EOF;
+  }
 
-    /* we read some data so reset the session buffer to send */
-    session->bufferpos  = 0;
-    session->buffersize = rc;
+  len = ftp_session_ring_data(session, &p);
+  if(len == 0)
+  {
+    /* the whole file has been sent */
+    ftp_session_set_state(session, COMMAND_STATE, CLOSE_PASV | CLOSE_DATA);
+    ftp_send_response(session, 226, "OK\r\n");
+    return LOOP_EXIT;
   }
 
   /* send any pending data */
-  rc = send(session->data_fd, session->buffer + session->bufferpos,
-            session->buffersize - session->bufferpos, 0);
+  rc = send(session->data_fd, p, len, 0);
   if(rc <= 0)
   {
     /* error sending data */
@@ -1876,58 +2540,71 @@ static loop_status_t retrieve_transfer(ftp_session_t *session) {
   }
 
   /* we can try to send more data */
-  session->bufferpos += rc;
+  session->ring_tail += rc;
+  stats.bytes_sent   += rc;
   return LOOP_CONTINUE;
 }
 
-/*! send a file to the client
+/*! receive a file from the client
  *
  *  @param[in] session ftp session
  *
  *  @returns whether to call again
  */
 static loop_status_t store_transfer(ftp_session_t *session) {
-  ssize_t rc;
+  ssize_t rc = 0;
+  char    *p;
+  size_t  len;
 
-  if(session->bufferpos == session->buffersize)
+  /* receive as much as fits into the ring buffer */
+  len = ftp_session_ring_space(session, &p);
+  if(len > 0)
   {
-    /* we have written all the received data, so try to get some more */
-    rc = recv(session->data_fd, session->buffer, sizeof(session->buffer), 0);
-    if(rc <= 0)
+    rc = recv(session->data_fd, p, len, 0);
+    if(rc < 0 && errno != EWOULDBLOCK)
     {
-      /* can't read any more data */
-      if(rc < 0)
-      {
-        if(errno == EWOULDBLOCK)
-          return LOOP_EXIT;
-      }
-
       ftp_session_set_state(session, COMMAND_STATE, CLOSE_PASV | CLOSE_DATA);
-
-      if(rc == 0)
-        ftp_send_response(session, 226, "OK\r\n");
-      else
-        ftp_send_response(session, 426, "Connection broken during transfer\r\n");
+      ftp_send_response(session, 426, "Connection broken during transfer\r\n");
       return LOOP_EXIT;
     }
+    else if(rc == 0)
+      session->flags |= SESSION_EOF;
+    else if(rc > 0)
+    {
+      session->ring_head   += rc;
+      stats.bytes_received += rc;
+    }
+  }
 
-    /* we received some data so reset the session buffer to write */
-    session->bufferpos  = 0;
-    session->buffersize = rc;
+  /* write in large chunks, or whatever is left once the socket has been drained */
+  if(rc <= 0 || session->ring_head - session->ring_tail >= RING_BUFFERSIZE / 2)
+  {
+    if(ftp_session_write_file(session) != 0)
+    {
+      ftp_session_set_state(session, COMMAND_STATE, CLOSE_PASV | CLOSE_DATA);
+      ftp_send_response(session, 451, "Failed to write file\r\n");
+      return LOOP_EXIT;
+    }
   }
 
-  rc = ftp_session_write_file(session);
-  if(rc <= 0)
+  if(session->flags & SESSION_EOF)
   {
-    /* error writing data */
+    /* a restarted upload replaces everything past its offset */
+    if(session->filepos < session->filesize
+    && ftruncate(session->fd, session->filepos) != 0)
+    {
+      ftp_session_set_state(session, COMMAND_STATE, CLOSE_PASV | CLOSE_DATA);
+      ftp_send_response(session, 451, "Failed to write file\r\n");
+      return LOOP_EXIT;
+    }
+
     ftp_session_set_state(session, COMMAND_STATE, CLOSE_PASV | CLOSE_DATA);
-    ftp_send_response(session, 451, "Failed to write file\r\n");
+    ftp_send_response(session, 226, "OK\r\n");
     return LOOP_EXIT;
   }
 
   /* we can try to receive more data */
-  session->bufferpos += rc;
-  return LOOP_CONTINUE;
+  return rc < 0 ? LOOP_EXIT : LOOP_CONTINUE;
 }
 
 /*! ftp_xfer_file mode */
@@ -1948,6 +2625,10 @@ typedef enum {
 static void ftp_xfer_file(ftp_session_t *session, const char *args, xfer_file_mode_t mode) {
   int rc;
 
+  /* a REST offset only applies to the transfer that follows it */
+  session->filepos = mode == XFER_FILE_APPE ? 0 : session->restpos;
+  session->restpos = 0;
+
   /* build the path of the file to transfer */
   if(build_path(session, session->cwd, args) != 0)
   {
@@ -1965,9 +2646,13 @@ static void ftp_xfer_file(ftp_session_t *session, const char *args, xfer_file_mo
 
   if(rc != 0)
   {
-    /* error opening the file */
+    /* error opening the file, or the REST offset is past its end */
+    rc = errno;
     ftp_session_set_state(session, COMMAND_STATE, CLOSE_PASV | CLOSE_DATA);
-    ftp_send_response(session, 450, "failed to open file\r\n");
+    if(rc == ERANGE)
+      ftp_send_response(session, 554, "Invalid REST offset\r\n");
+    else
+      ftp_send_response(session, 450, "failed to open file\r\n");
     return;
   }
 
@@ -1989,11 +2674,15 @@ static void ftp_xfer_file(ftp_session_t *session, const char *args, xfer_file_mo
     }
 
     /* set up the transfer */
-    session->flags &= ~(SESSION_RECV|SESSION_SEND);
+    session->flags &= ~(SESSION_RECV|SESSION_SEND|SESSION_EOF|SESSION_COPY);
     if(mode == XFER_FILE_RETR)
     {
       session->flags   |= SESSION_SEND;
       session->transfer = retrieve_transfer;
+
+      /* generated files have no descriptor to send from */
+      if(session->vfile != NULL)
+        session->flags |= SESSION_COPY;
     }
     else
     {
@@ -2001,8 +2690,9 @@ static void ftp_xfer_file(ftp_session_t *session, const char *args, xfer_file_mo
       session->transfer = store_transfer;
     }
 
-    session->bufferpos  = 0;
-    session->buffersize = 0;
+    session->ring_head  = 0;
+    session->ring_tail  = 0;
+    session->xfer_start = ftp_now();
 
     return;
   }
@@ -2050,11 +2740,10 @@ ftp_xfer_dir(ftp_session_t   *session,
     }
 
     /* check if this is a directory */
-    session->dp = opendir(session->buffer);
-    if(session->dp == NULL)
+    if(ftp_session_open_dir(session, session->buffer) != 0)
     {
       /* not a directory; check if it is a file */
-      rc = stat(session->buffer, &st);
+      rc = ftp_stat(session->buffer, &st);
       if(rc != 0)
       {
         /* error getting stat */
@@ -2128,19 +2817,6 @@ ftp_xfer_dir(ftp_session_t   *session,
       memcpy(session->lwd, session->buffer, session->buffersize);
       session->lwd[session->buffersize] = 0;
       session->buffersize = 0;
-
-      if(session->dir_mode == XFER_DIR_MLSD
-      && (session->mlst_flags & SESSION_MLST_TYPE))
-      {
-        /* send this directory as type=cdir */
-        rc = ftp_session_fill_dirent_cdir(session, session->lwd);
-        if(rc != 0)
-        {
-          ftp_session_set_state(session, COMMAND_STATE, CLOSE_PASV | CLOSE_DATA);
-          ftp_send_response(session, 550, "%s\r\n", strerror(rc));
-          return;
-        }
-      }
     }
   }
   else if(ftp_session_open_cwd(session) != 0)
@@ -2155,19 +2831,22 @@ ftp_xfer_dir(ftp_session_t   *session,
     /* set the cwd as the lwd */
     strcpy(session->lwd, session->cwd);
     session->buffersize = 0;
+  }
 
-    if(session->dir_mode == XFER_DIR_MLSD
-    && (session->mlst_flags & SESSION_MLST_TYPE))
+  if(mode == XFER_DIR_MLSD)
+  {
+    /* MLSD sends a snapshot of the whole directory, which following listings of it can reuse */
+    ftp_session_close_cwd(session);
+    session->listing = ftp_listing_get(session, session->lwd);
+    if(session->listing == NULL)
     {
-      /* send this directory as type=cdir */
-      rc = ftp_session_fill_dirent_cdir(session, session->lwd);
-      if(rc != 0)
-      {
-        ftp_session_set_state(session, COMMAND_STATE, CLOSE_PASV | CLOSE_DATA);
-        ftp_send_response(session, 550, "%s\r\n", strerror(rc));
-        return;
-      }
+      rc = errno;
+      ftp_session_set_state(session, COMMAND_STATE, CLOSE_PASV | CLOSE_DATA);
+      ftp_send_response(session, 550, "%s\r\n", strerror(rc));
+      return;
     }
+
+    session->transfer = mlsd_transfer;
   }
 
   if(mode == XFER_DIR_MLST || mode == XFER_DIR_STAT)
@@ -2310,7 +2989,7 @@ FTP_DECLARE(CWD)
   }
 
   /* get the path status */
-  rc = stat(session->buffer, &st);
+  rc = ftp_stat(session->buffer, &st);
   if(rc != 0)
   {
     ftp_send_response(session, 550, "unavailable\r\n");
@@ -2350,8 +3029,16 @@ FTP_DECLARE(DELE)
     return;
   }
 
+  /* the virtual namespace is read-only */
+  if(ftp_vfs_owns(session->buffer))
+  {
+    ftp_send_response(session, 550, "%s\r\n", strerror(EROFS));
+    return;
+  }
+
   /* try to unlink the path */
   rc = unlink(session->buffer);
+  ++listing_generation;
   if(rc != 0)
   {
     /* error unlinking the file */
@@ -2378,6 +3065,7 @@ FTP_DECLARE(FEAT)
     " MDTM\r\n"
     " MLST Type%s;Size%s;Modify%s;Perm%s;UNIX.mode%s;\r\n"
     " PASV\r\n"
+    " REST STREAM\r\n"
     " SIZE\r\n"
     " TVFS\r\n"
     " UTF8\r\n"
@@ -2448,7 +3136,7 @@ FTP_DECLARE(MDTM)
     return;
   }
 
-  rc = stat(session->buffer, &st);
+  rc = ftp_stat(session->buffer, &st);
   if(rc != 0)
   {
     ftp_send_response(session, 550, "Error getting mtime\r\n");
@@ -2494,8 +3182,16 @@ FTP_DECLARE(MKD)
     return;
   }
 
+  /* the virtual namespace is read-only */
+  if(ftp_vfs_owns(session->buffer))
+  {
+    ftp_send_response(session, 550, "%s\r\n", strerror(EROFS));
+    return;
+  }
+
   /* try to create the directory */
   rc = mkdir(session->buffer, 0755);
+  ++listing_generation;
   if(rc != 0 && errno != EEXIST)
   {
     /* mkdir failure */
@@ -2543,7 +3239,7 @@ FTP_DECLARE(MLST)
   }
 
   /* stat path */
-  rc = lstat(session->buffer, &st);
+  rc = ftp_lstat(session->buffer, &st);
   if(rc != 0)
   {
     ftp_send_response(session, 550, "%s\r\n", strerror(errno));
@@ -2980,7 +3676,7 @@ FTP_DECLARE(QUIT)
  *
  *  @brief restart a transfer
  *
- *  @note sets file position for a subsequent STOR operation
+ *  @note sets file position for a subsequent RETR or STOR operation
  *
  *  @param[in] session ftp session
  *  @param[in] args    arguments
@@ -3025,9 +3721,9 @@ FTP_DECLARE(REST)
     pos += (*p - '0');
   }
 
-  /* set the restart offset */
-  session->filepos = pos;
-  ftp_send_response(session, 200, "OK\r\n");
+  /* set the restart offset, it is kept until the transfer command */
+  session->restpos = pos;
+  ftp_send_response(session, 350, "Restarting at %" PRIu64 "\r\n", pos);
 }
 
 /*! @fn static void RETR(ftp_session_t *session, const char *args)
@@ -3065,8 +3761,16 @@ FTP_DECLARE(RMD)
     return;
   }
 
+  /* the virtual namespace is read-only */
+  if(ftp_vfs_owns(session->buffer))
+  {
+    ftp_send_response(session, 550, "%s\r\n", strerror(EROFS));
+    return;
+  }
+
   /* remove the directory */
   rc = rmdir(session->buffer);
+  ++listing_generation;
   if(rc != 0)
   {
     /* rmdir error */
@@ -3100,6 +3804,13 @@ FTP_DECLARE(RNFR)
     return;
   }
 
+  /* the virtual namespace is read-only */
+  if(ftp_vfs_owns(session->buffer))
+  {
+    ftp_send_response(session, 550, "%s\r\n", strerror(EROFS));
+    return;
+  }
+
   /* make sure the path exists */
   rc = lstat(session->buffer, &st);
   if(rc != 0)
@@ -3150,8 +3861,16 @@ FTP_DECLARE(RNTO)
     return;
   }
 
+  /* the virtual namespace is read-only */
+  if(ftp_vfs_owns(session->buffer))
+  {
+    ftp_send_response(session, 550, "%s\r\n", strerror(EROFS));
+    return;
+  }
+
   /* rename the file */
   rc = rename(rnfr, session->buffer);
+  ++listing_generation;
   if(rc != 0)
   {
     /* rename failure */
@@ -3183,7 +3902,7 @@ FTP_DECLARE(SIZE)
     return;
   }
 
-  rc = stat(session->buffer, &st);
+  rc = ftp_stat(session->buffer, &st);
   if(rc != 0 || !S_ISREG(st.st_mode))
   {
     ftp_send_response(session, 550, "Could not get file size.\r\n");
@@ -1,6 +1,11 @@
 #ifndef FTP_H
 #define FTP_H
 
+#include <poll.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
 /*! Loop status */
 typedef enum {
   LOOP_CONTINUE, /*!< Continue looping */
@@ -8,8 +13,41 @@ typedef enum {
   LOOP_EXIT,     /*!< Terminate looping */
 } loop_status_t;
 
+/*! Transfer counters, accumulated over every ftp_init */
+typedef struct {
+  uint64_t sessions;        /*!< command connections accepted */
+  uint64_t active_sessions; /*!< command connections currently open */
+  uint64_t transfers;       /*!< file transfers that have ended */
+  uint64_t bytes_sent;      /*!< file data sent to clients */
+  uint64_t bytes_received;  /*!< file data received from clients */
+  uint64_t transfer_usec;   /*!< time spent with a file transfer open */
+} ftp_stats_t;
+
+/*! Read-only namespace mounted over the file system
+ *
+ *  Every path below root, and root itself, is looked up through these
+ *  callbacks instead of the file system. Paths are absolute.
+ */
+typedef struct {
+  const char  *root;                                       /*!< mount point, e.g. /name */
+  int         (*stat)(const char *path, struct stat *st);  /*!< fill stat data, -1 with errno set on failure */
+  void*       (*opendir)(const char *path);                /*!< open a directory, NULL with errno set on failure */
+  const char* (*readdir)(void *dir);                       /*!< next entry name, NULL at the end */
+  void        (*closedir)(void *dir);                      /*!< close a directory */
+  void*       (*open)(const char *path);                   /*!< open a file, NULL with errno set on failure */
+  ssize_t     (*read)(void *file, void *buffer, size_t n); /*!< read sequentially, 0 at the end, -1 on failure */
+  int         (*seek)(void *file, off_t offset);           /*!< move a freshly opened file to offset, -1 on failure */
+  void        (*close)(void *file);                        /*!< close a file */
+} ftp_vfs_t;
+
 int           ftp_init(void);
 loop_status_t ftp_loop(void);
+int           ftp_pollfds(struct pollfd *fds, int max_fds);
+loop_status_t ftp_dispatch(const struct pollfd *fds, int nfds);
 void          ftp_exit(void);
+/* only valid on the thread calling ftp_dispatch */
+void          ftp_stats(ftp_stats_t *stats);
+/* vfs must outlive the server, NULL unmounts it */
+void          ftp_mount(const ftp_vfs_t *vfs);
 
 #endif
@@ -0,0 +1,191 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "benchmark.hpp"
+#include "profiler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef BENCHMARK_ALLOCATIONS
+// counting replaces the global allocator, so it is only built into benchmark builds
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+// gcc pairs the free in operator delete with the operator new it inlined into the callers here
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+static std::atomic<size_t> allocationCount{0};
+
+void* operator new(size_t size)
+{
+    allocationCount++;
+    void* ptr = malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) {
+#if __cpp_exceptions
+        throw std::bad_alloc();
+#else
+        abort();
+#endif
+    }
+    return ptr;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+size_t Benchmark::allocations(void)
+{
+    return allocationCount;
+}
+#else
+size_t Benchmark::allocations(void)
+{
+    return 0;
+}
+#endif
+
+void Benchmark::start(const std::vector<Step>& steps)
+{
+    mSteps = steps;
+    mResults.assign(steps.size(), {0, 0, 0, 0, std::vector<size_t>(mCounters.size(), 0)});
+    mStep  = 0;
+    mFrame = 0;
+}
+
+void Benchmark::track(const std::string& name, std::function<size_t(void)> read)
+{
+    auto it = std::find_if(mCounters.begin(), mCounters.end(), [&](const Counter& c) { return c.name == name; });
+    if (it != mCounters.end()) {
+        it->read = read;
+    }
+    else {
+        mCounters.push_back({name, read, 0});
+    }
+}
+
+void Benchmark::beginFrame(void)
+{
+    if (!running()) {
+        return;
+    }
+
+    mStart       = Profiler::now();
+    mAllocations = allocations();
+    for (auto& counter : mCounters) {
+        counter.start = counter.read();
+    }
+    if (mFrame == 0 && mSteps[mStep].action) {
+        mSteps[mStep].action();
+    }
+}
+
+void Benchmark::endFrame(void)
+{
+    if (!running()) {
+        return;
+    }
+
+    const uint64_t elapsed = Profiler::now() - mStart;
+    Result& result         = mResults[mStep];
+    result.frames++;
+    result.time += elapsed;
+    result.worst = elapsed > result.worst ? elapsed : result.worst;
+    result.allocations += allocations() - mAllocations;
+    for (size_t i = 0; i < mCounters.size() && i < result.counters.size(); i++) {
+        result.counters[i] += mCounters[i].read() - mCounters[i].start;
+    }
+
+    if (++mFrame >= mSteps[mStep].frames) {
+        mStep++;
+        mFrame = 0;
+    }
+}
+
+std::string Benchmark::report(void) const
+{
+    // steps sharing a name are reported together, in the order they first ran
+    std::vector<std::pair<std::string, Result>> totals;
+    for (size_t i = 0; i < mResults.size(); i++) {
+        auto it = std::find_if(totals.begin(), totals.end(), [&](const std::pair<std::string, Result>& t) { return t.first == mSteps[i].name; });
+        if (it == totals.end()) {
+            totals.push_back({mSteps[i].name, {0, 0, 0, 0, std::vector<size_t>(mResults[i].counters.size(), 0)}});
+            it = totals.end() - 1;
+        }
+        it->second.frames += mResults[i].frames;
+        it->second.time += mResults[i].time;
+        it->second.worst = std::max(it->second.worst, mResults[i].worst);
+        it->second.allocations += mResults[i].allocations;
+        for (size_t j = 0; j < it->second.counters.size(); j++) {
+            it->second.counters[j] += mResults[i].counters[j];
+        }
+    }
+
+    std::string ret;
+    char line[128];
+    for (const auto& t : totals) {
+        const Result& r = t.second;
+        if (r.frames == 0) {
+            continue;
+        }
+        snprintf(line, sizeof(line), "%s: %zu frames, %.2f ms avg, %.2f ms worst", t.first.c_str(), r.frames, r.time / 1000.0f / r.frames,
+            r.worst / 1000.0f);
+        ret += line;
+#ifdef BENCHMARK_ALLOCATIONS
+        snprintf(line, sizeof(line), ", %.1f allocs/frame", (float)r.allocations / r.frames);
+        ret += line;
+#endif
+        for (size_t i = 0; i < r.counters.size(); i++) {
+            snprintf(line, sizeof(line), ", %.1f %s/frame", (float)r.counters[i] / r.frames, mCounters[i].name.c_str());
+            ret += line;
+        }
+        ret += "\n";
+    }
+    return ret;
+}
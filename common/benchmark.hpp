@@ -0,0 +1,100 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include <functional>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// replays a scripted sequence of UI steps in place of input handling and
+// records the CPU time and heap allocations of every frame per step
+class Benchmark {
+public:
+    struct Step {
+        std::string name;
+        size_t frames;
+        // runs before the first frame of the step is drawn
+        std::function<void(void)> action;
+    };
+
+    static Benchmark& getInstance(void)
+    {
+        static Benchmark mBenchmark;
+        return mBenchmark;
+    }
+
+    void start(const std::vector<Step>& steps);
+    // reports how much a counter grows per frame next to the allocations, a
+    // counter tracked again under the same name replaces the previous one
+    void track(const std::string& name, std::function<size_t(void)> read);
+    bool running(void) const { return mStep < mSteps.size(); }
+
+    // the main loop brackets the work of a frame with these, minus presenting it
+    void beginFrame(void);
+    void endFrame(void);
+
+    // one line per step: frames, average and worst frame time, allocations and tracked counters per frame
+    std::string report(void) const;
+
+    // heap allocations made through operator new since startup, only counted when
+    // built with BENCHMARK_ALLOCATIONS (make DEFINES=-DBENCHMARK_ALLOCATIONS on Switch)
+    // and always 0 otherwise
+    static size_t allocations(void);
+
+private:
+    Benchmark(void) {}
+    ~Benchmark(void) {}
+
+    Benchmark(Benchmark const&) = delete;
+    void operator=(Benchmark const&) = delete;
+
+    struct Result {
+        size_t frames;
+        uint64_t time;
+        uint64_t worst;
+        size_t allocations;
+        std::vector<size_t> counters;
+    };
+
+    struct Counter {
+        std::string name;
+        std::function<size_t(void)> read;
+        size_t start;
+    };
+
+    std::vector<Step> mSteps;
+    std::vector<Counter> mCounters;
+    std::vector<Result> mResults;
+    size_t mStep        = 0;
+    size_t mFrame       = 0;
+    uint64_t mStart     = 0;
+    size_t mAllocations = 0;
+};
+
+#endif
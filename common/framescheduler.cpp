@@ -0,0 +1,79 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "framescheduler.hpp"
+
+void FrameScheduler::invalidate(void)
+{
+    mPendingFrames = 2;
+    mActivity      = true;
+}
+
+void FrameScheduler::animate(void)
+{
+    mAnimating = true;
+}
+
+bool FrameScheduler::idle(void) const
+{
+    return mNow - mLastActivity >= IDLE_DELAY;
+}
+
+bool FrameScheduler::beginFrame(uint64_t now)
+{
+    mNow = now;
+    if (mActivity) {
+        mLastActivity = now;
+        mActivity     = false;
+    }
+
+    // animations drawn on the last frame keep it going, the periodic refresh
+    // picks up background changes nobody invalidated the frame for
+    if (mPendingFrames == 0 && !(mAnimating && !idle()) && now - mLastFrame < IDLE_REFRESH) {
+        mFramesSkipped++;
+        return false;
+    }
+
+    if (mPendingFrames > 0) {
+        mPendingFrames--;
+    }
+    mAnimating  = false;
+    mFrameStart = now;
+    return true;
+}
+
+void FrameScheduler::endFrame(uint64_t now)
+{
+    mLastFrame        = now;
+    mFrameTime        = now - mFrameStart;
+    mAverageFrameTime = mFramesDrawn == 0 ? mFrameTime : mAverageFrameTime * 0.95f + mFrameTime * 0.05f;
+    mFramesDrawn++;
+}
+
+uint32_t FrameScheduler::sleepTime(void) const
+{
+    return idle() ? IDLE_POLL : ACTIVE_POLL;
+}
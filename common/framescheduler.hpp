@@ -0,0 +1,87 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef FRAMESCHEDULER_HPP
+#define FRAMESCHEDULER_HPP
+
+#include <stdint.h>
+
+// decides whether a frame has to be composed: the main loops invalidate it on
+// input and background activity, animations keep it running until the app
+// goes idle, after which the screen is only refreshed at a low rate
+class FrameScheduler {
+public:
+    static FrameScheduler& getInstance(void)
+    {
+        static FrameScheduler mScheduler;
+        return mScheduler;
+    }
+
+    // the next frames have to be drawn, state changed during update only
+    // shows up on the frame after the current one
+    void invalidate(void);
+    // the frame being drawn contains an animation
+    void animate(void);
+    // animations freeze once nothing happened for a while
+    bool idle(void) const;
+
+    // now is a monotonic time in milliseconds
+    bool beginFrame(uint64_t now);
+    void endFrame(uint64_t now);
+    // how long the main loop should wait after a skipped frame
+    uint32_t sleepTime(void) const;
+
+    uint64_t framesDrawn(void) const { return mFramesDrawn; }
+    uint64_t framesSkipped(void) const { return mFramesSkipped; }
+    float frameTime(void) const { return mFrameTime; }
+    float averageFrameTime(void) const { return mAverageFrameTime; }
+
+    static constexpr uint32_t IDLE_DELAY   = 10000;
+    static constexpr uint32_t IDLE_REFRESH = 1000;
+    static constexpr uint32_t IDLE_POLL    = 50;
+    static constexpr uint32_t ACTIVE_POLL  = 16;
+
+private:
+    FrameScheduler(void) {}
+    ~FrameScheduler(void) {}
+
+    FrameScheduler(FrameScheduler const&) = delete;
+    void operator=(FrameScheduler const&) = delete;
+
+    int mPendingFrames      = 2;
+    bool mActivity          = true;
+    bool mAnimating         = false;
+    uint64_t mNow           = 0;
+    uint64_t mLastActivity  = 0;
+    uint64_t mLastFrame     = 0;
+    uint64_t mFrameStart    = 0;
+    uint64_t mFramesDrawn   = 0;
+    uint64_t mFramesSkipped = 0;
+    float mFrameTime        = 0;
+    float mAverageFrameTime = 0;
+};
+
+#endif
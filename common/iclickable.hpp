@@ -57,7 +57,7 @@ public:
         mColorText = text;
     }
 
-    std::string text(void) { return mText; }
+    const std::string& text(void) const { return mText; }
 
     void text(const std::string& v) { mText = v; }
 
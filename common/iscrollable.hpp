@@ -57,6 +57,23 @@ public:
         mCells.clear();
     }
 
+    // reuses the existing cells and only touches the rows whose text changed
+    void assign(const std::vector<std::string>& messages, T color, T colorMessage)
+    {
+        while (size() > messages.size()) {
+            delete mCells.back();
+            mCells.pop_back();
+        }
+        for (size_t i = 0; i < size(); i++) {
+            if (mCells[i]->text() != messages[i]) {
+                mCells[i]->text(messages[i]);
+            }
+        }
+        for (size_t i = size(); i < messages.size(); i++) {
+            push_back(color, colorMessage, messages[i], false);
+        }
+    }
+
     size_t size(void) const { return mCells.size(); }
 
     size_t maxVisibleEntries(void)
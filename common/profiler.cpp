@@ -0,0 +1,136 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "profiler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <string.h>
+
+uint64_t Profiler::now(void)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Profiler::StageId Profiler::stage(const char* name)
+{
+    const size_t count = mStageCount.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; i++) {
+        if (mStages[i].key == name) {
+            return i;
+        }
+    }
+
+    // a new stage, or the same name from another literal
+    std::lock_guard<std::mutex> lock(mMutex);
+    const size_t created = mStageCount.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < created; i++) {
+        if (strcmp(mStages[i].name.c_str(), name) == 0) {
+            return i;
+        }
+    }
+    if (created == MAX_STAGES) {
+        return NO_STAGE;
+    }
+
+    Stage& s = mStages[created];
+    s.key    = name;
+    s.name   = name;
+    s.pending.store(0, std::memory_order_relaxed);
+    std::fill(s.samples, s.samples + HISTORY_SIZE, 0.0f);
+    mStageCount.store(created + 1, std::memory_order_release);
+    return created;
+}
+
+void Profiler::add(StageId stage, uint64_t elapsed)
+{
+    if (stage < MAX_STAGES) {
+        mStages[stage].pending.fetch_add((uint32_t)elapsed, std::memory_order_relaxed);
+    }
+}
+
+void Profiler::endFrame(void)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    const size_t count = mStageCount.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; i++) {
+        mStages[i].samples[mCursor] = mStages[i].pending.exchange(0, std::memory_order_relaxed) / 1000.0f;
+    }
+    mCursor = (mCursor + 1) % HISTORY_SIZE;
+    mFrames++;
+
+    // the report is read by the overlay, keeping it steady keeps its labels readable
+    if (mFrames % REPORT_INTERVAL == 1) {
+        mReport.clear();
+        for (size_t i = 0; i < count; i++) {
+            mReport.push_back({mStages[i].name, stats(mStages[i])});
+        }
+    }
+}
+
+Profiler::Stats Profiler::stats(const Stage& stage) const
+{
+    const size_t count = std::min(mFrames, HISTORY_SIZE);
+    std::vector<float> samples;
+    samples.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        samples.push_back(stage.samples[(mCursor + HISTORY_SIZE - count + i) % HISTORY_SIZE]);
+    }
+
+    Stats ret = {samples.back(), samples[0], 0.0f, 0.0f};
+    for (float sample : samples) {
+        ret.min = std::min(ret.min, sample);
+        ret.avg += sample;
+    }
+    ret.avg /= count;
+
+    auto p99 = samples.begin() + (count - 1) * 99 / 100;
+    std::nth_element(samples.begin(), p99, samples.end());
+    ret.p99 = *p99;
+    return ret;
+}
+
+std::vector<std::pair<std::string, Profiler::Stats>> Profiler::report(void) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mReport;
+}
+
+std::vector<float> Profiler::history(const char* stage) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::vector<float> ret;
+    for (size_t i = 0, count = mStageCount.load(std::memory_order_acquire); i < count; i++) {
+        const Stage& s = mStages[i];
+        if (s.name == stage) {
+            const size_t count = std::min(mFrames, HISTORY_SIZE);
+            for (size_t i = 0; i < count; i++) {
+                ret.push_back(s.samples[(mCursor + HISTORY_SIZE - count + i) % HISTORY_SIZE]);
+            }
+            break;
+        }
+    }
+    return ret;
+}
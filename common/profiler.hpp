@@ -0,0 +1,130 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <atomic>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+// per frame timings of named stages: scopes add the time they took to the
+// frame being measured, the main loop closes it once the frame is presented.
+// scopes only measure while the overlay is shown
+class Profiler {
+public:
+    typedef size_t StageId;
+    static constexpr StageId NO_STAGE = (StageId)-1;
+
+    struct Stats {
+        float last;
+        float min;
+        float avg;
+        float p99;
+    };
+
+    static Profiler& getInstance(void)
+    {
+        static Profiler mProfiler;
+        return mProfiler;
+    }
+
+    // monotonic time in microseconds
+    static uint64_t now(void);
+
+    // the id of a stage, created on first use. call sites pass the same literal
+    // every time, it is found by its address without locking
+    StageId stage(const char* name);
+    // any thread may report to a stage, without locking
+    void add(StageId stage, uint64_t elapsed);
+    void add(const char* stage, uint64_t elapsed) { add(this->stage(stage), elapsed); }
+    void endFrame(void);
+
+    // milliseconds over the last HISTORY_SIZE frames, refreshed every REPORT_INTERVAL frames
+    std::vector<std::pair<std::string, Stats>> report(void) const;
+    // per frame totals of a stage in milliseconds, oldest first
+    std::vector<float> history(const char* stage) const;
+
+    bool visible(void) const { return mVisible.load(std::memory_order_relaxed); }
+    void toggle(void) { mVisible.store(!visible(), std::memory_order_relaxed); }
+
+    static constexpr size_t HISTORY_SIZE    = 120;
+    static constexpr size_t REPORT_INTERVAL = 30;
+    static constexpr size_t MAX_STAGES      = 16;
+
+private:
+    Profiler(void) {}
+    ~Profiler(void) {}
+
+    Profiler(Profiler const&) = delete;
+    void operator=(Profiler const&) = delete;
+
+    // name and key are set before the stage is counted and never change after
+    struct Stage {
+        const char* key;
+        std::string name;
+        // microseconds, 64 bit atomics aren't lock free on every console
+        std::atomic<uint32_t> pending;
+        float samples[HISTORY_SIZE];
+    };
+
+    Stats stats(const Stage& stage) const;
+
+    // guards the samples and the creation of stages
+    mutable std::mutex mMutex;
+    Stage mStages[MAX_STAGES];
+    std::atomic<size_t> mStageCount{0};
+    std::vector<std::pair<std::string, Stats>> mReport;
+    size_t mCursor = 0;
+    size_t mFrames = 0;
+    std::atomic<bool> mVisible{false};
+};
+
+// adds the lifetime of the scope to a stage, costs a flag check while the overlay is hidden
+class ProfileScope {
+public:
+    ProfileScope(const char* stage)
+        : mStage(Profiler::getInstance().visible() ? Profiler::getInstance().stage(stage) : Profiler::NO_STAGE),
+          mStart(mStage != Profiler::NO_STAGE ? Profiler::now() : 0)
+    {
+    }
+    ~ProfileScope(void)
+    {
+        if (mStage != Profiler::NO_STAGE) {
+            Profiler::getInstance().add(mStage, Profiler::now() - mStart);
+        }
+    }
+
+private:
+    Profiler::StageId mStage;
+    uint64_t mStart;
+};
+
+#endif
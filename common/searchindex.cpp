@@ -0,0 +1,129 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "searchindex.hpp"
+#include <stdio.h>
+
+std::string SearchIndex::normalize(const std::string& str)
+{
+    std::string ret = str;
+    for (size_t i = 0, sz = ret.length(); i < sz; i++) {
+        if (ret[i] >= 'A' && ret[i] <= 'Z') {
+            ret[i] += 'a' - 'A';
+        }
+    }
+    return ret;
+}
+
+uint32_t SearchIndex::trigram(const char* str)
+{
+    return (uint8_t)str[0] | ((uint8_t)str[1] << 8) | ((uint8_t)str[2] << 16);
+}
+
+void SearchIndex::clear(void)
+{
+    mKeys.clear();
+    mTrigrams.clear();
+    mLastQuery.clear();
+    mLastResults.clear();
+}
+
+void SearchIndex::add(const std::string& name, uint64_t id)
+{
+    char hexId[17];
+    snprintf(hexId, sizeof(hexId), "%016llx", (unsigned long long)id);
+
+    // the separator keeps queries from matching across the name and the id
+    const size_t index = mKeys.size();
+    mKeys.push_back(normalize(name) + '\n' + hexId);
+
+    const std::string& key = mKeys.back();
+    for (size_t i = 0; i + 3 <= key.length(); i++) {
+        std::vector<size_t>& postings = mTrigrams[trigram(key.c_str() + i)];
+        if (postings.empty() || postings.back() != index) {
+            postings.push_back(index);
+        }
+    }
+
+    mLastQuery.clear();
+    mLastResults.clear();
+}
+
+std::vector<size_t> SearchIndex::find(const std::string& query)
+{
+    const std::string q = normalize(query);
+    std::vector<size_t> results;
+
+    if (q.empty()) {
+        results.resize(mKeys.size());
+        for (size_t i = 0; i < results.size(); i++) {
+            results[i] = i;
+        }
+        return results;
+    }
+
+    if (!mLastQuery.empty() && q.find(mLastQuery) != std::string::npos) {
+        // every match of the new query also matched the previous one
+        for (size_t i : mLastResults) {
+            if (mKeys[i].find(q) != std::string::npos) {
+                results.push_back(i);
+            }
+        }
+    }
+    else if (q.length() >= 3) {
+        // only verify the entries sharing the query's rarest trigram
+        const std::vector<size_t>* candidates = nullptr;
+        for (size_t i = 0; i + 3 <= q.length(); i++) {
+            auto it = mTrigrams.find(trigram(q.c_str() + i));
+            if (it == mTrigrams.end()) {
+                candidates = nullptr;
+                break;
+            }
+            if (candidates == nullptr || it->second.size() < candidates->size()) {
+                candidates = &it->second;
+            }
+        }
+
+        if (candidates != nullptr) {
+            for (size_t i : *candidates) {
+                if (mKeys[i].find(q) != std::string::npos) {
+                    results.push_back(i);
+                }
+            }
+        }
+    }
+    else {
+        for (size_t i = 0, sz = mKeys.size(); i < sz; i++) {
+            if (mKeys[i].find(q) != std::string::npos) {
+                results.push_back(i);
+            }
+        }
+    }
+
+    mLastQuery   = q;
+    mLastResults = results;
+    return results;
+}
@@ -0,0 +1,56 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef SEARCHINDEX_HPP
+#define SEARCHINDEX_HPP
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Substring index over title names and title ids. Entries are identified by
+// their insertion order; names are expected to be already stripped of accents.
+class SearchIndex {
+public:
+    void clear(void);
+    void add(const std::string& name, uint64_t id);
+    // returns the matching entries in insertion order
+    std::vector<size_t> find(const std::string& query);
+    size_t size(void) const { return mKeys.size(); }
+
+private:
+    static std::string normalize(const std::string& str);
+    static uint32_t trigram(const char* str);
+
+    std::vector<std::string> mKeys;
+    std::unordered_map<uint32_t, std::vector<size_t>> mTrigrams;
+    // typing usually extends the previous query, so its results are kept to narrow them down
+    std::string mLastQuery;
+    std::vector<size_t> mLastResults;
+};
+
+#endif
@@ -0,0 +1,387 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "tar.hpp"
+#include <algorithm>
+#include <string.h>
+#include <sys/stat.h>
+
+static void octal(char* field, size_t size, uint64_t value)
+{
+    // size - 1 digits, zero padded and terminated
+    snprintf(field, size, "%0*llo", (int)size - 1, (unsigned long long)value);
+}
+
+static uint64_t parseOctal(const char* field, size_t size)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < size && field[i] >= '0' && field[i] <= '7'; i++) {
+        value = (value << 3) | (field[i] - '0');
+    }
+    return value;
+}
+
+static unsigned checksum(const char* block)
+{
+    // the checksum field itself counts as spaces
+    unsigned sum = 0;
+    for (size_t i = 0; i < TAR_BLOCK_SIZE; i++) {
+        sum += (i >= 148 && i < 156) ? ' ' : (unsigned char)block[i];
+    }
+    return sum;
+}
+
+// names longer than the name field are split at a slash into the prefix field,
+// returns where the name field starts or npos if the name doesn't fit
+static size_t splitName(const std::string& name)
+{
+    if (name.length() <= 100) {
+        return 0;
+    }
+    size_t split = name.rfind('/', 155);
+    if (split == std::string::npos || name.length() - split - 1 > 100) {
+        return std::string::npos;
+    }
+    return split + 1;
+}
+
+static int64_t treeSize(const std::string& root, const std::string& prefix, size_t* files)
+{
+    DIR* dir = opendir(root.c_str());
+    if (dir == NULL) {
+        return -1;
+    }
+
+    int64_t size = 0;
+    struct dirent* entry;
+    while (size >= 0 && (entry = readdir(dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+
+        const std::string name = prefix + entry->d_name;
+        const std::string path = root + "/" + entry->d_name;
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) {
+            size = -1;
+        }
+        else if (S_ISDIR(st.st_mode)) {
+            const int64_t tree = splitName(name + "/") != std::string::npos ? treeSize(path, name + "/", files) : -1;
+            size               = tree >= 0 ? size + TAR_BLOCK_SIZE + tree : -1;
+        }
+        else if (splitName(name) == std::string::npos) {
+            size = -1;
+        }
+        else {
+            // a header followed by the data padded to a whole block
+            size += TAR_BLOCK_SIZE + (st.st_size + TAR_BLOCK_SIZE - 1) / TAR_BLOCK_SIZE * TAR_BLOCK_SIZE;
+            if (files != NULL) {
+                (*files)++;
+            }
+        }
+    }
+    closedir(dir);
+    return size;
+}
+
+TarWriter::TarWriter(const std::string& root)
+    : mRoot(root), mFile(NULL), mRemaining(0), mPadding(0), mBlockPos(0), mBlockSize(0), mDone(false)
+{
+    DIR* dir = opendir(root.c_str());
+    if (dir != NULL) {
+        mLevels.push_back({dir, ""});
+    }
+}
+
+TarWriter::~TarWriter(void)
+{
+    if (mFile != NULL) {
+        fclose(mFile);
+    }
+    for (auto& level : mLevels) {
+        closedir(level.dir);
+    }
+}
+
+bool TarWriter::header(const std::string& name, const struct stat& st, char type)
+{
+    memset(mBlock, 0, TAR_BLOCK_SIZE);
+    size_t split = splitName(name);
+    if (split == std::string::npos) {
+        return false;
+    }
+    if (split > 0) {
+        memcpy(mBlock + 345, name.c_str(), split - 1);
+    }
+    memcpy(mBlock, name.c_str() + split, name.length() - split);
+
+    octal(mBlock + 100, 8, type == '5' ? 0755 : 0644);
+    octal(mBlock + 108, 8, 0);
+    octal(mBlock + 116, 8, 0);
+    octal(mBlock + 124, 12, type == '5' ? 0 : st.st_size);
+    octal(mBlock + 136, 12, st.st_mtime);
+    mBlock[156] = type;
+    memcpy(mBlock + 257, "ustar", 6);
+    memcpy(mBlock + 263, "00", 2);
+    snprintf(mBlock + 148, 8, "%06o", checksum(mBlock));
+
+    mBlockPos  = 0;
+    mBlockSize = TAR_BLOCK_SIZE;
+    return true;
+}
+
+bool TarWriter::nextEntry(void)
+{
+    while (!mLevels.empty()) {
+        Level& level         = mLevels.back();
+        struct dirent* entry = readdir(level.dir);
+        if (entry == NULL) {
+            closedir(level.dir);
+            mLevels.pop_back();
+            continue;
+        }
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+
+        const std::string name = level.path + entry->d_name;
+        const std::string path = mRoot + "/" + name;
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) {
+            return false;
+        }
+
+        if (S_ISDIR(st.st_mode)) {
+            DIR* dir = opendir(path.c_str());
+            if (dir == NULL || !header(name + "/", st, '5')) {
+                if (dir != NULL) {
+                    closedir(dir);
+                }
+                return false;
+            }
+            mLevels.push_back({dir, name + "/"});
+        }
+        else {
+            mFile = fopen(path.c_str(), "rb");
+            if (mFile == NULL || !header(name, st, '0')) {
+                return false;
+            }
+            mRemaining = st.st_size;
+            mPadding   = (TAR_BLOCK_SIZE - st.st_size % TAR_BLOCK_SIZE) % TAR_BLOCK_SIZE;
+        }
+        return true;
+    }
+
+    // two zero blocks mark the end of the archive
+    memset(mBlock, 0, sizeof(mBlock));
+    mBlockPos  = 0;
+    mBlockSize = sizeof(mBlock);
+    mDone      = true;
+    return true;
+}
+
+int64_t TarWriter::size(const std::string& root, size_t* files)
+{
+    if (files != NULL) {
+        *files = 0;
+    }
+    // the tree is followed by two zero blocks
+    const int64_t size = treeSize(root, "", files);
+    return size >= 0 ? size + 2 * TAR_BLOCK_SIZE : -1;
+}
+
+void TarWriter::closeFile(void)
+{
+    // the file data is padded to a whole block
+    fclose(mFile);
+    mFile = NULL;
+    memset(mBlock, 0, TAR_BLOCK_SIZE);
+    mBlockPos  = 0;
+    mBlockSize = mPadding;
+}
+
+bool TarWriter::skip(uint64_t size)
+{
+    while (size > 0) {
+        if (mBlockPos < mBlockSize) {
+            const size_t n = std::min(size, (uint64_t)(mBlockSize - mBlockPos));
+            mBlockPos += n;
+            size -= n;
+        }
+        else if (mFile != NULL) {
+            const uint64_t n = std::min(size, mRemaining);
+            if (fseeko(mFile, n, SEEK_CUR) != 0) {
+                return false;
+            }
+            mRemaining -= n;
+            size -= n;
+            if (mRemaining == 0) {
+                closeFile();
+            }
+        }
+        else if (mDone || !nextEntry()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+ssize_t TarWriter::read(char* buf, size_t size)
+{
+    size_t written = 0;
+    while (written < size) {
+        if (mBlockPos < mBlockSize) {
+            const size_t n = std::min(size - written, mBlockSize - mBlockPos);
+            memcpy(buf + written, mBlock + mBlockPos, n);
+            mBlockPos += n;
+            written += n;
+        }
+        else if (mFile != NULL) {
+            const size_t n = fread(buf + written, 1, std::min((uint64_t)(size - written), mRemaining), mFile);
+            if (n == 0 && mRemaining > 0) {
+                return -1;
+            }
+            mRemaining -= n;
+            written += n;
+            if (mRemaining == 0) {
+                closeFile();
+            }
+        }
+        else if (mDone || !nextEntry()) {
+            break;
+        }
+    }
+    if (written == 0 && !mDone) {
+        return -1;
+    }
+    return written;
+}
+
+TarReader::TarReader(const std::string& root)
+    : mRoot(root), mBlockPos(0), mFile(NULL), mRemaining(0), mPadding(0), mFiles(0), mFailed(false), mFinished(false)
+{
+}
+
+TarReader::~TarReader(void)
+{
+    if (mFile != NULL) {
+        fclose(mFile);
+    }
+}
+
+bool TarReader::header(void)
+{
+    bool empty = true;
+    for (size_t i = 0; i < TAR_BLOCK_SIZE && empty; i++) {
+        empty = mBlock[i] == 0;
+    }
+    if (empty) {
+        mFinished = true;
+        return true;
+    }
+    if (parseOctal(mBlock + 148, 8) != checksum(mBlock)) {
+        return false;
+    }
+
+    std::string name(mBlock, strnlen(mBlock, 100));
+    if (memcmp(mBlock + 257, "ustar", 6) == 0 && mBlock[345] != 0) {
+        name = std::string(mBlock + 345, strnlen(mBlock + 345, 155)) + "/" + name;
+    }
+    while (name.compare(0, 2, "./") == 0) {
+        name.erase(0, 2);
+    }
+    if (name.empty() || name[0] == '/' || name == "." || ("/" + name + "/").find("/../") != std::string::npos) {
+        return name == "." || name.empty();
+    }
+
+    const uint64_t size = parseOctal(mBlock + 124, 12);
+    const char type     = mBlock[156];
+    mRemaining          = size;
+    mPadding            = (TAR_BLOCK_SIZE - size % TAR_BLOCK_SIZE) % TAR_BLOCK_SIZE;
+
+    // every missing parent is created, archives don't have to list directories first
+    const std::string path = mRoot + "/" + name;
+    if (type == '5' || type == '0' || type == '\0') {
+        for (size_t pos = mRoot.length() + 1; (pos = path.find('/', pos)) != std::string::npos; pos++) {
+            mkdir(path.substr(0, pos).c_str(), 0777);
+        }
+    }
+
+    if (type == '5') {
+        mkdir(path.c_str(), 0777);
+    }
+    else if (type == '0' || type == '\0') {
+        mFile = fopen(path.c_str(), "wb");
+        if (mFile == NULL) {
+            return false;
+        }
+        mFiles++;
+        if (size == 0) {
+            fclose(mFile);
+            mFile = NULL;
+        }
+    }
+    // other entries, like pax headers and links, are skipped along with their data
+    return true;
+}
+
+bool TarReader::write(const char* data, size_t size)
+{
+    while (size > 0 && !mFailed && !mFinished) {
+        if (mRemaining > 0) {
+            const size_t n = std::min((uint64_t)size, mRemaining);
+            if (mFile != NULL && fwrite(data, 1, n, mFile) != n) {
+                mFailed = true;
+                break;
+            }
+            mRemaining -= n;
+            data += n;
+            size -= n;
+            if (mRemaining == 0 && mFile != NULL) {
+                mFailed = fclose(mFile) != 0;
+                mFile   = NULL;
+            }
+        }
+        else if (mPadding > 0) {
+            const size_t n = std::min((uint64_t)size, mPadding);
+            mPadding -= n;
+            data += n;
+            size -= n;
+        }
+        else {
+            const size_t n = std::min(size, TAR_BLOCK_SIZE - mBlockPos);
+            memcpy(mBlock + mBlockPos, data, n);
+            mBlockPos += n;
+            data += n;
+            size -= n;
+            if (mBlockPos == TAR_BLOCK_SIZE) {
+                mBlockPos = 0;
+                mFailed   = !header();
+            }
+        }
+    }
+    return !mFailed;
+}
@@ -0,0 +1,103 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef TAR_HPP
+#define TAR_HPP
+
+#include <dirent.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+#define TAR_BLOCK_SIZE 512
+
+// produces a ustar archive of a directory tree on demand: the tree is walked
+// and the files are read as the archive is consumed, so that a backup can be
+// streamed without ever holding more than one block of it in memory
+class TarWriter {
+public:
+    TarWriter(const std::string& root);
+    ~TarWriter(void);
+
+    // fills buf with the next bytes of the archive, returns 0 once the
+    // archive is complete and -1 if the tree couldn't be read
+    ssize_t read(char* buf, size_t size);
+    // moves past the next size bytes of the archive without reading the
+    // files they cover, false past the end or if the tree couldn't be read
+    bool skip(uint64_t size);
+
+    // the exact length of the archive of a tree, found by walking it without
+    // reading any file, -1 if the tree couldn't be walked or can't be archived
+    static int64_t size(const std::string& root, size_t* files = NULL);
+
+private:
+    bool nextEntry(void);
+    void closeFile(void);
+    bool header(const std::string& name, const struct stat& st, char type);
+
+    struct Level {
+        DIR* dir;
+        std::string path;
+    };
+
+    std::string mRoot;
+    std::vector<Level> mLevels;
+    FILE* mFile;
+    uint64_t mRemaining, mPadding;
+    char mBlock[TAR_BLOCK_SIZE * 2];
+    size_t mBlockPos, mBlockSize;
+    bool mDone;
+};
+
+// extracts a ustar archive into a directory as it is received, entries that
+// would end up outside of the directory are rejected
+class TarReader {
+public:
+    TarReader(const std::string& root);
+    ~TarReader(void);
+
+    // returns false once the archive turned out to be malformed or a file
+    // couldn't be written, further data is ignored
+    bool write(const char* data, size_t size);
+    // the end of archive marker has been received
+    bool finished(void) const { return mFinished; }
+    size_t files(void) const { return mFiles; }
+
+private:
+    bool header(void);
+
+    std::string mRoot;
+    char mBlock[TAR_BLOCK_SIZE];
+    size_t mBlockPos;
+    FILE* mFile;
+    uint64_t mRemaining, mPadding;
+    size_t mFiles;
+    bool mFailed, mFinished;
+};
+
+#endif
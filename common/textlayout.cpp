@@ -0,0 +1,114 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "textlayout.hpp"
+#include <stdio.h>
+#include <unordered_map>
+
+#define WRAP_CACHE_SIZE 64
+
+std::vector<TextLine> TextLayout::wrap(const char* text, size_t length, float maxWidth, TextMetrics& metrics, float scale)
+{
+    std::vector<TextLine> lines;
+    const char* end  = text + length;
+    size_t lineStart = 0;
+    float lineWidth  = 0.0f;
+    // last run of spaces of the line, and the line width before and after it
+    size_t breakPos    = std::string::npos;
+    size_t breakEnd    = 0;
+    float widthAtBreak = 0.0f, widthAfterBreak = 0.0f;
+
+    for (const char* c = text; c < end;) {
+        const size_t pos         = c - text;
+        const uint32_t codepoint = (uint8_t)*c < 0x80 ? (uint8_t)*c++ : UTF8::decode(c, end);
+        if (codepoint == '\n') {
+            lines.push_back({lineStart, pos - lineStart, lineWidth});
+            lineStart = c - text;
+            lineWidth = 0.0f;
+            breakPos  = std::string::npos;
+            continue;
+        }
+
+        const float width = metrics.charWidth(codepoint) * scale;
+        if (codepoint == ' ') {
+            // trailing spaces never push a line over the limit
+            if (breakPos == std::string::npos || breakEnd != pos) {
+                breakPos     = pos;
+                widthAtBreak = lineWidth;
+            }
+            breakEnd        = pos + 1;
+            widthAfterBreak = lineWidth + width;
+            lineWidth       = widthAfterBreak;
+            continue;
+        }
+
+        if (lineWidth + width > maxWidth && breakPos != std::string::npos) {
+            lines.push_back({lineStart, breakPos - lineStart, widthAtBreak});
+            lineStart = breakEnd;
+            lineWidth = lineWidth - widthAfterBreak;
+            breakPos  = std::string::npos;
+        }
+        if (lineWidth + width > maxWidth && pos > lineStart) {
+            lines.push_back({lineStart, pos - lineStart, lineWidth});
+            lineStart = pos;
+            lineWidth = 0.0f;
+        }
+        lineWidth += width;
+    }
+    lines.push_back({lineStart, length - lineStart, lineWidth});
+
+    return lines;
+}
+
+const std::vector<TextLine>& TextLayout::wrap(const std::string& text, float maxWidth, TextMetrics& metrics, float scale)
+{
+    static std::unordered_map<std::string, std::vector<TextLine>> cache;
+    if (cache.size() > WRAP_CACHE_SIZE) {
+        cache.clear();
+    }
+
+    char prefix[64];
+    snprintf(prefix, sizeof(prefix), "%p:%a:%a:", (void*)&metrics, maxWidth, scale);
+    const std::string key = prefix + text;
+    auto it               = cache.find(key);
+    if (it == cache.end()) {
+        it = cache.emplace(key, wrap(text.c_str(), text.length(), maxWidth, metrics, scale)).first;
+    }
+    return it->second;
+}
+
+std::string TextLayout::join(const std::string& text, const std::vector<TextLine>& lines)
+{
+    std::string ret;
+    ret.reserve(text.length() + lines.size());
+    for (size_t i = 0, sz = lines.size(); i < sz; i++) {
+        if (i > 0) {
+            ret += '\n';
+        }
+        ret.append(text, lines[i].offset, lines[i].length);
+    }
+    return ret;
+}
@@ -0,0 +1,51 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef TEXTLAYOUT_HPP
+#define TEXTLAYOUT_HPP
+
+#include "textmetrics.hpp"
+#include <string>
+#include <vector>
+
+struct TextLine {
+    size_t offset;
+    size_t length;
+    float width;
+};
+
+namespace TextLayout {
+    // Greedy word wrapping in a single pass: every glyph is measured once and
+    // the last space of the current line is kept as its break opportunity.
+    // Words wider than maxWidth are split between glyphs.
+    std::vector<TextLine> wrap(const char* text, size_t length, float maxWidth, TextMetrics& metrics, float scale);
+    // same as above, results are cached per (text, width, scale, metrics)
+    const std::vector<TextLine>& wrap(const std::string& text, float maxWidth, TextMetrics& metrics, float scale);
+    // joins the lines with '\n', for renderers that take a single string
+    std::string join(const std::string& text, const std::vector<TextLine>& lines);
+}
+
+#endif
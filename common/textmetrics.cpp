@@ -0,0 +1,123 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "textmetrics.hpp"
+
+uint32_t UTF8::decode(const char*& str, const char* end)
+{
+    const uint8_t c = *str;
+    if (c < 0x80) {
+        str++;
+        return c;
+    }
+
+    size_t length;
+    uint32_t codepoint;
+    if ((c & 0xE0) == 0xC0) {
+        length    = 2;
+        codepoint = c & 0x1F;
+    }
+    else if ((c & 0xF0) == 0xE0) {
+        length    = 3;
+        codepoint = c & 0x0F;
+    }
+    else if ((c & 0xF8) == 0xF0) {
+        length    = 4;
+        codepoint = c & 0x07;
+    }
+    else {
+        str++;
+        return 0xFFFD;
+    }
+
+    if ((size_t)(end - str) < length) {
+        str++;
+        return 0xFFFD;
+    }
+    for (size_t i = 1; i < length; i++) {
+        if ((str[i] & 0xC0) != 0x80) {
+            str++;
+            return 0xFFFD;
+        }
+        codepoint = codepoint << 6 | (str[i] & 0x3F);
+    }
+
+    // overlong forms, surrogates and values past U+10FFFF are not characters
+    static const uint32_t minimum[] = {0, 0, 0x80, 0x800, 0x10000};
+    if (codepoint < minimum[length] || codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF)) {
+        str++;
+        return 0xFFFD;
+    }
+
+    str += length;
+    return codepoint;
+}
+
+float TextMetrics::loadWidth(uint32_t codepoint)
+{
+    if (codepoint > 0xFFFF) {
+        return mProvider(codepoint);
+    }
+
+    std::unique_ptr<float[]>& page = mPages[codepoint >> PAGE_BITS];
+    if (!page) {
+        page = std::make_unique<float[]>(PAGE_SIZE);
+        for (size_t i = 0; i < PAGE_SIZE; i++) {
+            page[i] = -1.0f;
+        }
+    }
+
+    float& width = page[codepoint & (PAGE_SIZE - 1)];
+    if (width < 0) {
+        width = mProvider(codepoint);
+    }
+    return width;
+}
+
+float TextMetrics::width(const char* text, size_t length, float scale)
+{
+    const char* end  = text + length;
+    float line       = 0.0f;
+    float widestLine = 0.0f;
+    while (text < end) {
+        const uint32_t codepoint = (uint8_t)*text < 0x80 ? (uint8_t)*text++ : UTF8::decode(text, end);
+        if (codepoint == '\n') {
+            widestLine = line > widestLine ? line : widestLine;
+            line       = 0.0f;
+        }
+        else {
+            line += charWidth(codepoint) * scale;
+        }
+    }
+    return line > widestLine ? line : widestLine;
+}
+
+void TextMetrics::clear(void)
+{
+    for (auto& page : mPages) {
+        page.reset();
+    }
+}
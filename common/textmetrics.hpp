@@ -0,0 +1,75 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef TEXTMETRICS_HPP
+#define TEXTMETRICS_HPP
+
+#include <functional>
+#include <memory>
+#include <stdint.h>
+#include <string>
+
+namespace UTF8 {
+    // decodes the codepoint at str and moves past it, malformed sequences
+    // (including overlong forms and surrogates) yield U+FFFD and consume a single byte
+    uint32_t decode(const char*& str, const char* end);
+}
+
+// Glyph advance widths, looked up through a two level table over the BMP whose
+// pages are filled lazily from the font provider.
+class TextMetrics {
+public:
+    typedef std::function<float(uint32_t codepoint)> WidthProvider;
+
+    TextMetrics(WidthProvider provider) : mProvider(provider) {}
+
+    float charWidth(uint32_t codepoint)
+    {
+        if (codepoint <= 0xFFFF) {
+            const float* page = mPages[codepoint >> PAGE_BITS].get();
+            if (page != nullptr && page[codepoint & (PAGE_SIZE - 1)] >= 0) {
+                return page[codepoint & (PAGE_SIZE - 1)];
+            }
+        }
+        return loadWidth(codepoint);
+    }
+    // width of the widest line, measured in a single pass
+    float width(const char* text, size_t length, float scale);
+    float width(const std::string& text, float scale) { return width(text.c_str(), text.length(), scale); }
+    void clear(void);
+
+private:
+    float loadWidth(uint32_t codepoint);
+
+    static constexpr size_t PAGE_BITS = 8;
+    static constexpr size_t PAGE_SIZE = 1 << PAGE_BITS;
+    static constexpr size_t PAGES     = 0x10000 / PAGE_SIZE;
+
+    WidthProvider mProvider;
+    std::unique_ptr<float[]> mPages[PAGES];
+};
+
+#endif
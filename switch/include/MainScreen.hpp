@@ -32,6 +32,7 @@
 #include "InfoOverlay.hpp"
 #include "Screen.hpp"
 #include "YesNoOverlay.hpp"
+#include "benchmark.hpp"
 #include "clickable.hpp"
 #include "hid.hpp"
 #include "io.hpp"
@@ -65,7 +66,10 @@ protected:
     bool getPKSMBridgeFlag(void) const;
     void setPKSMBridgeFlag(bool f);
     void updateButtons(void);
+    // replays scrolling, overlays and multiselection, toggled with - and up
+    void runBenchmark(void);
     std::string sortMode(void) const;
+    void syncBackupList(void) const;
 
 private:
     entryType_t type;
@@ -75,6 +79,12 @@ private:
     std::unique_ptr<Scrollable> backupList;
     std::unique_ptr<Clickable> buttonCheats, buttonBackup, buttonRestore;
     char ver[8];
+    // the selected title and its backup rows are only rebuilt when the selection or the title list changes
+    mutable Title selectedTitle;
+    mutable size_t selectedTitleIndex;
+    mutable AccountUid selectedTitleUser;
+    mutable u32 selectedTitleRevision;
+    mutable bool selectedTitleValid;
 };
 
 #endif
@@ -3,13 +3,23 @@
 
 #include "SDL_FontCache.h"
 #include "colors.hpp"
+#include "framescheduler.hpp"
 #include "logger.hpp"
 #include "main.hpp"
+#include "metrics.hpp"
+#include "profiler.hpp"
+#include "textlayout.hpp"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <set>
 #include <string>
 #include <switch.h>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 bool SDLH_Init(void);
 void SDLH_Exit(void);
@@ -23,11 +33,24 @@ void SDLH_DrawImage(SDL_Texture* texture, int x, int y);
 void SDLH_DrawImageScale(SDL_Texture* texture, int x, int y, int w, int h);
 void SDLH_DrawIcon(std::string icon, int x, int y);
 void SDLH_GetTextDimensions(int size, const char* text, u32* w, u32* h);
+// breaks text into lines no wider than maxWidth
+std::string SDLH_WrapText(int size, const std::string& text, int maxWidth);
 void SDLH_DrawTextBox(int size, int x, int y, SDL_Color color, int max, const char* text);
 void SDLH_Render(void);
+// title icons, downscaled when added and drawn in batches from shared atlas pages
+bool SDLH_AddAtlasIcon(u64 id, u8* buff, size_t size);
+bool SDLH_HasAtlasIcon(u64 id);
+void SDLH_QueueAtlasIcon(u64 id, int x, int y, int size);
+void SDLH_FlushAtlasIcons(void);
+// rasterizes the glyphs of the given text in the background
+void SDLH_PrewarmGlyphs(const std::string& text);
+// frames that had to rasterize glyphs while being drawn
+u32 SDLH_GlyphHitches(void);
 
 void drawOutline(u32 x, u32 y, u16 w, u16 h, u8 size, SDL_Color color);
 void drawPulsingOutline(u32 x, u32 y, u16 w, u16 h, u8 size, SDL_Color color);
+// stage timings of the last frames, toggled with - and down
+void drawProfiler(void);
 std::string trimToFit(const std::string& text, u32 maxsize, size_t textsize);
 
 #endif
\ No newline at end of file
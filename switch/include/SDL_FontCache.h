@@ -179,6 +179,15 @@ Uint8 FC_GetGlyphData(FC_Font* font, FC_GlyphData* result, Uint32 codepoint);
 /*! Sets the glyph data for the given codepoint.  Duplicates are not checked.  Returns a pointer to the stored data. */
 FC_GlyphData* FC_SetGlyphData(FC_Font* font, Uint32 codepoint, FC_GlyphData glyph_data);
 
+/*! Returns 1 if the codepoint is already stored in the font's glyph cache. */
+Uint8 FC_HasGlyph(FC_Font* font, Uint32 codepoint);
+
+/*! Packs a glyph rendered elsewhere (e.g. on another thread) into the glyph cache.  Must be called from the rendering thread. */
+Uint8 FC_AddGlyph(FC_Font* font, Uint32 codepoint, SDL_Surface* glyph_surface);
+
+/*! Returns the number of glyphs that had to be rasterized on demand while drawing. */
+Uint32 FC_GetRenderedGlyphCount(void);
+
 // Rendering
 
 FC_Rect FC_Draw(FC_Font* font, FC_Target* dest, float x, float y, const char* formatted_text, ...);
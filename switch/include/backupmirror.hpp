@@ -0,0 +1,68 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef BACKUPMIRROR_HPP
+#define BACKUPMIRROR_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// keeps a copy of the backup folder on the sync server configured in
+// config.json, on a worker thread so the ui never waits on the network
+class BackupMirror {
+public:
+    static BackupMirror& getInstance(void)
+    {
+        static BackupMirror mBackupMirror;
+        return mBackupMirror;
+    }
+
+    // mirrors the backups once the worker is free, requests made meanwhile are merged
+    void request(void);
+    void stop(void);
+
+private:
+    BackupMirror(void) : mRequested(false), mStop(false) {}
+    ~BackupMirror(void){};
+
+    BackupMirror(BackupMirror const&) = delete;
+    void operator=(BackupMirror const&) = delete;
+
+    void run(void);
+
+    std::thread mThread;
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::string mServer;
+    std::string mName;
+    bool mRequested;
+    std::atomic<bool> mStop;
+};
+
+#endif
@@ -0,0 +1,79 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef BRIDGEPROTOCOL_HPP
+#define BRIDGEPROTOCOL_HPP
+
+#include <functional>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <tuple>
+
+// framed transfers for the PKSM bridge. a v2 transfer is a fixed header
+// followed by the file itself, the receiver answers with a status word once
+// the payload has been written and verified:
+//
+//   magic    8 bytes  "PKSMBRDG"
+//   version  u32      BRIDGE_VERSION
+//   checksum u32      crc-32 of the payload
+//   length   u64      payload size in bytes
+//
+// all integers are big endian. older PKSM builds only understand the bare
+// file without header or status, senders have to be told to talk to them
+namespace Bridge {
+    static constexpr uint32_t BRIDGE_VERSION = 2;
+    static constexpr size_t HEADER_SIZE      = 24;
+    // size of the file <-> socket windows and of the socket buffers
+    static constexpr size_t WINDOW_SIZE = 0x40000;
+    // a transfer without progress for this long is aborted
+    static constexpr int TIMEOUT = 10000;
+    // no save the bridge handles comes close, a larger header is rejected before anything is written
+    static constexpr uint64_t MAX_LENGTH = 0x2000000;
+
+    enum Status : uint32_t { STATUS_OK = 0, STATUS_CHECKSUM = 1, STATUS_WRITE = 2 };
+
+    // polled while waiting on the socket, a transfer is aborted when it returns true
+    typedef std::function<bool(void)> Cancel;
+
+    uint32_t crc32(uint32_t crc, const void* data, size_t size);
+
+    // listens on port and waits for a single peer, returns the connected socket or -1
+    int accept(uint16_t port, const Cancel& cancel);
+    // returns the connected socket or -1
+    int connect(const std::string& address, uint16_t port, const Cancel& cancel);
+
+    // streams the file at path to the peer, then waits for it to confirm the
+    // checksum. a legacy transfer is the file alone, with nothing to confirm
+    std::tuple<bool, int, std::string> send(int fd, const std::string& path, bool legacy, const Cancel& cancel);
+    // receives a transfer into path. peers that don't send a v2 header are
+    // accepted as a raw stream of legacySize bytes when legacySize isn't 0.
+    // framed transfers longer than maxLength, or MAX_LENGTH, are refused.
+    // the data is written next to path and only moved in place once complete
+    std::tuple<bool, int, std::string> recv(int fd, const std::string& path, size_t legacySize, uint64_t maxLength, const Cancel& cancel);
+}
+
+#endif
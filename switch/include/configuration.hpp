@@ -27,9 +27,17 @@
 #ifndef CONFIGHANDLER_HPP
 #define CONFIGHANDLER_HPP
 
+#include "directory.hpp"
 #include "io.hpp"
 #include "json.hpp"
+#include "metrics.hpp"
+#include "operationfeed.hpp"
+#include "tar.hpp"
 #include "util.hpp"
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <poll.h>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -37,7 +45,7 @@ extern "C" {
 #include "mongoose.h"
 }
 
-#define CONFIG_VERSION 4
+#define CONFIG_VERSION 5
 
 class Configuration {
 public:
@@ -50,16 +58,29 @@ public:
     bool filter(u64 id);
     bool favorite(u64 id);
     bool isPKSMBridgeEnabled(void);
+    // sends PKSM the bare save like before the framed protocol. on by default,
+    // released PKSM builds don't read the header
+    bool isPKSMBridgeLegacy(void);
     bool isFTPEnabled(void);
+    // host[:port] the backups are mirrored to, empty when mirroring is off.
+    // safe to call from any thread, the network thread reparses the config
+    std::string syncServer(void);
+    // folder the server keeps this console's backups in
+    std::string syncName(void);
     std::vector<std::string> additionalSaveFolders(u64 id);
+    // appends the sockets of the http server, returns the milliseconds until it has to be polled anyway
+    int serverPollfds(std::vector<struct pollfd>& fds);
+    // handles whatever is ready without blocking
     void pollServer(void);
     void save(void);
     void load(void);
     void parse(void);
     const char* c_str(void);
-    nlohmann::json getJson(void);
+    const nlohmann::json& getJson(void) const;
+    // changes whenever the config is reloaded
+    u32 revision(void) const;
 
-    const std::string BASEPATH = "/switch/Checkpoint/config.json";
+    const std::string BASEPATH = "sdmc:/switch/Checkpoint/config.json";
 
 private:
     Configuration(void);
@@ -72,7 +93,14 @@ private:
 
     nlohmann::json mJson;
     bool PKSMBridgeEnabled;
+    bool PKSMBridgeLegacy;
     bool FTPEnabled;
+    // guards what parse() rebuilds on the network thread and the main thread
+    // reads: the filters, favorites, additional save folders and sync settings
+    std::mutex mMutex;
+    std::string mSyncServer;
+    std::string mSyncName;
+    u32 mRevision = 0;
     std::unordered_set<u64> mFilterIds, mFavoriteIds;
     std::unordered_map<u64, std::vector<std::string>> mAdditionalSaveFolders;
 };
@@ -28,9 +28,12 @@
 #define IO_HPP
 
 #include "KeyboardManager.hpp"
+#include "backupmirror.hpp"
 #include "account.hpp"
 #include "directory.hpp"
+#include "metrics.hpp"
 #include "multiselection.hpp"
+#include "operationfeed.hpp"
 #include "title.hpp"
 #include "util.hpp"
 #include <dirent.h>
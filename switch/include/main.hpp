@@ -31,8 +31,11 @@
 #include "account.hpp"
 #include "title.hpp"
 #include "util.hpp"
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <switch.h>
+#include <vector>
 
 typedef enum { SORT_ALPHA, SORT_LAST_PLAYED, SORT_PLAY_TIME, SORT_MODES_COUNT } sort_t;
 
@@ -47,6 +50,11 @@ inline std::string g_selectedCheatKey;
 inline std::vector<std::string> g_selectedCheatCodes;
 inline u32 g_username_dotsize;
 inline sort_t g_sortMode = SORT_ALPHA;
+// set by the network thread when a new config changes the favorites
+inline std::atomic<bool> g_favoritesChanged{false};
+// titles that received a backup over http, queued by the network thread and drained by the main loop
+inline std::mutex g_uploadedBackupsMutex;
+inline std::vector<u64> g_uploadedBackupIds;
 
 inline std::string g_currentFile = "";
 inline bool g_isTransferringFile = false;
@@ -0,0 +1,107 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <atomic>
+#include <stdint.h>
+#include <string>
+
+// counters and histograms for the /metrics endpoint. every thread that records
+// gets a shard of its own and is its only writer, so recording is a relaxed load
+// and store without any locking; a scrape sums the shards
+class Metrics {
+public:
+    enum Counter {
+        COPIED_BYTES,
+        COPIED_FILES,
+        SAVE_COMMITS,
+        SAVE_COMMIT_FAILURES,
+        BACKUPS,
+        BACKUP_FAILURES,
+        RESTORES,
+        RESTORE_FAILURES,
+        TEXT_RUN_HITS,
+        TEXT_RUN_MISSES,
+        TEXT_DIMENSION_HITS,
+        TEXT_DIMENSION_MISSES,
+        BACKUP_LIST_HITS,
+        BACKUP_LIST_MISSES,
+        HTTP_RESPONSE_HITS,
+        HTTP_RESPONSE_MISSES,
+        COUNTER_COUNT
+    };
+
+    enum Histogram { TITLE_LOAD, FRAME, HISTOGRAM_COUNT };
+
+    static Metrics& getInstance(void)
+    {
+        static Metrics mMetrics;
+        return mMetrics;
+    }
+
+    void add(Counter counter, uint64_t value = 1);
+    // elapsed is in microseconds
+    void observe(Histogram histogram, uint64_t elapsed);
+
+    // the prometheus text exposition of everything recorded, has to be called from the network thread
+    std::string render(void) const;
+
+    // threads past MAX_SHARDS share one more shard, and pay for atomic increments
+    static constexpr size_t MAX_SHARDS   = 8;
+    static constexpr size_t BUCKET_COUNT = 10;
+
+private:
+    Metrics(void) {}
+    ~Metrics(void) {}
+
+    Metrics(Metrics const&) = delete;
+    void operator=(Metrics const&) = delete;
+
+    // a cache line of its own keeps the threads from invalidating each other's counters
+    struct alignas(64) Shard {
+        std::atomic<bool> claimed;
+        std::atomic<uint64_t> counters[COUNTER_COUNT];
+        // the last bucket counts the observations past every bound
+        std::atomic<uint64_t> buckets[HISTOGRAM_COUNT][BUCKET_COUNT + 1];
+        std::atomic<uint64_t> sums[HISTOGRAM_COUNT];
+    };
+
+    friend class ShardLease;
+
+    Shard* claim(void);
+    void release(Shard* shard);
+    Shard& local(void);
+
+    static void bump(std::atomic<uint64_t>& value, uint64_t amount, bool shared);
+    uint64_t counter(Counter counter) const;
+
+    Shard mShards[MAX_SHARDS];
+    Shard mShared;
+};
+
+#endif
@@ -0,0 +1,105 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef OPERATIONFEED_HPP
+#define OPERATIONFEED_HPP
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// progress of backups and restores for the websocket clients of the web page.
+// the thread doing the copy only records state under a short lock, the network
+// thread turns it into messages: progress is coalesced into the latest value and
+// the per-file events are bounded, so a slow client can never hold up a copy
+class OperationFeed {
+public:
+    struct Message {
+        std::string json;
+        // may be skipped for a client that is falling behind
+        bool droppable;
+    };
+
+    static OperationFeed& getInstance(void)
+    {
+        static OperationFeed mOperationFeed;
+        return mOperationFeed;
+    }
+
+    void begin(const std::string& operation, const std::string& title);
+    void fileStarted(const std::string& name, uint64_t size);
+    void fileProgress(uint64_t done);
+    void fileFinished(void);
+    void end(bool success, const std::string& message);
+
+    // true once there are messages for drain
+    bool pending(void) const;
+    std::vector<Message> drain(void);
+    // brings a client that connects halfway through an operation up to date
+    std::vector<Message> current(void);
+
+    // per-file events kept until the network thread takes them
+    static constexpr size_t QUEUE_SIZE = 64;
+    // minimum milliseconds between two progress updates
+    static constexpr int INTERVAL = 250;
+
+private:
+    OperationFeed(void);
+    ~OperationFeed(void){};
+
+    OperationFeed(OperationFeed const&) = delete;
+    void operator=(OperationFeed const&) = delete;
+
+    typedef std::chrono::steady_clock Clock;
+
+    void push(std::string json, bool droppable);
+    void publish(bool force);
+    std::string beginJson(void) const;
+    std::string progressJson(void) const;
+
+    std::mutex mMutex;
+    std::deque<Message> mQueue;
+    std::atomic<bool> mPending;
+    bool mRunning;
+    bool mProgressChanged;
+    std::string mOperation;
+    std::string mTitle;
+    std::string mFile;
+    uint64_t mFileSize;
+    uint64_t mFileDone;
+    uint64_t mBytes;
+    uint32_t mFiles;
+    uint32_t mDropped;
+    Clock::time_point mStart;
+    Clock::time_point mFileStart;
+    Clock::time_point mLastPublish;
+};
+
+#endif
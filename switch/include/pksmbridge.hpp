@@ -26,7 +26,11 @@
 
 #include "KeyboardManager.hpp"
 #include "account.hpp"
+#include "bridgeprotocol.hpp"
+#include "configuration.hpp"
+#include "directory.hpp"
 #include "title.hpp"
+#include <algorithm>
 #include <arpa/inet.h>
 #include <errno.h>
 #include <netinet/in.h>
@@ -34,6 +38,7 @@
 #include <string>
 #include <switch.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <tuple>
 #include <unistd.h>
@@ -0,0 +1,83 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef REACTOR_HPP
+#define REACTOR_HPP
+
+#include <atomic>
+#include <functional>
+#include <poll.h>
+#include <vector>
+
+// runs the network servers from a single poll set: every source appends the
+// sockets it waits on, the thread sleeps until one of them is ready or a
+// source's deadline passes, then only the sources with activity are dispatched
+class Reactor {
+public:
+    // appends sockets to the poll set and returns the milliseconds until the
+    // source has to be dispatched regardless of activity, -1 for no deadline
+    typedef std::function<int(std::vector<struct pollfd>& fds)> Collect;
+    // receives the sockets the source collected, polled
+    typedef std::function<void(const struct pollfd* fds, size_t count)> Dispatch;
+
+    static Reactor& getInstance(void)
+    {
+        static Reactor mReactor;
+        return mReactor;
+    }
+
+    void add(Collect collect, Dispatch dispatch);
+    // returns once stop has been called
+    void run(void);
+    // may be called from any thread
+    void stop(void);
+    void wake(void);
+
+    // upper bound on the sleep of an idle reactor
+    static constexpr int IDLE_TIMEOUT = 1000;
+
+private:
+    Reactor(void);
+    ~Reactor(void);
+
+    Reactor(Reactor const&) = delete;
+    void operator=(Reactor const&) = delete;
+
+    struct Source {
+        Collect collect;
+        Dispatch dispatch;
+    };
+
+    std::vector<Source> mSources;
+    std::vector<struct pollfd> mFds;
+    std::vector<size_t> mOffsets;
+    std::vector<int> mTimeouts;
+    std::atomic<bool> mRunning;
+    // loopback datagram socket that stop and wake send to
+    int mWakeFd;
+};
+
+#endif
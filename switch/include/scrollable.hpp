@@ -48,7 +48,12 @@ public:
     void updateSelection(void) override;
     void text(size_t i, const std::string& v);
 
+    // number of cells ever allocated, it stays put while the list content doesn't change
+    static size_t cellAllocations(void) { return sCellAllocations; }
+
 protected:
+    inline static size_t sCellAllocations = 0;
+
     Hid<HidDirection::VERTICAL, HidDirection::HORIZONTAL> mHid;
 };
 
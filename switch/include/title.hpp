@@ -32,7 +32,9 @@
 #include "configuration.hpp"
 #include "filesystem.hpp"
 #include "io.hpp"
+#include "searchindex.hpp"
 #include <algorithm>
+#include <numeric>
 #include <stdlib.h>
 #include <string>
 #include <switch.h>
@@ -58,6 +60,8 @@ public:
     void lastPlayedTimestamp(u32 lastPlayedTimestamp);
     std::string fullPath(size_t index);
     void refreshDirectories(void);
+    void invalidateDirectories(void);
+    bool directoriesOutdated(bool checkTimestamp);
     u64 saveId();
     void saveId(u64 id);
     std::vector<std::string> saves(void);
@@ -66,6 +70,8 @@ public:
     std::string userName(void);
 
 private:
+    time_t directoriesTimestamp(void);
+
     u64 mId;
     u64 mSaveId;
     AccountUid mUserId;
@@ -76,6 +82,8 @@ private:
     std::string mPath;
     std::vector<std::string> mSaves;
     std::vector<std::string> mFullSavePaths;
+    bool mDirectoriesLoaded;
+    time_t mDirectoriesTimestamp;
     u8 mSaveDataType;
     std::pair<std::string, std::string> mDisplayName;
     u32 mPlayTimeMinutes;
@@ -87,10 +95,16 @@ size_t getTitleCount(AccountUid uid);
 void loadTitles(void);
 void sortTitles(void);
 void rotateSortMode(void);
+void searchTitles(const std::string& query);
+std::string titleSearchQuery(void);
+void updateFavorites(void);
 void refreshDirectories(u64 id);
+// changes whenever the visible titles or their backup lists may have changed
+u32 titlesRevision(void);
 bool favorite(AccountUid uid, int i);
 void freeIcons(void);
-SDL_Texture* smallIcon(AccountUid uid, size_t i);
+// queues the grid icon of a title, returns false if it has none
+bool queueSmallIcon(AccountUid uid, size_t i, int x, int y);
 std::unordered_map<std::string, std::string> getCompleteTitleList(void);
 
 #endif
\ No newline at end of file
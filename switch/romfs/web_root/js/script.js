@@ -29,39 +29,76 @@ var favorites = [];
 var folders = {};
 var j = null;
 
+// the config and the title list are separate resources with their own ETag,
+// so after a save only the config is sent again and the titles come back 304
 window.onload = () => {
-    $.ajax({
-        url: '/populate',
-        method: 'GET',
-        dataType: 'html',
-        success: (data) => {
-            try {
-                j = JSON.parse(data);
-                document.getElementById("enable-pksm-bridge").checked = j["pksm-bridge"];
-                document.getElementById("enable-ftp").checked = j["ftp-enabled"];
-                j['favorites'].forEach((id) => {
-                    pushToFavorites(id);
-                });
-                j['filter'].forEach((id) => {
-                    pushToFilter(id);
+    $.when(
+        $.ajax({ url: '/config', method: 'GET', dataType: 'json' }),
+        $.ajax({ url: '/titles', method: 'GET', dataType: 'json' })
+    ).done((config, titles) => {
+        try {
+            j = config[0];
+            j["title_list"] = titles[0];
+            document.getElementById("enable-pksm-bridge").checked = j["pksm-bridge"];
+            document.getElementById("enable-ftp").checked = j["ftp-enabled"];
+            document.getElementById("input-sync-server").value = j["sync-server"];
+            document.getElementById("input-sync-name").value = j["sync-name"];
+            j['favorites'].forEach((id) => {
+                pushToFavorites(id);
+            });
+            j['filter'].forEach((id) => {
+                pushToFilter(id);
+            });
+            createAdditionalSavesRows(j["title_list"]);
+            Object.keys(j["additional_save_folders"]).forEach((id) => {
+                j.additional_save_folders[id].folders.forEach((path) => {
+                    pushToFolders(id, path);
                 });
-                createAdditionalSavesRows(j["title_list"]);
-                Object.keys(j["additional_save_folders"]).forEach((id) => {
-                    j.additional_save_folders[id].folders.forEach((path) => {
-                        pushToFolders(id, path);
-                    });
-                });
-            } catch (err) {
-                console.log(err);
-                toastr["error"]("", "Failed to retrieve configurations!");
-            };
-        },
-        error: (data) => {
-            toastr["error"]("", "Failed to populate configuration page!");
-        }
+            });
+        } catch (err) {
+            console.log(err);
+            toastr["error"]("", "Failed to retrieve configurations!");
+        };
+    }).fail(() => {
+        toastr["error"]("", "Failed to populate configuration page!");
     });
+    connectFeed();
 };
 
+function formatBytes(bytes) {
+    var units = ["B", "KB", "MB", "GB"];
+    var i = 0;
+    while (bytes >= 1024 && i < units.length - 1) {
+        bytes /= 1024;
+        i++;
+    }
+    return `${bytes.toFixed(i == 0 ? 0 : 1)} ${units[i]}`;
+}
+
+// backups and restores running on the console, reconnects while the page is open
+function connectFeed() {
+    var socket = new WebSocket(`ws://${window.location.host}/feed`);
+    socket.onmessage = (event) => {
+        var m = JSON.parse(event.data);
+        var panel = document.getElementById("operation");
+        if (m.type == "begin") {
+            panel.style.display = "block";
+            document.getElementById("operation-title").textContent = `${m.operation == "backup" ? "Backing up" : "Restoring"} ${m.title}`;
+            document.getElementById("operation-progress").style.width = "0%";
+        } else if (m.type == "progress") {
+            var percent = m.total > 0 ? Math.floor(100 * m.done / m.total) : 100;
+            document.getElementById("operation-file").textContent = `${m.file} (${formatBytes(m.done)} of ${formatBytes(m.total)}, ${formatBytes(m.bytesPerSecond)}/s)`;
+            document.getElementById("operation-progress").style.width = `${percent}%`;
+        } else if (m.type == "end") {
+            panel.style.display = "none";
+            toastr[m.success ? "success" : "error"](`${m.files} files, ${formatBytes(m.bytesPerSecond)}/s`, `${m.title}: ${m.message}`);
+        }
+    };
+    socket.onclose = () => {
+        setTimeout(connectFeed, 5000);
+    };
+}
+
 function createRow(id, value) {
     var ul = document.getElementById(id);
     var li = document.createElement("li");
@@ -127,10 +164,12 @@ function saveSettings() {
     var data = {
         'pksm-bridge': document.getElementById("enable-pksm-bridge").checked,
         'ftp-enabled': document.getElementById("enable-ftp").checked,
+        'sync-server': document.getElementById("input-sync-server").value.trim(),
+        'sync-name': document.getElementById("input-sync-name").value.trim(),
         'filter': filter,
         'favorites': favorites,
         'additional_save_folders': {},
-        'version': 4
+        'version': 5
     };
     Object.keys(j.title_list).forEach((id) => {
         data.additional_save_folders[id] = {};
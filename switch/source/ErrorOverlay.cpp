@@ -29,7 +29,7 @@
 ErrorOverlay::ErrorOverlay(Screen& screen, Result mres, const std::string& mtext) : Overlay(screen)
 {
     res  = mres;
-    text = mtext;
+    text = SDLH_WrapText(28, mtext, 600);
     SDLH_GetTextDimensions(28, text.c_str(), &textw, &texth);
     button = std::make_unique<Clickable>(322, 462, 636, 56, theme().c1, theme().c6, "OK", true);
     button->selected(true);
@@ -30,8 +30,9 @@ static constexpr size_t rowlen = 5, collen = 4, rows = 10, SIDEBAR_w = 96;
 
 MainScreen::MainScreen() : hid(rowlen * collen, collen)
 {
-    pksmBridge     = false;
-    selectionTimer = 0;
+    pksmBridge         = false;
+    selectionTimer     = 0;
+    selectedTitleValid = false;
     sprintf(ver, "v%d.%d.%d", VERSION_MAJOR, VERSION_MINOR, VERSION_MICRO);
     backupList    = std::make_unique<Scrollable>(538, 276, 414, 380, rows);
     buttonBackup  = std::make_unique<Clickable>(956, 276, 220, 80, theme().c2, theme().c6, "Backup \ue004", true);
@@ -42,6 +43,21 @@ MainScreen::MainScreen() : hid(rowlen * collen, collen)
     buttonCheats->canChangeColorWhenSelected(true);
 }
 
+void MainScreen::syncBackupList(void) const
+{
+    const size_t index = hid.fullIndex();
+    if (selectedTitleValid && selectedTitleIndex == index && selectedTitleUser == g_currentUId && selectedTitleRevision == titlesRevision()) {
+        return;
+    }
+
+    getTitle(selectedTitle, g_currentUId, index);
+    backupList->assign(selectedTitle.saves(), theme().c2, theme().c6);
+    selectedTitleIndex    = index;
+    selectedTitleUser     = g_currentUId;
+    selectedTitleRevision = titlesRevision();
+    selectedTitleValid    = true;
+}
+
 int MainScreen::selectorX(size_t i) const
 {
     return 128 * ((i % (rowlen * collen)) % collen) + 4 * (((i % (rowlen * collen)) % collen) + 1);
@@ -73,17 +89,17 @@ void MainScreen::draw() const
     SDLH_GetTextDimensions(13, username.c_str(), &username_w, &username_h);
     SDLH_DrawTextBox(13, 1280 - SIDEBAR_w + (SIDEBAR_w - username_w) / 2, 720 - 28 + (28 - username_h) / 2, theme().c6, SIDEBAR_w, username.c_str());
 
-    // title icons
+    // title icons, drawn in a single batch before their badges
     for (size_t k = hid.page() * entries; k < hid.page() * entries + max; k++) {
-        int selectorx = selectorX(k);
-        int selectory = selectorY(k);
-        if (smallIcon(g_currentUId, k) != NULL) {
-            SDLH_DrawImageScale(smallIcon(g_currentUId, k), selectorx, selectory, 128, 128);
-        }
-        else {
-            SDLH_DrawRect(selectorx, selectory, 128, 128, theme().c0);
+        if (!queueSmallIcon(g_currentUId, k, selectorX(k), selectorY(k))) {
+            SDLH_DrawRect(selectorX(k), selectorY(k), 128, 128, theme().c0);
         }
+    }
+    SDLH_FlushAtlasIcons();
 
+    for (size_t k = hid.page() * entries; k < hid.page() * entries + max; k++) {
+        int selectorx = selectorX(k);
+        int selectory = selectorY(k);
         if (!selEnt.empty() && std::find(selEnt.begin(), selEnt.end(), k) != selEnt.end()) {
             SDLH_DrawIcon("checkbox", selectorx + 86, selectory + 86);
         }
@@ -103,14 +119,11 @@ void MainScreen::draw() const
     }
 
     if (getTitleCount(g_currentUId) > 0) {
-        Title title;
-        getTitle(title, g_currentUId, hid.fullIndex());
-
-        backupList->flush();
-        std::vector<std::string> dirs = title.saves();
+        syncBackupList();
+        Title& title = selectedTitle;
 
-        for (size_t i = 0; i < dirs.size(); i++) {
-            backupList->push_back(theme().c2, theme().c6, dirs.at(i), i == backupList->index());
+        for (size_t i = 0, sz = backupList->size(); i < sz; i++) {
+            backupList->selectRow(i, i == backupList->index());
         }
 
         if (title.icon() != NULL) {
@@ -188,6 +201,7 @@ void MainScreen::draw() const
         SDLH_DrawText(27, 1205, 646, theme().c6, "\ue085\ue086");
         SDLH_DrawText(24, 58, 69, theme().c6, "\ue058 Tap to select title");
         SDLH_DrawText(24, 58, 109, theme().c6, ("\ue026 Sort: " + sortMode()).c_str());
+        SDLH_DrawText(24, 58, 149, theme().c6, ("\ue0c4 Search: " + titleSearchQuery()).c_str());
         SDLH_DrawText(24, 100, 270, theme().c6, "\ue006 \ue080 to scroll between titles");
         SDLH_DrawText(24, 100, 300, theme().c6, "\ue004 \ue005 to scroll between pages");
         SDLH_DrawText(24, 100, 330, theme().c6, "\ue000 to enter the selected title");
@@ -265,6 +279,12 @@ void MainScreen::handleEvents(touchPosition* touch)
 {
     u32 kdown = hidKeysDown(CONTROLLER_P1_AUTO);
     u32 kheld = hidKeysHeld(CONTROLLER_P1_AUTO);
+
+    if ((kheld & KEY_MINUS) && (kdown & KEY_DUP)) {
+        runBenchmark();
+        return;
+    }
+
     if (kdown & KEY_ZL || kdown & KEY_ZR) {
         while ((g_currentUId = Account::selectAccount()) == 0)
             ;
@@ -395,6 +415,17 @@ void MainScreen::handleEvents(touchPosition* touch)
         }
     }
 
+    // Handle pressing the left stick: filter the titles by name or title id
+    if (kdown & KEY_LSTICK && !g_backupScrollEnabled) {
+        std::pair<bool, std::string> query = KeyboardManager::get().keyboard(titleSearchQuery());
+        if (query.first) {
+            searchTitles(query.second);
+            MS::clearSelectedEntries();
+            this->index(TITLES, 0);
+            setPKSMBridgeFlag(false);
+        }
+    }
+
     // Handle pressing Y
     // Backup list active:   Deactivate backup list, select title, and
     //                       enable backup button
@@ -630,3 +661,39 @@ std::string MainScreen::sortMode() const
     }
     return "";
 }
+
+void MainScreen::runBenchmark(void)
+{
+    const size_t entries = hid.maxVisibleEntries();
+    const size_t count   = getTitleCount(g_currentUId);
+    std::vector<Benchmark::Step> steps;
+
+    steps.push_back({"idle", 60, [this]() { this->index(TITLES, 0); }});
+    for (size_t i = 0; i < std::min(count, entries); i++) {
+        steps.push_back({"move", 2, [this, i]() { this->index(TITLES, i); }});
+    }
+    for (size_t i = 0; i < count; i += entries) {
+        steps.push_back({"page", 10, [this, i]() { this->index(TITLES, i); }});
+    }
+    steps.push_back({"info overlay", 60, [this]() {
+                         this->index(TITLES, 0);
+                         currentOverlay = std::make_shared<InfoOverlay>(*this,
+                             "This is a message long enough to be wrapped over a few lines, the way backup and restore results usually are.");
+                     }});
+    steps.push_back({"yes/no overlay", 60, [this]() { currentOverlay = std::make_shared<YesNoOverlay>(*this, "Restore selected save?", []() {}, []() {}); }});
+    steps.push_back({"multiselect", 60, [this, entries, count]() {
+                         removeOverlay();
+                         for (size_t i = 0; i < std::min(count, entries); i++) {
+                             MS::addSelectedEntry(i);
+                         }
+                     }});
+    steps.push_back({"report", 1, [this]() {
+                         MS::clearSelectedEntries();
+                         const std::string report = Benchmark::getInstance().report();
+                         Logger::getInstance().log(Logger::INFO, "Benchmark results:\n%s", report.c_str());
+                         currentOverlay = std::make_shared<InfoOverlay>(*this, report);
+                     }});
+    // the backup list keeps its cells across frames, only a new title rebuilds them
+    Benchmark::getInstance().track("cell allocs", Scrollable::cellAllocations);
+    Benchmark::getInstance().start(steps);
+}
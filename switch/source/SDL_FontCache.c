@@ -29,6 +29,9 @@ See SDL_FontCache.h for license info.
 // Width of a tab in units of the space width (sorry, no tab alignment!)
 static unsigned int fc_tab_width = 4;
 
+// Number of glyphs that had to be rasterized while drawing
+static Uint32 fc_rendered_glyphs = 0;
+
 static Uint8 has_clip(FC_Target* dest)
 {
     return SDL_RenderIsClipEnabled(dest);
@@ -1139,50 +1142,77 @@ void FC_GetCodepoints(FC_Font* font, Uint32* result)
     }
 }
 
+static FC_GlyphData* FC_PackGlyphSurface(FC_Font* font, Uint32 codepoint, SDL_Surface* surf)
+{
+    int w, h;
+    FC_GlyphData* e;
+    FC_Image* cache_image = FC_GetGlyphCacheLevel(font, font->last_glyph.cache_level);
+    if (cache_image == NULL) {
+        FC_Log("SDL_FontCache: Failed to load cache image, so cannot add new glyphs!\n");
+        return NULL;
+    }
+
+    SDL_QueryTexture(cache_image, NULL, NULL, &w, &h);
+
+    e = FC_PackGlyphData(font, codepoint, surf->w, w, h);
+    if (e == NULL) {
+        // Grow the cache
+        FC_GrowGlyphCache(font);
+
+        // Try packing again
+        e = FC_PackGlyphData(font, codepoint, surf->w, w, h);
+        if (e == NULL) {
+            return NULL;
+        }
+    }
+
+    // Render onto the cache texture
+    FC_AddGlyphToCache(font, surf);
+    return e;
+}
+
+Uint8 FC_HasGlyph(FC_Font* font, Uint32 codepoint)
+{
+    return font != NULL && FC_MapFind(font->glyphs, codepoint) != NULL;
+}
+
+Uint8 FC_AddGlyph(FC_Font* font, Uint32 codepoint, SDL_Surface* glyph_surface)
+{
+    if (font == NULL || glyph_surface == NULL)
+        return 0;
+    if (FC_MapFind(font->glyphs, codepoint) != NULL)
+        return 1;
+    return FC_PackGlyphSurface(font, codepoint, glyph_surface) != NULL;
+}
+
+Uint32 FC_GetRenderedGlyphCount(void)
+{
+    return fc_rendered_glyphs;
+}
+
 Uint8 FC_GetGlyphData(FC_Font* font, FC_GlyphData* result, Uint32 codepoint)
 {
     FC_GlyphData* e = FC_MapFind(font->glyphs, codepoint);
     if (e == NULL) {
         char buff[5];
-        int w, h;
         SDL_Color white = {255, 255, 255, 255};
         SDL_Surface* surf;
-        FC_Image* cache_image;
 
-        if (font->ttf_source == NULL || font->ttf_ext)
+        if (font->ttf_source == NULL || font->ttf_ext == NULL)
             return 0;
 
         FC_GetUTF8FromCodepoint(buff, codepoint);
-        cache_image = FC_GetGlyphCacheLevel(font, font->last_glyph.cache_level);
-        if (cache_image == NULL) {
-            FC_Log("SDL_FontCache: Failed to load cache image, so cannot add new glyphs!\n");
-            return 0;
-        }
-
-        SDL_QueryTexture(cache_image, NULL, NULL, &w, &h);
-
         surf = TTF_RenderUTF8_Blended(codepoint >= 0xE000 ? font->ttf_ext : font->ttf_source, buff, white);
         if (surf == NULL) {
             return 0;
         }
 
-        e = FC_PackGlyphData(font, codepoint, surf->w, w, h);
+        e = FC_PackGlyphSurface(font, codepoint, surf);
+        SDL_FreeSurface(surf);
         if (e == NULL) {
-            // Grow the cache
-            FC_GrowGlyphCache(font);
-
-            // Try packing again
-            e = FC_PackGlyphData(font, codepoint, surf->w, w, h);
-            if (e == NULL) {
-                SDL_FreeSurface(surf);
-                return 0;
-            }
+            return 0;
         }
-
-        // Render onto the cache texture
-        FC_AddGlyphToCache(font, surf);
-
-        SDL_FreeSurface(surf);
+        fc_rendered_glyphs++;
     }
 
     if (result != NULL && e != NULL)
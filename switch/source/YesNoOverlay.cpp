@@ -30,7 +30,7 @@ YesNoOverlay::YesNoOverlay(
     Screen& screen, const std::string& mtext, const std::function<void()>& callbackYes, const std::function<void()>& callbackNo)
     : Overlay(screen), hid(2, 2)
 {
-    text    = mtext;
+    text    = SDLH_WrapText(28, mtext, 600);
     yesFunc = callbackYes;
     noFunc  = callbackNo;
     SDLH_GetTextDimensions(28, text.c_str(), &textw, &texth);
@@ -0,0 +1,95 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "backupmirror.hpp"
+#include "configuration.hpp"
+#include "syncclient.hpp"
+
+#define BACKUP_ROOT "sdmc:/switch/Checkpoint/saves"
+
+void BackupMirror::request(void)
+{
+    const std::string server = Configuration::getInstance().syncServer();
+    if (server.empty()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mServer    = server;
+    mName      = Configuration::getInstance().syncName();
+    mRequested = true;
+    if (!mThread.joinable()) {
+        mThread = std::thread(&BackupMirror::run, this);
+    }
+    mCondition.notify_one();
+}
+
+void BackupMirror::stop(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+        mCondition.notify_one();
+    }
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+}
+
+void BackupMirror::run(void)
+{
+    while (true) {
+        std::string server, name;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this] { return mRequested || mStop; });
+            if (mStop) {
+                return;
+            }
+            mRequested = false;
+            server     = mServer;
+            name       = mName;
+        }
+
+        uint16_t port    = Sync::PORT;
+        const size_t pos = server.rfind(':');
+        if (pos != std::string::npos) {
+            port   = strtoul(server.c_str() + pos + 1, NULL, 10);
+            server = server.substr(0, pos);
+        }
+
+        Sync::Stats stats;
+        std::string error;
+        Logger::getInstance().log(Logger::INFO, "Mirroring backups to %s:%u.", server.c_str(), port);
+        if (Sync::mirror(server, port, name, BACKUP_ROOT, stats, error, [this] { return mStop; })) {
+            Logger::getInstance().log(Logger::INFO, "Mirrored backups: %u files sent, %u unchanged, %llu bytes sent, %llu bytes reused.", stats.sent,
+                stats.unchanged, (unsigned long long)stats.literal, (unsigned long long)stats.matched);
+        }
+        else {
+            Logger::getInstance().log(Logger::ERROR, "Failed to mirror backups: %s", error.c_str());
+        }
+    }
+}
@@ -0,0 +1,424 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "bridgeprotocol.hpp"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <memory>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char MAGIC[8] = {'P', 'K', 'S', 'M', 'B', 'R', 'D', 'G'};
+// granularity at which the cancel callback is polled
+static constexpr int CANCEL_INTERVAL = 100;
+
+static void put32(uint8_t* out, uint32_t v)
+{
+    for (int i = 0; i < 4; i++) {
+        out[i] = v >> (24 - 8 * i);
+    }
+}
+
+static void put64(uint8_t* out, uint64_t v)
+{
+    put32(out, v >> 32);
+    put32(out + 4, v);
+}
+
+static uint32_t get32(const uint8_t* in)
+{
+    return (uint32_t)in[0] << 24 | (uint32_t)in[1] << 16 | (uint32_t)in[2] << 8 | in[3];
+}
+
+static uint64_t get64(const uint8_t* in)
+{
+    return (uint64_t)get32(in) << 32 | get32(in + 4);
+}
+
+uint32_t Bridge::crc32(uint32_t crc, const void* data, size_t size)
+{
+    static uint32_t table[256];
+    if (table[1] == 0) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = c & 1 ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+    }
+
+    const uint8_t* p = (const uint8_t*)data;
+    crc              = ~crc;
+    while (size--) {
+        crc = table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+// sets the socket non-blocking with large buffers and without nagle, so the
+// header isn't held back and every window goes out as soon as it's read
+static void tune(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+
+    // the stack caps the buffers at its own maximum, failures are harmless
+    int yes  = 1;
+    int size = Bridge::WINDOW_SIZE;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+}
+
+// waits until fd is ready for events, timeout is in milliseconds, -1 waits forever
+static bool wait(int fd, short events, int timeout, const Bridge::Cancel& cancel)
+{
+    struct pollfd pfd;
+    pfd.fd     = fd;
+    pfd.events = events;
+    for (int waited = 0; timeout < 0 || waited < timeout; waited += CANCEL_INTERVAL) {
+        if (cancel && cancel()) {
+            errno = ECANCELED;
+            return false;
+        }
+        pfd.revents = 0;
+        int rc      = poll(&pfd, 1, CANCEL_INTERVAL);
+        if (rc < 0 && errno != EINTR) {
+            return false;
+        }
+        if (rc > 0) {
+            return true;
+        }
+    }
+    errno = ETIMEDOUT;
+    return false;
+}
+
+static bool sendAll(int fd, const void* data, size_t size, const Bridge::Cancel& cancel)
+{
+    const char* p = (const char*)data;
+    while (size > 0) {
+        ssize_t n = ::send(fd, p, size, 0);
+        if (n < 0) {
+            if ((errno == EAGAIN || errno == EWOULDBLOCK) && wait(fd, POLLOUT, Bridge::TIMEOUT, cancel)) {
+                continue;
+            }
+            if (errno != EINTR) {
+                return false;
+            }
+            continue;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+// returns the amount received, 0 once the peer closed the connection, -1 on error
+static ssize_t recvSome(int fd, void* data, size_t size, const Bridge::Cancel& cancel)
+{
+    while (true) {
+        ssize_t n = ::recv(fd, data, size, 0);
+        if (n >= 0) {
+            return n;
+        }
+        if ((errno == EAGAIN || errno == EWOULDBLOCK) && wait(fd, POLLIN, Bridge::TIMEOUT, cancel)) {
+            continue;
+        }
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+}
+
+static bool recvAll(int fd, void* data, size_t size, const Bridge::Cancel& cancel)
+{
+    char* p = (char*)data;
+    while (size > 0) {
+        ssize_t n = recvSome(fd, p, size, cancel);
+        if (n <= 0) {
+            if (n == 0) {
+                errno = ECONNRESET;
+            }
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+int Bridge::accept(uint16_t port, const Cancel& cancel)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+    if (fd < 0) {
+        return -1;
+    }
+
+    int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(port);
+    addr.sin_addr.s_addr = INADDR_ANY;
+
+    int conn = -1;
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0 && listen(fd, 1) == 0) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        // the user has to start the transfer on the other console first, don't time out
+        while (conn < 0 && wait(fd, POLLIN, -1, cancel)) {
+            conn = ::accept(fd, NULL, NULL);
+            if (conn < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                break;
+            }
+        }
+    }
+
+    int err = errno;
+    close(fd);
+    errno = err;
+    if (conn >= 0) {
+        tune(conn);
+    }
+    return conn;
+}
+
+int Bridge::connect(const std::string& address, uint16_t port, const Cancel& cancel)
+{
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port   = htons(port);
+    if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    tune(fd);
+
+    if (::connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        int err       = errno;
+        socklen_t len = sizeof(err);
+        if (err != EINPROGRESS || !wait(fd, POLLOUT, TIMEOUT, cancel) || getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err != 0) {
+            err = err != EINPROGRESS ? err : errno;
+            close(fd);
+            errno = err;
+            return -1;
+        }
+    }
+    return fd;
+}
+
+std::tuple<bool, int, std::string> Bridge::send(int fd, const std::string& path, bool legacy, const Cancel& cancel)
+{
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        return std::make_tuple(false, errno, "Failed to open source file.");
+    }
+
+    struct stat st;
+    std::unique_ptr<char[]> buffer(new char[WINDOW_SIZE]);
+    if (fstat(file, &st) != 0) {
+        int err = errno;
+        close(file);
+        return std::make_tuple(false, err, "Failed to open source file.");
+    }
+
+    uint64_t length = st.st_size;
+    ssize_t n;
+    if (!legacy) {
+        // the checksum goes in the header, so it takes a pass of its own
+        uint32_t crc = 0;
+        while ((n = read(file, buffer.get(), WINDOW_SIZE)) > 0) {
+            crc = crc32(crc, buffer.get(), n);
+        }
+        if (n < 0 || lseek(file, 0, SEEK_SET) != 0) {
+            int err = errno;
+            close(file);
+            return std::make_tuple(false, err, "Failed to read source file.");
+        }
+
+        uint8_t header[HEADER_SIZE];
+        memcpy(header, MAGIC, sizeof(MAGIC));
+        put32(header + 8, BRIDGE_VERSION);
+        put32(header + 12, crc);
+        put64(header + 16, length);
+        if (!sendAll(fd, header, HEADER_SIZE, cancel)) {
+            int err = errno;
+            close(file);
+            return std::make_tuple(false, err, "Failed to send data.");
+        }
+    }
+
+    uint64_t total = 0;
+    while (total < length) {
+        size_t chunk = length - total < WINDOW_SIZE ? length - total : WINDOW_SIZE;
+        n            = read(file, buffer.get(), chunk);
+        if (n <= 0) {
+            int err = n < 0 ? errno : EIO;
+            close(file);
+            return std::make_tuple(false, err, "Failed to read source file.");
+        }
+        if (!sendAll(fd, buffer.get(), n, cancel)) {
+            int err = errno;
+            close(file);
+            return std::make_tuple(false, err, "Failed to send data.");
+        }
+        total += n;
+    }
+    close(file);
+    if (legacy) {
+        return std::make_tuple(true, 0, "Data sent correctly.");
+    }
+
+    uint8_t status[4];
+    if (!recvAll(fd, status, sizeof(status), cancel)) {
+        return std::make_tuple(false, errno, "PKSM didn't confirm the transfer.");
+    }
+    switch (get32(status)) {
+        case STATUS_OK:
+            return std::make_tuple(true, 0, "Data sent correctly.");
+        case STATUS_CHECKSUM:
+            return std::make_tuple(false, EIO, "PKSM received corrupted data.");
+        default:
+            return std::make_tuple(false, EIO, "PKSM failed to store the data.");
+    }
+}
+
+std::tuple<bool, int, std::string> Bridge::recv(int fd, const std::string& path, size_t legacySize, uint64_t maxLength, const Cancel& cancel)
+{
+    uint8_t header[HEADER_SIZE];
+    if (!recvAll(fd, header, HEADER_SIZE, cancel)) {
+        return std::make_tuple(false, errno, "Failed to receive data.");
+    }
+
+    uint64_t length;
+    uint32_t crc    = 0;
+    bool framed     = memcmp(header, MAGIC, sizeof(MAGIC)) == 0;
+    size_t buffered = 0;
+    if (framed) {
+        if (get32(header + 8) != BRIDGE_VERSION) {
+            return std::make_tuple(false, EPROTO, "Unsupported PKSM bridge version.");
+        }
+        length = get64(header + 16);
+        if (length > maxLength || length > MAX_LENGTH) {
+            uint8_t reply[4];
+            put32(reply, STATUS_WRITE);
+            sendAll(fd, reply, sizeof(reply), cancel);
+            return std::make_tuple(false, EFBIG, "PKSM sent more data than the save can hold.");
+        }
+    }
+    else if (legacySize >= HEADER_SIZE) {
+        // older PKSM builds send the bare save, what was read is already payload
+        length   = legacySize;
+        buffered = HEADER_SIZE;
+    }
+    else {
+        return std::make_tuple(false, EPROTO, "PKSM is too old to send this title.");
+    }
+
+    const std::string tmpPath = path + ".part";
+    int file                  = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (file < 0) {
+        return std::make_tuple(false, errno, "Failed to open destination file.");
+    }
+
+    std::unique_ptr<char[]> buffer(new char[WINDOW_SIZE]);
+    memcpy(buffer.get(), header, buffered);
+    uint64_t total = 0;
+    bool written   = true;
+    int err        = 0;
+    while (total < length) {
+        uint64_t left = length - total;
+        if (buffered < WINDOW_SIZE && buffered < left) {
+            size_t want = WINDOW_SIZE - buffered < left - buffered ? WINDOW_SIZE - buffered : left - buffered;
+            ssize_t n   = recvSome(fd, buffer.get() + buffered, want, cancel);
+            if (n <= 0) {
+                err = n < 0 ? errno : ECONNRESET;
+                close(file);
+                unlink(tmpPath.c_str());
+                return std::make_tuple(false, err, "Failed to receive data.");
+            }
+            buffered += n;
+            if (buffered < WINDOW_SIZE && buffered < left) {
+                continue;
+            }
+        }
+
+        crc = crc32(crc, buffer.get(), buffered);
+        if (written && write(file, buffer.get(), buffered) != (ssize_t)buffered) {
+            // keep draining the socket so the peer still gets a status
+            written = false;
+            err     = errno;
+        }
+        total += buffered;
+        buffered = 0;
+    }
+    written = close(file) == 0 && written;
+
+    // move the file in place before answering, so a confirmed transfer is never lost
+    Status status = !written ? STATUS_WRITE : framed && crc != get32(header + 12) ? STATUS_CHECKSUM : STATUS_OK;
+    if (status == STATUS_OK) {
+        remove(path.c_str());
+        if (rename(tmpPath.c_str(), path.c_str()) != 0) {
+            status = STATUS_WRITE;
+            err    = errno;
+        }
+    }
+    if (status != STATUS_OK) {
+        err = status == STATUS_CHECKSUM ? EIO : err;
+        unlink(tmpPath.c_str());
+    }
+
+    if (framed) {
+        uint8_t reply[4];
+        put32(reply, status);
+        sendAll(fd, reply, sizeof(reply), cancel);
+    }
+
+    switch (status) {
+        case STATUS_OK:
+            return std::make_tuple(true, 0, "Data received correctly.");
+        case STATUS_CHECKSUM:
+            return std::make_tuple(false, err, "Received data is corrupted.");
+        default:
+            return std::make_tuple(false, err, "Failed to write destination file.");
+    }
+}
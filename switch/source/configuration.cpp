@@ -31,19 +31,121 @@ static struct mg_connection* nc;
 static struct mg_serve_http_opts s_http_server_opts;
 static const char* s_http_port = "8000";
 
+#define BACKUP_ROOT "sdmc:/switch/Checkpoint/saves"
+// how much of an archive download is queued on the connection at once
+#define BACKUP_SEND_WINDOW 0x10000
+// a feed client with this much unsent skips progress updates, and is dropped once it falls this far behind on events
+#define FEED_SOFT_LIMIT 0x1000
+#define FEED_HARD_LIMIT 0x10000
+
+// state of a backup download or upload, owned by the connection's user_data
+struct BackupTransfer {
+    std::unique_ptr<TarWriter> writer;
+    std::unique_ptr<TarReader> reader;
+    std::string path;
+    u64 id;
+    bool failed;
+};
+
+// a serialized response, rebuilt only once the config or the titles it was made from change
+struct CachedResponse {
+    std::string body;
+    std::string etag;
+    u32 configRevision;
+    u32 titlesRevision;
+    bool valid;
+};
+
+static CachedResponse configCache, titlesCache, populateCache;
+
+static bool refresh_cache(CachedResponse& cache, bool dependsOnConfig, bool dependsOnTitles)
+{
+    const u32 configRevision = Configuration::getInstance().revision();
+    const u32 titleRevision  = titlesRevision();
+    if (cache.valid && (!dependsOnConfig || cache.configRevision == configRevision) && (!dependsOnTitles || cache.titlesRevision == titleRevision)) {
+        Metrics::getInstance().add(Metrics::HTTP_RESPONSE_HITS);
+        return false;
+    }
+    Metrics::getInstance().add(Metrics::HTTP_RESPONSE_MISSES);
+    cache.configRevision = configRevision;
+    cache.titlesRevision = titleRevision;
+    cache.valid          = true;
+    return true;
+}
+
+// the tag is a hash of the body, so it survives rebuilds that change nothing and restarts
+static void set_cache_body(CachedResponse& cache, std::string body)
+{
+    u64 hash = 0xCBF29CE484222325;
+    for (unsigned char c : body) {
+        hash = (hash ^ c) * 0x100000001B3;
+    }
+    cache.body = std::move(body);
+    cache.etag = StringUtils::format("\"%016llX\"", hash);
+}
+
+static const CachedResponse& config_response(void)
+{
+    if (refresh_cache(configCache, true, false)) {
+        set_cache_body(configCache, Configuration::getInstance().getJson().dump());
+    }
+    return configCache;
+}
+
+static const CachedResponse& titles_response(void)
+{
+    if (refresh_cache(titlesCache, false, true)) {
+        set_cache_body(titlesCache, nlohmann::json(getCompleteTitleList()).dump());
+    }
+    return titlesCache;
+}
+
+static const CachedResponse& populate_response(void)
+{
+    if (refresh_cache(populateCache, true, true)) {
+        nlohmann::json json = Configuration::getInstance().getJson();
+        json["title_list"]  = getCompleteTitleList();
+        set_cache_body(populateCache, json.dump());
+    }
+    return populateCache;
+}
+
+// browsers revalidate with the tag on every load and get an empty 304 while nothing changed
+static void send_cached(struct mg_connection* nc, struct http_message* hm, const CachedResponse& cache)
+{
+    struct mg_str* match = mg_get_http_header(hm, "If-None-Match");
+    if (match != NULL && mg_strstr(*match, mg_mk_str_n(cache.etag.c_str(), cache.etag.length())) != NULL) {
+        mg_printf(nc, "HTTP/1.1 304 Not Modified\r\nETag: %s\r\nCache-Control: no-cache\r\nContent-Length: 0\r\n\r\n", cache.etag.c_str());
+        return;
+    }
+    mg_printf(nc, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nETag: %s\r\nCache-Control: no-cache\r\nContent-Length: %lu\r\n\r\n",
+        cache.etag.c_str(), (unsigned long)cache.body.length());
+    mg_send(nc, cache.body.c_str(), cache.body.length());
+}
+
 static void handle_populate(struct mg_connection* nc, struct http_message* hm)
 {
     // populate gets called at startup, assume a new connection has been started
     blinkLed(2);
 
-    auto json          = Configuration::getInstance().getJson();
-    auto map           = getCompleteTitleList();
-    json["title_list"] = map;
-    std::string body   = json.dump();
-    mg_printf(nc, "HTTP/1.1 200 OK\r\nContent-Length: %lu\r\n\r\n%.*s", (unsigned long)body.length(), (int)body.length(), body.c_str());
+    send_cached(nc, hm, populate_response());
+    Logger::getInstance().log(Logger::INFO, "A new Configuration connection has been handled.");
+}
+
+// the page loads the config and the title list separately, so saving the config doesn't resend the titles
+static void handle_config(struct mg_connection* nc, struct http_message* hm)
+{
+    blinkLed(2);
+
+    send_cached(nc, hm, config_response());
     Logger::getInstance().log(Logger::INFO, "A new Configuration connection has been handled.");
 }
 
+static void handle_titles(struct mg_connection* nc, struct http_message* hm)
+{
+    send_cached(nc, hm, titles_response());
+}
+
 static void handle_save(struct mg_connection* nc, struct http_message* hm)
 {
     FILE* f = fopen(Configuration::getInstance().BASEPATH.c_str(), "w");
@@ -61,6 +163,208 @@ static void handle_save(struct mg_connection* nc, struct http_message* hm)
     mg_printf(nc, "HTTP/1.1 200 OK\r\nContent-Length: %lu\r\n\r\n%.*s", (unsigned long)hm->body.len, (int)hm->body.len, hm->body.p);
 }
 
+static void handle_metrics(struct mg_connection* nc)
+{
+    const std::string body = Metrics::getInstance().render();
+    mg_printf(nc, "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nCache-Control: no-cache\r\nContent-Length: %lu\r\n\r\n",
+        (unsigned long)body.length());
+    mg_send(nc, body.c_str(), body.length());
+}
+
+static std::string query_var(struct http_message* hm, const char* name)
+{
+    char buf[256];
+    int len = mg_get_http_var(&hm->query_string, name, buf, sizeof(buf));
+    return len > 0 ? std::string(buf, len) : "";
+}
+
+// the folders Title::init creates are named after the title id, followed by its name
+static std::unordered_map<std::string, std::string> backup_folders(void)
+{
+    std::unordered_map<std::string, std::string> folders;
+    Directory list(BACKUP_ROOT);
+    for (size_t i = 0, sz = list.size(); i < sz; i++) {
+        const std::string entry = list.entry(i);
+        if (list.folder(i) && entry.length() > 19 && entry[18] == ' ') {
+            folders.insert({entry.substr(0, 18), BACKUP_ROOT "/" + entry});
+        }
+    }
+    return folders;
+}
+
+// the path of a backup named in the query, empty if the title or name is invalid
+static std::string backup_path(struct http_message* hm)
+{
+    const std::string name = query_var(hm, "name");
+    if (name.empty() || name != StringUtils::removeForbiddenCharacters(name)) {
+        return "";
+    }
+    auto folders = backup_folders();
+    auto folder  = folders.find(query_var(hm, "title"));
+    return folder != folders.end() ? folder->second + "/" + name : "";
+}
+
+static void handle_backups(struct mg_connection* nc, struct http_message* hm)
+{
+    auto folders        = backup_folders();
+    nlohmann::json json = nlohmann::json::object();
+    for (auto& title : getCompleteTitleList()) {
+        std::vector<std::string> backups;
+        auto folder = folders.find(title.first);
+        if (folder != folders.end()) {
+            Directory list(folder->second);
+            for (size_t i = 0, sz = list.size(); i < sz; i++) {
+                if (list.folder(i) && list.entry(i) != "." && list.entry(i) != "..") {
+                    backups.push_back(list.entry(i));
+                }
+            }
+            std::sort(backups.rbegin(), backups.rend());
+        }
+        json[title.first] = {{"name", title.second}, {"backups", backups}};
+    }
+    std::string body = json.dump();
+    mg_printf(nc, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: %lu\r\n\r\n%.*s", (unsigned long)body.length(),
+        (int)body.length(), body.c_str());
+}
+
+// queues the next part of an archive download, called again whenever the client has taken some of it
+static void pump_backup(struct mg_connection* nc)
+{
+    // the network thread's stack is too small for this, and it is the only thread pumping
+    static char buf[0x4000];
+    BackupTransfer* transfer = (BackupTransfer*)nc->user_data;
+    while (nc->send_mbuf.len < BACKUP_SEND_WINDOW) {
+        ssize_t len = transfer->writer->read(buf, sizeof(buf));
+        if (len < 0) {
+            // the headers are out already, an unterminated chunked body tells the client it failed
+            Logger::getInstance().log(Logger::ERROR, "Failed to read the backup %s.", transfer->path.c_str());
+            nc->flags |= MG_F_CLOSE_IMMEDIATELY;
+            break;
+        }
+        mg_send_http_chunk(nc, buf, len);
+        if (len == 0) {
+            delete transfer;
+            nc->user_data = NULL;
+            break;
+        }
+    }
+}
+
+static void handle_backup_download(struct mg_connection* nc, struct http_message* hm)
+{
+    const std::string path = backup_path(hm);
+    if (path.empty() || !io::directoryExists(path)) {
+        mg_http_send_error(nc, 404, NULL);
+        return;
+    }
+
+    BackupTransfer* transfer = new BackupTransfer{std::make_unique<TarWriter>(path), nullptr, path, 0, false};
+    nc->user_data            = transfer;
+
+    const std::string filename = query_var(hm, "title") + " " + query_var(hm, "name") + ".tar";
+    const std::string headers  = "Content-Type: application/x-tar\r\nContent-Disposition: attachment; filename=\"" + filename + "\"";
+    mg_send_head(nc, 200, -1, headers.c_str());
+    pump_backup(nc);
+}
+
+static void fail_backup_upload(struct mg_connection* nc, BackupTransfer* transfer, int code)
+{
+    transfer->failed = true;
+    io::deleteFolderRecursively(transfer->path + "/");
+    mg_http_send_error(nc, code, NULL);
+    nc->flags |= MG_F_SEND_AND_CLOSE;
+}
+
+// the body of an upload is extracted into the new backup as it arrives
+static void handle_backup_chunk(struct mg_connection* nc, struct http_message* hm)
+{
+    BackupTransfer* transfer = (BackupTransfer*)nc->user_data;
+    if (transfer == NULL) {
+        const std::string path = backup_path(hm);
+        transfer = new BackupTransfer{nullptr, std::make_unique<TarReader>(path), path, strtoull(query_var(hm, "title").c_str(), NULL, 16), false};
+        nc->user_data = transfer;
+        // mongoose hands chunked bodies to this event twice, decoded and raw: uploads need a length
+        struct mg_str* encoding = mg_get_http_header(hm, "Transfer-Encoding");
+        if (encoding != NULL && mg_vcasecmp(encoding, "chunked") == 0) {
+            transfer->failed = true;
+            mg_http_send_error(nc, 411, NULL);
+            nc->flags |= MG_F_SEND_AND_CLOSE;
+        }
+        else if (path.empty()) {
+            transfer->failed = true;
+            mg_http_send_error(nc, 404, NULL);
+            nc->flags |= MG_F_SEND_AND_CLOSE;
+        }
+        else if (io::directoryExists(path)) {
+            transfer->failed = true;
+            mg_http_send_error(nc, 409, NULL);
+            nc->flags |= MG_F_SEND_AND_CLOSE;
+        }
+        else if (R_FAILED(io::createDirectory(path))) {
+            fail_backup_upload(nc, transfer, 500);
+        }
+    }
+
+    if (!transfer->failed && !transfer->reader->write(hm->body.p, hm->body.len)) {
+        Logger::getInstance().log(Logger::ERROR, "Failed to extract the upload into %s.", transfer->path.c_str());
+        fail_backup_upload(nc, transfer, 400);
+    }
+    nc->flags |= MG_F_DELETE_CHUNK;
+}
+
+static void handle_backup_upload(struct mg_connection* nc, struct http_message* hm)
+{
+    BackupTransfer* transfer = (BackupTransfer*)nc->user_data;
+    if (transfer == NULL || transfer->reader == nullptr) {
+        mg_http_send_error(nc, 400, NULL);
+        return;
+    }
+
+    if (!transfer->failed) {
+        if (transfer->reader->finished()) {
+            std::string body = StringUtils::format("{\"files\":%lu}", (unsigned long)transfer->reader->files());
+            mg_printf(nc, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: %lu\r\n\r\n%s", (unsigned long)body.length(),
+                body.c_str());
+            Logger::getInstance().log(Logger::INFO, "A backup has been uploaded to %s.", transfer->path.c_str());
+            // the backup list gets refreshed by the main thread
+            std::lock_guard<std::mutex> lock(g_uploadedBackupsMutex);
+            g_uploadedBackupIds.push_back(transfer->id);
+        }
+        else {
+            fail_backup_upload(nc, transfer, 400);
+        }
+    }
+    delete transfer;
+    nc->user_data = NULL;
+}
+
+static void send_feed(struct mg_connection* nc, const std::vector<OperationFeed::Message>& messages)
+{
+    for (auto& message : messages) {
+        if (nc->send_mbuf.len > FEED_HARD_LIMIT) {
+            nc->flags |= MG_F_CLOSE_IMMEDIATELY;
+            return;
+        }
+        if (message.droppable && nc->send_mbuf.len > FEED_SOFT_LIMIT) {
+            continue;
+        }
+        mg_send_websocket_frame(nc, WEBSOCKET_OP_TEXT, message.json.c_str(), message.json.length());
+    }
+}
+
+static void broadcast_feed(void)
+{
+    if (!OperationFeed::getInstance().pending()) {
+        return;
+    }
+    const std::vector<OperationFeed::Message> messages = OperationFeed::getInstance().drain();
+    for (struct mg_connection* c = mg_next(&mgr, NULL); c != NULL; c = mg_next(&mgr, c)) {
+        if ((c->flags & MG_F_IS_WEBSOCKET) && c->listener != NULL) {
+            send_feed(c, messages);
+        }
+    }
+}
+
 static void ev_handler(struct mg_connection* nc, int ev, void* ev_data)
 {
     struct http_message* hm = (struct http_message*)ev_data;
@@ -73,10 +377,59 @@ static void ev_handler(struct mg_connection* nc, int ev, void* ev_data)
             else if (mg_vcmp(&hm->uri, "/populate") == 0) {
                 handle_populate(nc, hm);
             }
+            else if (mg_vcmp(&hm->uri, "/config") == 0) {
+                handle_config(nc, hm);
+            }
+            else if (mg_vcmp(&hm->uri, "/titles") == 0) {
+                handle_titles(nc, hm);
+            }
+            else if (mg_vcmp(&hm->uri, "/backups") == 0) {
+                handle_backups(nc, hm);
+            }
+            else if (mg_vcmp(&hm->uri, "/metrics") == 0) {
+                handle_metrics(nc);
+            }
+            else if (mg_vcmp(&hm->uri, "/backup") == 0) {
+                if (mg_vcmp(&hm->method, "PUT") == 0) {
+                    handle_backup_upload(nc, hm);
+                }
+                else {
+                    handle_backup_download(nc, hm);
+                }
+            }
             else {
                 mg_serve_http(nc, hm, s_http_server_opts);
             }
             break;
+        case MG_EV_HTTP_CHUNK:
+            if (mg_vcmp(&hm->uri, "/backup") == 0 && mg_vcmp(&hm->method, "PUT") == 0) {
+                handle_backup_chunk(nc, hm);
+            }
+            break;
+        case MG_EV_WEBSOCKET_HANDSHAKE_REQUEST:
+            if (mg_vcmp(&hm->uri, "/feed") != 0) {
+                mg_http_send_error(nc, 404, NULL);
+            }
+            break;
+        case MG_EV_WEBSOCKET_HANDSHAKE_DONE:
+            send_feed(nc, OperationFeed::getInstance().current());
+            break;
+        case MG_EV_SEND:
+            if (nc->user_data != NULL && ((BackupTransfer*)nc->user_data)->writer != nullptr) {
+                pump_backup(nc);
+            }
+            break;
+        case MG_EV_CLOSE:
+            if (nc->user_data != NULL) {
+                BackupTransfer* transfer = (BackupTransfer*)nc->user_data;
+                // a dropped upload leaves no half written backup behind
+                if (transfer->reader != nullptr && !transfer->failed) {
+                    io::deleteFolderRecursively(transfer->path + "/");
+                }
+                delete transfer;
+                nc->user_data = NULL;
+            }
+            break;
         default:
             break;
     }
@@ -110,10 +463,23 @@ Configuration::Configuration(void)
             mJson["pksm-bridge"] = false;
             updateJson           = true;
         }
+        if (!(mJson.contains("pksm-bridge-legacy") && mJson["pksm-bridge-legacy"].is_boolean())) {
+            // released PKSM builds only read the bare save
+            mJson["pksm-bridge-legacy"] = true;
+            updateJson                  = true;
+        }
         if (!(mJson.contains("ftp-enabled") && mJson["ftp-enabled"].is_boolean())) {
             mJson["ftp-enabled"] = false;
             updateJson           = true;
         }
+        if (!(mJson.contains("sync-server") && mJson["sync-server"].is_string())) {
+            mJson["sync-server"] = "";
+            updateJson           = true;
+        }
+        if (!(mJson.contains("sync-name") && mJson["sync-name"].is_string())) {
+            mJson["sync-name"] = "";
+            updateJson         = true;
+        }
         if (!(mJson.contains("filter") && mJson["filter"].is_array())) {
             mJson["filter"] = nlohmann::json::array();
             updateJson      = true;
@@ -191,16 +557,20 @@ void Configuration::store(void)
 
 bool Configuration::filter(u64 id)
 {
+    std::lock_guard<std::mutex> lock(mMutex);
     return mFilterIds.find(id) != mFilterIds.end();
 }
 
 bool Configuration::favorite(u64 id)
 {
+    std::lock_guard<std::mutex> lock(mMutex);
     return mFavoriteIds.find(id) != mFavoriteIds.end();
 }
 
 std::vector<std::string> Configuration::additionalSaveFolders(u64 id)
 {
+    // the folders are copied out under the lock, parse() may replace the map meanwhile
+    std::lock_guard<std::mutex> lock(mMutex);
     std::vector<std::string> emptyvec;
     auto folders = mAdditionalSaveFolders.find(id);
     return folders == mAdditionalSaveFolders.end() ? emptyvec : folders->second;
@@ -211,9 +581,45 @@ bool Configuration::isPKSMBridgeEnabled(void)
     return PKSMBridgeEnabled;
 }
 
+int Configuration::serverPollfds(std::vector<struct pollfd>& fds)
+{
+    // mongoose delivers its poll event, which drives websocket pings, at least once a second
+    int timeout = OperationFeed::getInstance().pending() ? 0 : 1000;
+    for (struct mg_connection* c = mg_next(&mgr, NULL); c != NULL; c = mg_next(&mgr, c)) {
+        if ((c->flags & MG_F_CLOSE_IMMEDIATELY) || ((c->flags & MG_F_SEND_AND_CLOSE) && c->send_mbuf.len == 0)) {
+            timeout = 0;
+        }
+        if (c->ev_timer_time > 0) {
+            timeout = std::min(timeout, std::max(0, (int)((c->ev_timer_time - mg_time()) * 1000) + 1));
+        }
+        if (c->sock == INVALID_SOCKET) {
+            continue;
+        }
+
+        // the same conditions mongoose selects on
+        short events = 0;
+        if (c->recv_mbuf.len < c->recv_mbuf_limit) {
+            events |= POLLIN;
+        }
+        if (((c->flags & MG_F_CONNECTING) && !(c->flags & MG_F_WANT_READ)) || (c->send_mbuf.len > 0 && !(c->flags & MG_F_CONNECTING))) {
+            events |= POLLOUT;
+        }
+        fds.push_back({c->sock, events, 0});
+    }
+#if MG_ENABLE_BROADCAST
+    // mg_broadcast wakes the manager through its control socket pair, it only
+    // exists when enabled on top of CS_P_CUSTOM, which leaves it off by default
+    if (mgr.ctl[1] != INVALID_SOCKET) {
+        fds.push_back({mgr.ctl[1], POLLIN, 0});
+    }
+#endif
+    return timeout;
+}
+
 void Configuration::pollServer(void)
 {
-    mg_mgr_poll(&mgr, 1000 / 60);
+    mg_mgr_poll(&mgr, 0);
+    broadcast_feed();
 }
 
 void Configuration::save(void)
@@ -236,24 +642,25 @@ void Configuration::load(void)
         mJson = nlohmann::json::parse(in, nullptr, false);
         fclose(in);
     }
+    mRevision++;
 }
 
 void Configuration::parse(void)
 {
-    mFilterIds.clear();
-    mFavoriteIds.clear();
-    mAdditionalSaveFolders.clear();
+    // everything the main thread reads is built aside and swapped in under the lock
+    std::unordered_set<u64> filterIds, favoriteIds;
+    std::unordered_map<u64, std::vector<std::string>> additionalSaveFolders;
 
     // parse filters
     std::vector<std::string> filter = mJson["filter"];
     for (auto& id : filter) {
-        mFilterIds.emplace(strtoull(id.c_str(), NULL, 16));
+        filterIds.emplace(strtoull(id.c_str(), NULL, 16));
     }
 
     // parse favorites
     std::vector<std::string> favorites = mJson["favorites"];
     for (auto& id : favorites) {
-        mFavoriteIds.emplace(strtoull(id.c_str(), NULL, 16));
+        favoriteIds.emplace(strtoull(id.c_str(), NULL, 16));
     }
 
     // parse additional save folders
@@ -264,13 +671,26 @@ void Configuration::parse(void)
         for (auto& folder : folders) {
             sfolders.push_back(folder);
         }
-        mAdditionalSaveFolders.emplace(strtoull(it.key().c_str(), NULL, 16), sfolders);
+        additionalSaveFolders.emplace(strtoull(it.key().c_str(), NULL, 16), sfolders);
     }
 
     // parse PKSM Bridge flag
     PKSMBridgeEnabled = mJson["pksm-bridge"];
+    PKSMBridgeLegacy  = mJson["pksm-bridge-legacy"];
     // parse FTP flag
     FTPEnabled = mJson["ftp-enabled"];
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mFilterIds.swap(filterIds);
+    mAdditionalSaveFolders.swap(additionalSaveFolders);
+    // titles get reordered by the main thread
+    if (mFavoriteIds != favoriteIds) {
+        mFavoriteIds.swap(favoriteIds);
+        g_favoritesChanged = true;
+    }
+    // parse backup mirror
+    mSyncServer = mJson["sync-server"];
+    mSyncName   = mJson["sync-name"];
 }
 
 const char* Configuration::c_str(void)
@@ -278,12 +698,34 @@ const char* Configuration::c_str(void)
     return mJson.dump().c_str();
 }
 
-nlohmann::json Configuration::getJson(void)
+const nlohmann::json& Configuration::getJson(void) const
 {
     return mJson;
 }
 
+u32 Configuration::revision(void) const
+{
+    return mRevision;
+}
+
+bool Configuration::isPKSMBridgeLegacy(void)
+{
+    return PKSMBridgeLegacy;
+}
+
 bool Configuration::isFTPEnabled(void)
 {
     return FTPEnabled;
 }
+
+std::string Configuration::syncServer(void)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mSyncServer;
+}
+
+std::string Configuration::syncName(void)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mSyncName.empty() ? "switch" : mSyncName;
+}
@@ -0,0 +1,296 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "ftpnamespace.hpp"
+#include "json.hpp"
+#include "tar.hpp"
+#include <algorithm>
+#include <errno.h>
+#include <memory>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unordered_map>
+#include <vector>
+extern "C" {
+#include "ftp.h"
+}
+
+#define BACKUP_ROOT "sdmc:/switch/Checkpoint/saves"
+#define MOUNT_ROOT "/checkpoint"
+#define MANIFEST "manifest.json"
+#define ARCHIVE_EXTENSION ".tar"
+
+// what a path of the namespace resolves to
+struct Node {
+    enum Kind { ROOT, TITLE, MANIFEST_FILE, ARCHIVE } kind;
+    std::string folder;
+    std::string backup;
+};
+
+struct VirtualDir {
+    std::vector<std::string> entries;
+    size_t pos;
+};
+
+// the manifest of a title folder, with the archive size of every backup in it
+struct Manifest {
+    time_t modified;
+    std::string data;
+    std::unordered_map<std::string, int64_t> sizes;
+};
+
+// a manifest is generated whole when opened, archives block by block
+struct VirtualFile {
+    std::unique_ptr<TarWriter> writer;
+    std::string data;
+    size_t pos;
+};
+
+static bool isDirectory(const std::string& path, struct stat* st)
+{
+    return stat(path.c_str(), st) == 0 && S_ISDIR(st->st_mode);
+}
+
+static std::vector<std::string> folders(const std::string& path)
+{
+    std::vector<std::string> entries;
+    DIR* dir = opendir(path.c_str());
+    if (dir != NULL) {
+        struct dirent* entry;
+        struct stat st;
+        while ((entry = readdir(dir)) != NULL) {
+            if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0 &&
+                isDirectory(path + "/" + entry->d_name, &st)) {
+                entries.push_back(entry->d_name);
+            }
+        }
+        closedir(dir);
+    }
+    return entries;
+}
+
+// paths are confined to the backup folders: every component has to name one of them
+static bool resolve(const char* path, Node& node)
+{
+    const std::string rest = path + strlen(MOUNT_ROOT);
+    std::vector<std::string> parts;
+    for (size_t pos = 0; pos < rest.length();) {
+        const size_t end = std::min(rest.find('/', pos + 1), rest.length());
+        parts.push_back(rest.substr(pos + 1, end - pos - 1));
+        if (parts.back().empty() || parts.back() == "." || parts.back() == ".." || parts.size() > 2) {
+            return false;
+        }
+        pos = end;
+    }
+
+    node.kind = parts.empty() ? Node::ROOT : Node::TITLE;
+    if (!parts.empty()) {
+        node.folder = parts[0];
+    }
+    if (parts.size() == 2 && parts[1] == MANIFEST) {
+        node.kind = Node::MANIFEST_FILE;
+    }
+    else if (parts.size() == 2) {
+        const size_t ext = strlen(ARCHIVE_EXTENSION);
+        if (parts[1].length() <= ext || parts[1].compare(parts[1].length() - ext, ext, ARCHIVE_EXTENSION) != 0) {
+            return false;
+        }
+        node.kind   = Node::ARCHIVE;
+        node.backup = parts[1].substr(0, parts[1].length() - ext);
+    }
+    return node.backup != "." && node.backup != "..";
+}
+
+// manifests walk every backup of a title, they are only rebuilt once backups
+// were added to or removed from its folder. only touched by the network thread
+static std::unordered_map<std::string, Manifest> manifests;
+
+static const Manifest& manifest(const std::string& folder, const struct stat& st)
+{
+    Manifest& cached = manifests[folder];
+    if (cached.modified == st.st_mtime && !cached.data.empty()) {
+        return cached;
+    }
+
+    // the folders Title::init creates are named after the title id, followed by its name
+    const bool titled   = folder.length() > 19 && folder[18] == ' ';
+    nlohmann::json json = {{"title", titled ? folder.substr(0, 18) : ""}, {"name", titled ? folder.substr(19) : folder},
+        {"backups", nlohmann::json::array()}};
+    cached.sizes.clear();
+    for (auto& backup : folders(BACKUP_ROOT "/" + folder)) {
+        const std::string path = BACKUP_ROOT "/" + folder + "/" + backup;
+        size_t files           = 0;
+        struct stat backupSt;
+        const int64_t size   = TarWriter::size(path, &files);
+        cached.sizes[backup] = size;
+        if (size >= 0 && stat(path.c_str(), &backupSt) == 0) {
+            json["backups"].push_back({{"name", backup}, {"archive", backup + ARCHIVE_EXTENSION}, {"size", size}, {"files", files},
+                {"modified", backupSt.st_mtime}});
+        }
+    }
+    cached.data = json.dump(2) + "\n";
+    // the folder can still change within the second its mtime was taken in, such a manifest is only used once
+    cached.modified = time(NULL) > st.st_mtime + 1 ? st.st_mtime : -1;
+    return cached;
+}
+
+static int vfsStat(const char* path, struct stat* st)
+{
+    Node node;
+    if (!resolve(path, node)) {
+        errno = ENOENT;
+        return -1;
+    }
+
+    const std::string folder = node.kind == Node::ROOT ? BACKUP_ROOT : BACKUP_ROOT "/" + node.folder;
+    if (!isDirectory(folder, st)) {
+        errno = ENOENT;
+        return -1;
+    }
+
+    if (node.kind == Node::ARCHIVE) {
+        const Manifest& titleManifest = manifest(node.folder, *st);
+        auto size                     = titleManifest.sizes.find(node.backup);
+        if (size == titleManifest.sizes.end() || !isDirectory(folder + "/" + node.backup, st)) {
+            errno = ENOENT;
+            return -1;
+        }
+        if (size->second < 0) {
+            errno = EIO;
+            return -1;
+        }
+        st->st_mode = S_IFREG | 0444;
+        st->st_size = size->second;
+    }
+    else if (node.kind == Node::MANIFEST_FILE) {
+        st->st_mode = S_IFREG | 0444;
+        st->st_size = manifest(node.folder, *st).data.length();
+    }
+    else {
+        st->st_mode = S_IFDIR | 0555;
+        st->st_size = 0;
+    }
+    st->st_nlink = 1;
+    return 0;
+}
+
+static void* vfsOpendir(const char* path)
+{
+    Node node;
+    struct stat st;
+    if (!resolve(path, node) || node.kind == Node::MANIFEST_FILE || node.kind == Node::ARCHIVE) {
+        errno = ENOTDIR;
+        return NULL;
+    }
+    if (vfsStat(path, &st) != 0) {
+        return NULL;
+    }
+
+    VirtualDir* dir = new VirtualDir{{}, 0};
+    if (node.kind == Node::ROOT) {
+        dir->entries = folders(BACKUP_ROOT);
+    }
+    else {
+        dir->entries.push_back(MANIFEST);
+        for (auto& backup : folders(BACKUP_ROOT "/" + node.folder)) {
+            dir->entries.push_back(backup + ARCHIVE_EXTENSION);
+        }
+    }
+    return dir;
+}
+
+static const char* vfsReaddir(void* handle)
+{
+    VirtualDir* dir = (VirtualDir*)handle;
+    return dir->pos < dir->entries.size() ? dir->entries[dir->pos++].c_str() : NULL;
+}
+
+static void vfsClosedir(void* handle)
+{
+    delete (VirtualDir*)handle;
+}
+
+static void* vfsOpen(const char* path)
+{
+    Node node;
+    struct stat st;
+    if (vfsStat(path, &st) != 0 || !resolve(path, node)) {
+        return NULL;
+    }
+
+    if (node.kind == Node::ARCHIVE) {
+        return new VirtualFile{std::make_unique<TarWriter>(BACKUP_ROOT "/" + node.folder + "/" + node.backup), "", 0};
+    }
+    else if (node.kind == Node::MANIFEST_FILE && isDirectory(BACKUP_ROOT "/" + node.folder, &st)) {
+        return new VirtualFile{nullptr, manifest(node.folder, st).data, 0};
+    }
+    errno = EISDIR;
+    return NULL;
+}
+
+static ssize_t vfsRead(void* handle, void* buffer, size_t size)
+{
+    VirtualFile* file = (VirtualFile*)handle;
+    if (file->writer) {
+        return file->writer->read((char*)buffer, size);
+    }
+
+    const size_t len = std::min(size, file->data.length() - file->pos);
+    memcpy(buffer, file->data.c_str() + file->pos, len);
+    file->pos += len;
+    return len;
+}
+
+static int vfsSeek(void* handle, off_t offset)
+{
+    VirtualFile* file = (VirtualFile*)handle;
+    if (file->writer) {
+        return file->writer->skip(offset) ? 0 : -1;
+    }
+    if ((size_t)offset > file->data.length()) {
+        return -1;
+    }
+    file->pos = offset;
+    return 0;
+}
+
+static void vfsClose(void* handle)
+{
+    delete (VirtualFile*)handle;
+}
+
+static const ftp_vfs_t vfs = {MOUNT_ROOT, vfsStat, vfsOpendir, vfsReaddir, vfsClosedir, vfsOpen, vfsRead, vfsSeek, vfsClose};
+
+void FtpNamespace::mount(void)
+{
+    ftp_mount(&vfs);
+}
+
+void FtpNamespace::unmount(void)
+{
+    ftp_mount(NULL);
+}
@@ -57,11 +57,13 @@ void io::copyFile(const std::string& srcPath, const std::string& dstPath)
 
     size_t slashpos = srcPath.rfind("/");
     g_currentFile   = srcPath.substr(slashpos + 1, srcPath.length() - slashpos - 1);
+    OperationFeed::getInstance().fileStarted(g_currentFile, sz);
 
     while (offset < sz) {
         u32 count = fread((char*)buf, 1, BUFFER_SIZE, src);
         fwrite((char*)buf, 1, count, dst);
         offset += count;
+        OperationFeed::getInstance().fileProgress(offset);
 
         // avoid freezing the UI
         // this will be made less horrible next time...
@@ -72,11 +74,14 @@ void io::copyFile(const std::string& srcPath, const std::string& dstPath)
     delete[] buf;
     fclose(src);
     fclose(dst);
+    OperationFeed::getInstance().fileFinished();
+    Metrics::getInstance().add(Metrics::COPIED_FILES);
+    Metrics::getInstance().add(Metrics::COPIED_BYTES, offset);
 
     // commit each file to the save
     if (dstPath.rfind("save:/", 0) == 0) {
         Logger::getInstance().log(Logger::ERROR, "Committing file " + dstPath + " to the save archive.");
-        fsdevCommitDevice("save");
+        Metrics::getInstance().add(R_SUCCEEDED(fsdevCommitDevice("save")) ? Metrics::SAVE_COMMITS : Metrics::SAVE_COMMIT_FAILURES);
     }
 
     g_isTransferringFile = false;
@@ -151,7 +156,7 @@ Result io::deleteFolderRecursively(const std::string& path)
     return 0;
 }
 
-std::tuple<bool, Result, std::string> io::backup(size_t index, AccountUid uid, size_t cellIndex)
+static std::tuple<bool, Result, std::string> backupTitle(size_t index, AccountUid uid, size_t cellIndex)
 {
     const bool isNewFolder                    = cellIndex == 0;
     Result res                                = 0;
@@ -257,7 +262,7 @@ std::tuple<bool, Result, std::string> io::backup(size_t index, AccountUid uid, s
     return ret;
 }
 
-std::tuple<bool, Result, std::string> io::restore(size_t index, AccountUid uid, size_t cellIndex, const std::string& nameFromCell)
+static std::tuple<bool, Result, std::string> restoreTitle(size_t index, AccountUid uid, size_t cellIndex, const std::string& nameFromCell)
 {
     Result res                                = 0;
     std::tuple<bool, Result, std::string> ret = std::make_tuple(false, -1, "");
@@ -303,6 +308,7 @@ std::tuple<bool, Result, std::string> io::restore(size_t index, AccountUid uid,
     }
 
     res = fsdevCommitDevice("save");
+    Metrics::getInstance().add(R_SUCCEEDED(res) ? Metrics::SAVE_COMMITS : Metrics::SAVE_COMMIT_FAILURES);
     if (R_FAILED(res)) {
         Logger::getInstance().log(Logger::ERROR, "Failed to commit save with result 0x%08lX.", res);
         return std::make_tuple(false, res, "Failed to commit to save device.");
@@ -316,4 +322,29 @@ std::tuple<bool, Result, std::string> io::restore(size_t index, AccountUid uid,
 
     Logger::getInstance().log(Logger::INFO, "Restore succeeded.");
     return ret;
+}
+
+std::tuple<bool, Result, std::string> io::backup(size_t index, AccountUid uid, size_t cellIndex)
+{
+    Title title;
+    getTitle(title, uid, index);
+    OperationFeed::getInstance().begin("backup", title.name());
+    auto result = backupTitle(index, uid, cellIndex);
+    OperationFeed::getInstance().end(std::get<0>(result), std::get<2>(result));
+    Metrics::getInstance().add(std::get<0>(result) ? Metrics::BACKUPS : Metrics::BACKUP_FAILURES);
+    if (std::get<0>(result)) {
+        BackupMirror::getInstance().request();
+    }
+    return result;
+}
+
+std::tuple<bool, Result, std::string> io::restore(size_t index, AccountUid uid, size_t cellIndex, const std::string& nameFromCell)
+{
+    Title title;
+    getTitle(title, uid, index);
+    OperationFeed::getInstance().begin("restore", title.name());
+    auto result = restoreTitle(index, uid, cellIndex, nameFromCell);
+    OperationFeed::getInstance().end(std::get<0>(result), std::get<2>(result));
+    Metrics::getInstance().add(std::get<0>(result) ? Metrics::RESTORES : Metrics::RESTORE_FAILURES);
+    return result;
 }
\ No newline at end of file
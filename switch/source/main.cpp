@@ -26,18 +26,36 @@
 
 #include "main.hpp"
 #include "MainScreen.hpp"
+#include "backupmirror.hpp"
+#include "benchmark.hpp"
+#include "framescheduler.hpp"
+#include "metrics.hpp"
+#include "profiler.hpp"
+#include "reactor.hpp"
 extern "C" {
 #include "ftp.h"
 }
 
 static void networkLoop(void)
 {
-    while (appletMainLoop() && !g_shouldExitNetworkLoop) {
-        Configuration::getInstance().pollServer();
-        if (g_ftpAvailable && Configuration::getInstance().isFTPEnabled()) {
-            ftp_loop();
-        }
+    if (g_shouldExitNetworkLoop) {
+        return;
     }
+
+    Reactor& reactor = Reactor::getInstance();
+    reactor.add([](std::vector<struct pollfd>& fds) { return Configuration::getInstance().serverPollfds(fds); },
+        [](const struct pollfd*, size_t) { Configuration::getInstance().pollServer(); });
+    reactor.add(
+        [](std::vector<struct pollfd>& fds) {
+            if (g_ftpAvailable && Configuration::getInstance().isFTPEnabled()) {
+                const size_t offset = fds.size();
+                fds.resize(offset + ftp_pollfds(NULL, 0));
+                ftp_pollfds(fds.data() + offset, fds.size() - offset);
+            }
+            return -1;
+        },
+        [](const struct pollfd* fds, size_t count) { ftp_dispatch(fds, count); });
+    reactor.run();
 }
 
 int main(void)
@@ -57,21 +75,101 @@ int main(void)
     if (g_currentUId == 0)
         g_currentUId = userIds.at(0);
 
+    std::string characters;
+    for (const auto& title : getCompleteTitleList()) {
+        characters += title.second;
+    }
+    for (const auto& id : userIds) {
+        characters += Account::username(id);
+    }
+    SDLH_PrewarmGlyphs(characters);
+
     Thread networkThread;
     threadCreate(&networkThread, (ThreadFunc)networkLoop, nullptr, nullptr, 16 * 1000, 0x2C, -2);
     threadStart(&networkThread);
+    // catch up with backups made while the server was unreachable
+    BackupMirror::getInstance().request();
 
+    FrameScheduler& scheduler = FrameScheduler::getInstance();
+    Profiler& profiler        = Profiler::getInstance();
+    const auto frameStage     = profiler.stage("frame");
+    Benchmark& benchmark      = Benchmark::getInstance();
     while (appletMainLoop() && !(hidKeysDown(CONTROLLER_P1_AUTO) & KEY_PLUS)) {
         touchPosition touch;
-        hidScanInput();
-        hidTouchRead(&touch, 0);
+        {
+            ProfileScope scope("input");
+            hidScanInput();
+            hidTouchRead(&touch, 0);
+        }
+
+        if ((hidKeysHeld(CONTROLLER_P1_AUTO) & KEY_MINUS) && (hidKeysDown(CONTROLLER_P1_AUTO) & KEY_DDOWN)) {
+            profiler.toggle();
+        }
+
+        if (hidKeysDown(CONTROLLER_P1_AUTO) || hidKeysHeld(CONTROLLER_P1_AUTO) || hidKeysUp(CONTROLLER_P1_AUTO) || g_isTransferringFile) {
+            scheduler.invalidate();
+        }
 
-        g_screen->doDraw();
-        g_screen->doUpdate(&touch);
-        SDLH_Render();
+        if (g_favoritesChanged.exchange(false)) {
+            updateFavorites();
+            scheduler.invalidate();
+        }
+
+        std::vector<u64> uploadedBackupIds;
+        {
+            std::lock_guard<std::mutex> lock(g_uploadedBackupsMutex);
+            uploadedBackupIds.swap(g_uploadedBackupIds);
+        }
+        for (u64 id : uploadedBackupIds) {
+            refreshDirectories(id);
+            scheduler.invalidate();
+        }
+
+        // a running benchmark draws every frame and stands in for the input
+        const bool benchmarking = benchmark.running();
+        if (benchmarking) {
+            scheduler.invalidate();
+            benchmark.beginFrame();
+        }
+
+        if (scheduler.beginFrame(SDL_GetTicks())) {
+            const uint64_t frameStart = Profiler::now();
+            {
+                ProfileScope scope("draw");
+                g_screen->doDraw();
+                if (profiler.visible()) {
+                    drawProfiler();
+                }
+            }
+            if (!benchmarking) {
+                ProfileScope scope("input");
+                g_screen->doUpdate(&touch);
+            }
+            else {
+                benchmark.endFrame();
+            }
+            {
+                ProfileScope scope("present");
+                SDLH_Render();
+            }
+            const uint64_t frameTime = Profiler::now() - frameStart;
+            profiler.add(frameStage, frameTime);
+            Metrics::getInstance().observe(Metrics::FRAME, frameTime);
+            profiler.endFrame();
+            scheduler.endFrame(SDL_GetTicks());
+        }
+        else {
+            {
+                ProfileScope scope("input");
+                g_screen->doUpdate(&touch);
+            }
+            svcSleepThread(scheduler.sleepTime() * 1000000ULL);
+        }
     }
 
     g_shouldExitNetworkLoop = true;
+    Reactor::getInstance().stop();
+    BackupMirror::getInstance().stop();
     threadWaitForExit(&networkThread);
     threadClose(&networkThread);
 
@@ -0,0 +1,237 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "metrics.hpp"
+#include "profiler.hpp"
+#include "util.hpp"
+#include <algorithm>
+#include <string.h>
+#include <vector>
+extern "C" {
+#include "ftp.h"
+}
+
+struct CounterInfo {
+    const char* name;
+    const char* labels;
+    const char* help;
+};
+
+struct HistogramInfo {
+    const char* name;
+    const char* help;
+    // upper bounds of the buckets in microseconds
+    uint64_t bounds[Metrics::BUCKET_COUNT];
+};
+
+// the counters of a family are kept next to each other, its help and type are written before the first
+static const CounterInfo counterInfo[Metrics::COUNTER_COUNT] = {
+    {"checkpoint_copied_bytes_total", "", "Bytes copied by backups and restores."},
+    {"checkpoint_copied_files_total", "", "Files copied by backups and restores."},
+    {"checkpoint_save_commits_total", "{result=\"ok\"}", "Commits to the save archive."},
+    {"checkpoint_save_commits_total", "{result=\"failed\"}", ""},
+    {"checkpoint_operations_total", "{operation=\"backup\",result=\"ok\"}", "Backups and restores by outcome."},
+    {"checkpoint_operations_total", "{operation=\"backup\",result=\"failed\"}", ""},
+    {"checkpoint_operations_total", "{operation=\"restore\",result=\"ok\"}", ""},
+    {"checkpoint_operations_total", "{operation=\"restore\",result=\"failed\"}", ""},
+    {"checkpoint_cache_lookups_total", "{cache=\"text_runs\",result=\"hit\"}", "Lookups of the rendering, backup list and web page caches."},
+    {"checkpoint_cache_lookups_total", "{cache=\"text_runs\",result=\"miss\"}", ""},
+    {"checkpoint_cache_lookups_total", "{cache=\"text_dimensions\",result=\"hit\"}", ""},
+    {"checkpoint_cache_lookups_total", "{cache=\"text_dimensions\",result=\"miss\"}", ""},
+    {"checkpoint_cache_lookups_total", "{cache=\"backup_lists\",result=\"hit\"}", ""},
+    {"checkpoint_cache_lookups_total", "{cache=\"backup_lists\",result=\"miss\"}", ""},
+    {"checkpoint_cache_lookups_total", "{cache=\"http_responses\",result=\"hit\"}", ""},
+    {"checkpoint_cache_lookups_total", "{cache=\"http_responses\",result=\"miss\"}", ""},
+};
+
+static const HistogramInfo histogramInfo[Metrics::HISTOGRAM_COUNT] = {
+    {"checkpoint_title_load_seconds", "Time taken to load the title list.",
+        {50000, 100000, 250000, 500000, 1000000, 2000000, 4000000, 8000000, 15000000, 30000000}},
+    {"checkpoint_frame_seconds", "Time taken to draw and present a frame, frames that weren't composed aren't counted.",
+        {4000, 8000, 12000, 16667, 25000, 33333, 50000, 100000, 250000, 1000000}},
+};
+
+static const double quantiles[] = {0.5, 0.9, 0.99};
+
+// holds on to a shard for as long as its thread runs, the next thread continues counting in it
+class ShardLease {
+public:
+    ShardLease(void) : mShard(Metrics::getInstance().claim()) {}
+    ~ShardLease(void) { Metrics::getInstance().release(mShard); }
+
+    Metrics::Shard* shard(void) const { return mShard; }
+
+private:
+    Metrics::Shard* mShard;
+};
+
+Metrics::Shard* Metrics::claim(void)
+{
+    for (auto& shard : mShards) {
+        bool expected = false;
+        if (shard.claimed.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+            return &shard;
+        }
+    }
+    return &mShared;
+}
+
+void Metrics::release(Shard* shard)
+{
+    if (shard != &mShared) {
+        shard->claimed.store(false, std::memory_order_release);
+    }
+}
+
+Metrics::Shard& Metrics::local(void)
+{
+    static thread_local ShardLease lease;
+    return *lease.shard();
+}
+
+void Metrics::bump(std::atomic<uint64_t>& value, uint64_t amount, bool shared)
+{
+    // a shard with a single writer doesn't need a locked read-modify-write
+    if (shared) {
+        value.fetch_add(amount, std::memory_order_relaxed);
+    }
+    else {
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+}
+
+void Metrics::add(Counter counter, uint64_t value)
+{
+    Shard& shard = local();
+    bump(shard.counters[counter], value, &shard == &mShared);
+}
+
+void Metrics::observe(Histogram histogram, uint64_t elapsed)
+{
+    Shard& shard           = local();
+    const bool shared      = &shard == &mShared;
+    const uint64_t* bounds = histogramInfo[histogram].bounds;
+    const size_t bucket    = std::lower_bound(bounds, bounds + BUCKET_COUNT, elapsed) - bounds;
+    bump(shard.buckets[histogram][bucket], 1, shared);
+    bump(shard.sums[histogram], elapsed, shared);
+}
+
+uint64_t Metrics::counter(Counter counter) const
+{
+    uint64_t total = mShared.counters[counter].load(std::memory_order_relaxed);
+    for (const auto& shard : mShards) {
+        total += shard.counters[counter].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+static void family(std::string& out, const char* name, const char* type, const char* help)
+{
+    out += StringUtils::format("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+static void sample(std::string& out, const char* name, const char* labels, uint64_t value)
+{
+    out += StringUtils::format("%s%s %llu\n", name, labels, (unsigned long long)value);
+}
+
+static void sample(std::string& out, const char* name, const char* labels, double value)
+{
+    out += StringUtils::format("%s%s %.6f\n", name, labels, value);
+}
+
+std::string Metrics::render(void) const
+{
+    std::string out;
+    const char* previous = "";
+    for (size_t i = 0; i < COUNTER_COUNT; i++) {
+        if (strcmp(previous, counterInfo[i].name) != 0) {
+            family(out, counterInfo[i].name, "counter", counterInfo[i].help);
+            previous = counterInfo[i].name;
+        }
+        sample(out, counterInfo[i].name, counterInfo[i].labels, counter(static_cast<Counter>(i)));
+    }
+
+    for (size_t i = 0; i < HISTOGRAM_COUNT; i++) {
+        const HistogramInfo& info          = histogramInfo[i];
+        uint64_t buckets[BUCKET_COUNT + 1] = {};
+        uint64_t sum                       = mShared.sums[i].load(std::memory_order_relaxed);
+        for (size_t b = 0; b <= BUCKET_COUNT; b++) {
+            buckets[b] = mShared.buckets[i][b].load(std::memory_order_relaxed);
+        }
+        for (const auto& shard : mShards) {
+            sum += shard.sums[i].load(std::memory_order_relaxed);
+            for (size_t b = 0; b <= BUCKET_COUNT; b++) {
+                buckets[b] += shard.buckets[i][b].load(std::memory_order_relaxed);
+            }
+        }
+
+        family(out, info.name, "histogram", info.help);
+        const std::string bucketName = std::string(info.name) + "_bucket";
+        uint64_t count               = 0;
+        for (size_t b = 0; b < BUCKET_COUNT; b++) {
+            count += buckets[b];
+            sample(out, bucketName.c_str(), StringUtils::format("{le=\"%g\"}", info.bounds[b] / 1e6).c_str(), count);
+        }
+        count += buckets[BUCKET_COUNT];
+        sample(out, bucketName.c_str(), "{le=\"+Inf\"}", count);
+        sample(out, (std::string(info.name) + "_sum").c_str(), "", sum / 1e6);
+        sample(out, (std::string(info.name) + "_count").c_str(), "", count);
+    }
+
+    // the profiler keeps the last frames, which is what the percentiles of a console that is being looked at are taken from
+    std::vector<float> frames = Profiler::getInstance().history("frame");
+    family(out, "checkpoint_recent_frame_seconds", "summary", "Frame times over the last composed frames.");
+    if (!frames.empty()) {
+        double sum = 0;
+        for (float frame : frames) {
+            sum += frame;
+        }
+        for (double q : quantiles) {
+            auto it = frames.begin() + (size_t)((frames.size() - 1) * q);
+            std::nth_element(frames.begin(), it, frames.end());
+            sample(out, "checkpoint_recent_frame_seconds", StringUtils::format("{quantile=\"%g\"}", q).c_str(), *it / 1e3);
+        }
+        sample(out, "checkpoint_recent_frame_seconds_sum", "", sum / 1e3);
+    }
+    sample(out, "checkpoint_recent_frame_seconds_count", "", (uint64_t)frames.size());
+
+    // the ftp server runs on the network thread and counts without any synchronization
+    ftp_stats_t ftp;
+    ftp_stats(&ftp);
+    family(out, "checkpoint_ftp_sessions_total", "counter", "FTP command connections accepted.");
+    sample(out, "checkpoint_ftp_sessions_total", "", ftp.sessions);
+    family(out, "checkpoint_ftp_sessions", "gauge", "FTP command connections open.");
+    sample(out, "checkpoint_ftp_sessions", "", ftp.active_sessions);
+    family(out, "checkpoint_ftp_transfers_total", "counter", "FTP file transfers that have ended.");
+    sample(out, "checkpoint_ftp_transfers_total", "", ftp.transfers);
+    family(out, "checkpoint_ftp_transfer_bytes_total", "counter", "FTP file data by direction.");
+    sample(out, "checkpoint_ftp_transfer_bytes_total", "{direction=\"sent\"}", ftp.bytes_sent);
+    sample(out, "checkpoint_ftp_transfer_bytes_total", "{direction=\"received\"}", ftp.bytes_received);
+    family(out, "checkpoint_ftp_transfer_seconds_total", "counter", "Time spent with an FTP file transfer open, bytes over it are the throughput.");
+    sample(out, "checkpoint_ftp_transfer_seconds_total", "", ftp.transfer_usec / 1e6);
+    return out;
+}
@@ -0,0 +1,178 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "operationfeed.hpp"
+#include "json.hpp"
+#include "reactor.hpp"
+
+static double seconds(std::chrono::steady_clock::duration d)
+{
+    return std::chrono::duration<double>(d).count();
+}
+
+static uint64_t rate(uint64_t bytes, double elapsed)
+{
+    return elapsed > 0 ? (uint64_t)(bytes / elapsed) : 0;
+}
+
+OperationFeed::OperationFeed(void)
+    : mPending(false), mRunning(false), mProgressChanged(false), mFileSize(0), mFileDone(0), mBytes(0), mFiles(0), mDropped(0)
+{
+}
+
+void OperationFeed::begin(const std::string& operation, const std::string& title)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mRunning         = true;
+    mProgressChanged = false;
+    mOperation       = operation;
+    mTitle           = title;
+    mFile.clear();
+    mFileSize = 0;
+    mFileDone = 0;
+    mBytes    = 0;
+    mFiles    = 0;
+    mDropped  = 0;
+    mStart    = Clock::now();
+    push(beginJson(), false);
+    publish(true);
+}
+
+void OperationFeed::fileStarted(const std::string& name, uint64_t size)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mFile            = name;
+    mFileSize        = size;
+    mFileDone        = 0;
+    mFileStart       = Clock::now();
+    mProgressChanged = true;
+    publish(false);
+}
+
+void OperationFeed::fileProgress(uint64_t done)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mFileDone        = done;
+    mProgressChanged = true;
+    publish(false);
+}
+
+void OperationFeed::fileFinished(void)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    const double elapsed = seconds(Clock::now() - mFileStart);
+    mBytes += mFileDone;
+    mFiles++;
+    push(nlohmann::json{{"type", "file"}, {"name", mFile}, {"size", mFileDone}, {"bytesPerSecond", rate(mFileDone, elapsed)}}.dump(), true);
+    publish(false);
+}
+
+void OperationFeed::end(bool success, const std::string& message)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    const double elapsed = seconds(Clock::now() - mStart);
+    mRunning             = false;
+    mProgressChanged     = false;
+    push(nlohmann::json{{"type", "end"}, {"operation", mOperation}, {"title", mTitle}, {"success", success}, {"message", message}, {"files", mFiles},
+                            {"bytes", mBytes}, {"seconds", elapsed}, {"bytesPerSecond", rate(mBytes, elapsed)}, {"dropped", mDropped}}
+             .dump(),
+        false);
+    publish(true);
+}
+
+bool OperationFeed::pending(void) const
+{
+    return mPending;
+}
+
+std::vector<OperationFeed::Message> OperationFeed::drain(void)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::vector<Message> messages(mQueue.begin(), mQueue.end());
+    mQueue.clear();
+    if (mProgressChanged) {
+        messages.push_back({progressJson(), true});
+        mProgressChanged = false;
+    }
+    mPending = false;
+    return messages;
+}
+
+std::vector<OperationFeed::Message> OperationFeed::current(void)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::vector<Message> messages;
+    if (mRunning) {
+        messages.push_back({beginJson(), false});
+        messages.push_back({progressJson(), true});
+    }
+    return messages;
+}
+
+// called with the lock held
+void OperationFeed::push(std::string json, bool droppable)
+{
+    if (mQueue.size() >= QUEUE_SIZE) {
+        // make room by dropping the oldest file event, begin and end are always delivered
+        auto it = mQueue.begin();
+        while (it != mQueue.end() && !it->droppable) {
+            ++it;
+        }
+        if (it == mQueue.end() && droppable) {
+            mDropped++;
+            return;
+        }
+        mQueue.erase(it != mQueue.end() ? it : mQueue.begin());
+        mDropped++;
+    }
+    mQueue.push_back({std::move(json), droppable});
+}
+
+// called with the lock held. wakes the network thread at most every INTERVAL
+// unless forced, whatever changed in between goes out with the next wakeup
+void OperationFeed::publish(bool force)
+{
+    const Clock::time_point now = Clock::now();
+    if (!force && (mPending || now - mLastPublish < std::chrono::milliseconds(INTERVAL))) {
+        return;
+    }
+    mLastPublish = now;
+    mPending     = true;
+    Reactor::getInstance().wake();
+}
+
+std::string OperationFeed::beginJson(void) const
+{
+    return nlohmann::json{{"type", "begin"}, {"operation", mOperation}, {"title", mTitle}}.dump();
+}
+
+std::string OperationFeed::progressJson(void) const
+{
+    const double elapsed = seconds(Clock::now() - mFileStart);
+    return nlohmann::json{{"type", "progress"}, {"operation", mOperation}, {"file", mFile}, {"done", mFileDone}, {"total", mFileSize},
+        {"bytesPerSecond", rate(mFileDone, elapsed)}, {"files", mFiles}, {"bytes", mBytes + mFileDone}}
+        .dump();
+}
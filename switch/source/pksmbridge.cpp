@@ -47,6 +47,53 @@ bool validateIpAddress(const std::string& ip)
     return inet_pton(AF_INET, ip.c_str(), &sa.sin_addr) != 0;
 }
 
+// the save file the bridge exchanges: the known titles keep it next to other
+// files, everything else has to consist of a single file
+static std::string saveFile(const std::string& backupPath, u64 id)
+{
+    if (isLGPE(id)) {
+        return "/savedata.bin";
+    }
+    else if (isSWSH(id)) {
+        return "/backup";
+    }
+
+    Directory dir(backupPath);
+    if (dir.good() && dir.size() == 1 && !dir.folder(0)) {
+        return "/" + dir.entry(0);
+    }
+    return "";
+}
+
+// size older PKSM builds send without a header
+static size_t legacySize(u64 id)
+{
+    if (isLGPE(id)) {
+        return 0x100000;
+    }
+    else if (isSWSH(id)) {
+        return 0x180B19;
+    }
+    return 0;
+}
+
+// the most a transfer into path may hold: game updates grow saves a little,
+// nothing a save is replaced with is twice its size
+static uint64_t maxLength(const std::string& path, u64 id)
+{
+    struct stat st;
+    const uint64_t current = stat(path.c_str(), &st) == 0 ? st.st_size : 0;
+    const uint64_t known   = std::max(current, (uint64_t)legacySize(id));
+    return known > 0 ? 2 * known : Bridge::MAX_LENGTH;
+}
+
+// B aborts a transfer that is waiting on the other console
+static bool cancelled(void)
+{
+    hidScanInput();
+    return !appletMainLoop() || (hidKeysDown(CONTROLLER_P1_AUTO) & KEY_B);
+}
+
 std::tuple<bool, Result, std::string> sendToPKSMBrigde(size_t index, AccountUid uid, size_t cellIndex)
 {
     auto systemKeyboardAvailable = KeyboardManager::get().isSystemKeyboardAvailable();
@@ -54,167 +101,56 @@ std::tuple<bool, Result, std::string> sendToPKSMBrigde(size_t index, AccountUid
         return std::make_tuple(false, systemKeyboardAvailable.second, "System keyboard not accessible.");
     }
 
-    // load data
     Title title;
     getTitle(title, uid, index);
-    std::string filename;
-    if (isLGPE(title.id())) {
-        filename = "/savedata.bin";
-    }
-    else if (isSWSH(title.id())) {
-        filename = "/backup";
-    }
-    else {
-        return std::make_tuple(false, systemKeyboardAvailable.second, "Invalid title.");
-    }
-
-    std::string srcPath = title.fullPath(cellIndex) + filename;
-    FILE* save          = fopen(srcPath.c_str(), "rb");
-    if (save == NULL) {
-        return std::make_tuple(false, systemKeyboardAvailable.second, "Failed to open source file.");
+    std::string filename = saveFile(title.fullPath(cellIndex), title.id());
+    if (filename.empty()) {
+        return std::make_tuple(false, -1, "Invalid title.");
     }
 
-    fseek(save, 0, SEEK_END);
-    size_t size = ftell(save);
-    rewind(save);
-    char* data = new char[size];
-    fread(data, 1, size, save);
-    fclose(save);
-
     // get server address
     auto ipaddress = KeyboardManager::get().keyboard("Input PKSM IP address");
     if (!ipaddress.first || !validateIpAddress(ipaddress.second)) {
-        delete[] data;
         return std::make_tuple(false, -1, "Invalid IP address.");
     }
 
-    // send via TCP
-    int fd;
-    struct sockaddr_in servaddr;
-    if ((fd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
-        delete[] data;
-        return std::make_tuple(false, errno, "Socket creation failed.");
-    }
-    memset(&servaddr, 0, sizeof(servaddr));
-    servaddr.sin_family      = AF_INET;
-    servaddr.sin_port        = htons(PKSM_PORT);
-    servaddr.sin_addr.s_addr = inet_addr(ipaddress.second.c_str());
-
-    if (connect(fd, (struct sockaddr*)&servaddr, sizeof(servaddr)) < 0) {
-        close(fd);
-        delete[] data;
+    int fd = Bridge::connect(ipaddress.second, PKSM_PORT, cancelled);
+    if (fd < 0) {
+        Logger::getInstance().log(Logger::ERROR, "Socket connection failed with errno %d.", errno);
         return std::make_tuple(false, errno, "Socket connection failed.");
     }
 
-    size_t total = 0;
-    size_t chunk = 1024;
-    while (total < size) {
-        size_t tosend = size - total > chunk ? chunk : size - total;
-        int n         = send(fd, data + total, tosend, 0);
-        if (n == -1) {
-            break;
-        }
-        total += n;
-        fprintf(stderr, "Sent %lu bytes, %lu still missing\n", (unsigned long)total, (unsigned long)(size - total));
-    }
-
+    auto result = Bridge::send(fd, title.fullPath(cellIndex) + filename, Configuration::getInstance().isPKSMBridgeLegacy(), cancelled);
     close(fd);
-    delete[] data;
-
-    if (total == size) {
-        return std::make_tuple(true, 0, "Data sent correctly.");
-    }
-    else {
-        return std::make_tuple(false, errno, "Failed to send data.");
+    if (!std::get<0>(result)) {
+        Logger::getInstance().log(Logger::ERROR, "Failed to send pksmbridge data with errno %d.", std::get<1>(result));
     }
+    return result;
 }
 
 std::tuple<bool, Result, std::string> recvFromPKSMBridge(size_t index, AccountUid uid, size_t cellIndex)
 {
-    int fd;
-    struct sockaddr_in servaddr;
-    if ((fd = socket(AF_INET, SOCK_STREAM, IPPROTO_IP)) < 0) {
-        Logger::getInstance().log(Logger::ERROR, "Socket creation failed: %d.", fd);
-        return std::make_tuple(false, errno, "Socket creation failed.");
-    }
-
-    memset(&servaddr, 0, sizeof(servaddr));
-    servaddr.sin_family      = AF_INET;
-    servaddr.sin_port        = htons(PKSM_PORT);
-    servaddr.sin_addr.s_addr = INADDR_ANY;
-
-    if (bind(fd, (struct sockaddr*)&servaddr, sizeof(servaddr)) < 0) {
-        close(fd);
-        Logger::getInstance().log(Logger::ERROR, "Socket bind failed with errno %d.", errno);
-        return std::make_tuple(false, errno, "Socket bind failed.");
-    }
-    if (listen(fd, 5) < 0) {
-        close(fd);
-        Logger::getInstance().log(Logger::ERROR, "Socket listen failed with errno %d.", errno);
-        return std::make_tuple(false, errno, "Socket listen failed.");
-    }
-
-    int fdconn;
-    int addrlen = sizeof(servaddr);
-    if ((fdconn = accept(fd, (struct sockaddr*)&servaddr, (socklen_t*)&addrlen)) < 0) {
-        close(fd);
-        Logger::getInstance().log(Logger::ERROR, "Socket accept failed: %d.", fdconn);
-        return std::make_tuple(false, errno, "Socket accept failed.");
-    }
-
-    size_t size;
     Title title;
     getTitle(title, uid, index);
-    std::string filename;
-    if (isLGPE(title.id())) {
-        filename = "/savedata.bin";
-        size     = 0x100000;
-    }
-    else if (isSWSH(title.id())) {
-        filename = "/backup";
-        size     = 0x180B19;
-    }
-    else {
-        filename = "DEFAULT";
-        // WHAT DO WE DO ABOUT SIZE?
-    }
-    std::string srcPath = title.fullPath(cellIndex) + filename;
-    FILE* save          = fopen(srcPath.c_str(), "wb");
-    if (save == NULL) {
-        close(fd);
-        close(fdconn);
-        Logger::getInstance().log(Logger::ERROR, "Failed to open destination file with errno %d.", errno);
-        return std::make_tuple(false, errno, "Failed to open destination file.");
+    std::string filename = saveFile(title.fullPath(cellIndex), title.id());
+    if (filename.empty()) {
+        return std::make_tuple(false, -1, "Invalid title.");
     }
 
-    char* data = new char[size]();
-
-    size_t total = 0;
-    size_t chunk = 1024;
-    while (total < size) {
-        size_t torecv = size - total > chunk ? chunk : size - total;
-        int n         = recv(fdconn, data + total, torecv, 0);
-        if (n == -1) {
-            break;
-        }
-        total += n;
-        fprintf(stderr, "Recv %lu bytes, %lu still missing\n", (unsigned long)total, (unsigned long)(size - total));
+    int fd = Bridge::accept(PKSM_PORT, cancelled);
+    if (fd < 0) {
+        Logger::getInstance().log(Logger::ERROR, "Socket accept failed with errno %d.", errno);
+        return std::make_tuple(false, errno, "Socket accept failed.");
     }
 
+    const std::string path = title.fullPath(cellIndex) + filename;
+    auto result            = Bridge::recv(fd, path, legacySize(title.id()), maxLength(path, title.id()), cancelled);
     close(fd);
-    close(fdconn);
-
-    if (total == size) {
-        fwrite(data, 1, size, save);
-        fclose(save);
-        delete[] data;
+    if (std::get<0>(result)) {
         Logger::getInstance().log(Logger::INFO, "pksmbridge data received correctly.");
-        return std::make_tuple(true, 0, "Data received correctly.");
     }
     else {
-        fclose(save);
-        delete[] data;
-        Logger::getInstance().log(Logger::ERROR, "Failed to receive pksmbridge data.");
-        return std::make_tuple(false, errno, "Failed to receive data.");
+        Logger::getInstance().log(Logger::ERROR, "Failed to receive pksmbridge data with errno %d.", std::get<1>(result));
     }
+    return result;
 }
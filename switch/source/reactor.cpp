@@ -0,0 +1,121 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "reactor.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+Reactor::Reactor(void) : mRunning(true)
+{
+    mWakeFd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (mWakeFd >= 0) {
+        struct sockaddr_in addr;
+        addr.sin_family      = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port        = 0;
+
+        // connected to itself, so that wake doesn't have to know the address
+        socklen_t len = sizeof(addr);
+        if (bind(mWakeFd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || getsockname(mWakeFd, (struct sockaddr*)&addr, &len) != 0 ||
+            connect(mWakeFd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+            close(mWakeFd);
+            mWakeFd = -1;
+        }
+    }
+}
+
+Reactor::~Reactor(void)
+{
+    if (mWakeFd >= 0) {
+        close(mWakeFd);
+    }
+}
+
+void Reactor::add(Collect collect, Dispatch dispatch)
+{
+    mSources.push_back({collect, dispatch});
+}
+
+void Reactor::stop(void)
+{
+    mRunning = false;
+    wake();
+}
+
+void Reactor::wake(void)
+{
+    if (mWakeFd >= 0) {
+        const char c = 0;
+        send(mWakeFd, &c, 1, MSG_DONTWAIT);
+    }
+}
+
+void Reactor::run(void)
+{
+    while (mRunning) {
+        mFds.clear();
+        mOffsets.clear();
+        mTimeouts.clear();
+        mFds.push_back({mWakeFd, POLLIN, 0});
+
+        int timeout = IDLE_TIMEOUT;
+        for (auto& source : mSources) {
+            mOffsets.push_back(mFds.size());
+            const int deadline = source.collect(mFds);
+            mTimeouts.push_back(deadline);
+            if (deadline >= 0) {
+                timeout = std::min(timeout, deadline);
+            }
+        }
+        mOffsets.push_back(mFds.size());
+
+        const int ready = poll(mFds.data(), mFds.size(), timeout);
+        if (ready < 0) {
+            // the network went down, the sources can't do anything until it's back
+            usleep(IDLE_TIMEOUT * 1000);
+            continue;
+        }
+
+        if (mFds[0].revents & POLLIN) {
+            char buf[64];
+            while (recv(mWakeFd, buf, sizeof(buf), MSG_DONTWAIT) > 0) {}
+        }
+
+        for (size_t i = 0; i < mSources.size() && mRunning; i++) {
+            const size_t begin = mOffsets[i], end = mOffsets[i + 1];
+            bool active        = mTimeouts[i] >= 0 && mTimeouts[i] <= timeout && ready == 0;
+            for (size_t j = begin; j < end && !active; j++) {
+                active = mFds[j].revents != 0;
+            }
+            if (active || mTimeouts[i] == 0) {
+                mSources[i].dispatch(mFds.data() + begin, end - begin);
+            }
+        }
+    }
+}
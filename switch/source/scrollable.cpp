@@ -50,6 +50,7 @@ void Scrollable::push_back(SDL_Color color, SDL_Color colorMessage, const std::s
     Clickable* cell     = new Clickable(mx, my + (size() % mVisibleEntries) * spacing, mw, spacing, color, colorMessage, message, false);
     cell->selected(selected);
     mCells.push_back(cell);
+    sCellAllocations++;
 }
 
 void Scrollable::updateSelection(void)
@@ -26,24 +26,44 @@
 
 #include "title.hpp"
 
-static std::unordered_map<AccountUid, std::vector<Title>> titles;
-static std::unordered_map<u64, SDL_Texture*> icons;
+struct TitleSortKey {
+    bool favorite;
+    std::string name;
+    u32 lastPlayedTimestamp;
+    u32 playTimeMinutes;
+};
+
+// titles are stored in load order, together with their sort keys and a
+// precomputed ordering for every sort mode
+struct TitleList {
+    std::vector<Title> titles;
+    std::vector<TitleSortKey> keys;
+    std::vector<size_t> orders[SORT_MODES_COUNT];
+    SearchIndex index;
+    // active ordering restricted to the titles matching the search query
+    std::vector<size_t> view;
+};
+
+static std::unordered_map<AccountUid, TitleList> titles;
+static std::string searchQuery;
+static u32 revision = 0;
+// the grid draws icons from the atlas, only the selected title needs a full size texture
+static std::unordered_map<u64, std::vector<u8>> icons;
+static SDL_Texture* largeIcon = NULL;
+static u64 largeIconId        = 0;
 
 void freeIcons(void)
 {
-    for (auto& i : icons) {
-        SDL_DestroyTexture(i.second);
-    }
+    SDL_DestroyTexture(largeIcon);
+    largeIcon = NULL;
+    icons.clear();
 }
 
 static void loadIcon(u64 id, NsApplicationControlData* nsacd, size_t iconsize)
 {
     auto it = icons.find(id);
-    if (it == icons.end()) {
-        SDL_Texture* texture;
-        SDLH_LoadImage(&texture, nsacd->icon, iconsize);
-        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_NONE);
-        icons.insert({id, texture});
+    if (it == icons.end() && SDLH_AddAtlasIcon(id, nsacd->icon, iconsize)) {
+        icons.insert({id, std::vector<u8>(nsacd->icon, nsacd->icon + iconsize)});
     }
 }
 
@@ -87,7 +107,9 @@ void Title::init(u8 saveDataType, u64 id, AccountUid userID, const std::string&
         io::createDirectory(mPath);
     }
 
-    refreshDirectories();
+    // backup lists are built lazily, the first time the title gets focused
+    mDirectoriesLoaded    = false;
+    mDirectoriesTimestamp = 0;
 }
 
 u8 Title::saveDataType(void)
@@ -152,8 +174,21 @@ std::vector<std::string> Title::saves()
 
 SDL_Texture* Title::icon(void)
 {
-    auto it = icons.find(mId);
-    return it != icons.end() ? it->second : NULL;
+    if (largeIcon == NULL || largeIconId != mId) {
+        auto it = icons.find(mId);
+        if (it == icons.end()) {
+            return NULL;
+        }
+
+        SDL_DestroyTexture(largeIcon);
+        largeIcon = NULL;
+        SDLH_LoadImage(&largeIcon, it->second.data(), it->second.size());
+        if (largeIcon != NULL) {
+            SDL_SetTextureBlendMode(largeIcon, SDL_BLENDMODE_NONE);
+            largeIconId = mId;
+        }
+    }
+    return largeIcon;
 }
 
 u32 Title::playTimeMinutes(void)
@@ -218,10 +253,51 @@ void Title::refreshDirectories(void)
             }
         }
     }
+
+    mDirectoriesTimestamp = directoriesTimestamp();
+    mDirectoriesLoaded    = true;
+}
+
+void Title::invalidateDirectories(void)
+{
+    mDirectoriesLoaded = false;
+}
+
+bool Title::directoriesOutdated(bool checkTimestamp)
+{
+    return !mDirectoriesLoaded || (checkTimestamp && directoriesTimestamp() != mDirectoriesTimestamp);
+}
+
+time_t Title::directoriesTimestamp(void)
+{
+    // creating or deleting a backup folder updates the modification time of its parent
+    time_t timestamp = 0;
+    struct stat st;
+    if (stat(mPath.c_str(), &st) == 0) {
+        timestamp = st.st_mtime;
+    }
+
+    std::vector<std::string> additionalFolders = Configuration::getInstance().additionalSaveFolders(mId);
+    for (std::vector<std::string>::const_iterator it = additionalFolders.begin(); it != additionalFolders.end(); ++it) {
+        if (stat(it->c_str(), &st) == 0) {
+            timestamp = std::max(timestamp, st.st_mtime);
+        }
+    }
+
+    return timestamp;
+}
+
+static TitleSortKey sortKey(Title& title)
+{
+    std::string name = StringUtils::removeAccents(title.name());
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    return {Configuration::getInstance().favorite(title.id()), name, title.lastPlayedTimestamp(), title.playTimeMinutes()};
 }
 
 void loadTitles(void)
 {
+    ProfileScope scope("titles");
+    const uint64_t start = Profiler::now();
     titles.clear();
 
     FsSaveDataInfoReader reader;
@@ -271,18 +347,10 @@ void loadTitles(void)
 
                         loadIcon(tid, nsacd, outsize - sizeof(nsacd->nacp));
 
-                        // check if the vector is already created
-                        std::unordered_map<AccountUid, std::vector<Title>>::iterator it = titles.find(uid);
-                        if (it != titles.end()) {
-                            // found
-                            it->second.push_back(title);
-                        }
-                        else {
-                            // not found, insert into map
-                            std::vector<Title> v;
-                            v.push_back(title);
-                            titles.emplace(uid, v);
-                        }
+                        TitleList& list = titles[uid];
+                        list.titles.push_back(title);
+                        list.keys.push_back(sortKey(title));
+                        list.index.add(StringUtils::removeAccents(title.name()), title.id());
                     }
                 }
                 nle = NULL;
@@ -294,76 +362,186 @@ void loadTitles(void)
     fsSaveDataInfoReaderClose(&reader);
 
     sortTitles();
+    Metrics::getInstance().observe(Metrics::TITLE_LOAD, Profiler::now() - start);
+}
+
+static bool compareTitles(const TitleSortKey& l, const TitleSortKey& r, sort_t mode)
+{
+    if (l.favorite != r.favorite) {
+        return l.favorite;
+    }
+    switch (mode) {
+        case SORT_LAST_PLAYED:
+            return l.lastPlayedTimestamp > r.lastPlayedTimestamp;
+        case SORT_PLAY_TIME:
+            return l.playTimeMinutes > r.playTimeMinutes;
+        case SORT_ALPHA:
+        default:
+            return l.name < r.name;
+    }
+}
+
+static const std::vector<size_t>& visibleOrder(const TitleList& list)
+{
+    return searchQuery.empty() ? list.orders[g_sortMode] : list.view;
+}
+
+static void updateViews(void)
+{
+    revision++;
+    if (searchQuery.empty()) {
+        return;
+    }
+
+    for (auto& pair : titles) {
+        TitleList& list = pair.second;
+        std::vector<bool> matches(list.titles.size(), false);
+        for (size_t i : list.index.find(searchQuery)) {
+            matches.at(i) = true;
+        }
+
+        list.view.clear();
+        for (size_t i : list.orders[g_sortMode]) {
+            if (matches.at(i)) {
+                list.view.push_back(i);
+            }
+        }
+    }
 }
 
 void sortTitles(void)
 {
-    for (auto& vect : titles) {
-        std::sort(vect.second.begin(), vect.second.end(), [](Title& l, Title& r) {
-            if (Configuration::getInstance().favorite(l.id()) != Configuration::getInstance().favorite(r.id())) {
-                return Configuration::getInstance().favorite(l.id());
+    for (auto& pair : titles) {
+        TitleList& list = pair.second;
+        for (int mode = 0; mode < SORT_MODES_COUNT; mode++) {
+            std::vector<size_t>& order = list.orders[mode];
+            order.resize(list.titles.size());
+            std::iota(order.begin(), order.end(), 0);
+            std::stable_sort(order.begin(), order.end(),
+                [&list, mode](size_t l, size_t r) { return compareTitles(list.keys.at(l), list.keys.at(r), static_cast<sort_t>(mode)); });
+        }
+    }
+    updateViews();
+}
+
+void updateFavorites(void)
+{
+    for (auto& pair : titles) {
+        TitleList& list = pair.second;
+        for (size_t i = 0; i < list.titles.size(); i++) {
+            const bool favorite = Configuration::getInstance().favorite(list.titles.at(i).id());
+            if (favorite == list.keys.at(i).favorite) {
+                continue;
             }
-            switch (g_sortMode) {
-                case SORT_LAST_PLAYED:
-                    return l.lastPlayedTimestamp() > r.lastPlayedTimestamp();
-                case SORT_PLAY_TIME:
-                    return l.playTimeMinutes() > r.playTimeMinutes();
-                case SORT_ALPHA:
-                default:
-                    return l.name() < r.name();
+
+            // every other entry keeps its key, so moving this one keeps the orderings sorted
+            list.keys.at(i).favorite = favorite;
+            for (int mode = 0; mode < SORT_MODES_COUNT; mode++) {
+                std::vector<size_t>& order = list.orders[mode];
+                order.erase(std::find(order.begin(), order.end(), i));
+                auto pos = std::upper_bound(order.begin(), order.end(), i,
+                    [&list, mode](size_t l, size_t r) { return compareTitles(list.keys.at(l), list.keys.at(r), static_cast<sort_t>(mode)); });
+                order.insert(pos, i);
             }
-        });
+        }
     }
+    updateViews();
 }
 
 void rotateSortMode(void)
 {
     g_sortMode = static_cast<sort_t>((g_sortMode + 1) % SORT_MODES_COUNT);
-    sortTitles();
+    updateViews();
+}
+
+void searchTitles(const std::string& query)
+{
+    searchQuery = StringUtils::removeAccents(query);
+    StringUtils::trim(searchQuery);
+    updateViews();
+}
+
+std::string titleSearchQuery(void)
+{
+    return searchQuery;
+}
+
+u32 titlesRevision(void)
+{
+    return revision;
+}
+
+static void validateDirectories(Title& title)
+{
+    // only hit the sd card when the focus moves to another title or user: the cached
+    // list is otherwise kept until a backup, restore or delete invalidates it
+    static u64 focusedId         = 0;
+    static AccountUid focusedUid = {};
+    const bool focusChanged      = title.id() != focusedId || !(title.userId() == focusedUid);
+    focusedId                    = title.id();
+    focusedUid                   = title.userId();
+    if (title.directoriesOutdated(focusChanged)) {
+        title.refreshDirectories();
+        Metrics::getInstance().add(Metrics::BACKUP_LIST_MISSES);
+    }
+    else {
+        Metrics::getInstance().add(Metrics::BACKUP_LIST_HITS);
+    }
+}
+
+static Title& titleAt(TitleList& list, size_t i)
+{
+    return list.titles.at(visibleOrder(list).at(i));
 }
 
 void getTitle(Title& dst, AccountUid uid, size_t i)
 {
-    std::unordered_map<AccountUid, std::vector<Title>>::iterator it = titles.find(uid);
+    std::unordered_map<AccountUid, TitleList>::iterator it = titles.find(uid);
     if (it != titles.end() && i < getTitleCount(uid)) {
-        dst = it->second.at(i);
+        validateDirectories(titleAt(it->second, i));
+        dst = titleAt(it->second, i);
     }
 }
 
 size_t getTitleCount(AccountUid uid)
 {
-    std::unordered_map<AccountUid, std::vector<Title>>::iterator it = titles.find(uid);
-    return it != titles.end() ? it->second.size() : 0;
+    std::unordered_map<AccountUid, TitleList>::iterator it = titles.find(uid);
+    return it != titles.end() ? visibleOrder(it->second).size() : 0;
 }
 
 bool favorite(AccountUid uid, int i)
 {
-    std::unordered_map<AccountUid, std::vector<Title>>::iterator it = titles.find(uid);
-    return it != titles.end() ? Configuration::getInstance().favorite(it->second.at(i).id()) : false;
+    std::unordered_map<AccountUid, TitleList>::iterator it = titles.find(uid);
+    return it != titles.end() ? it->second.keys.at(visibleOrder(it->second).at(i)).favorite : false;
 }
 
 void refreshDirectories(u64 id)
 {
+    revision++;
     for (auto& pair : titles) {
-        for (size_t i = 0; i < pair.second.size(); i++) {
-            if (pair.second.at(i).id() == id) {
-                pair.second.at(i).refreshDirectories();
+        for (auto& title : pair.second.titles) {
+            if (title.id() == id) {
+                title.invalidateDirectories();
             }
         }
     }
 }
 
-SDL_Texture* smallIcon(AccountUid uid, size_t i)
+bool queueSmallIcon(AccountUid uid, size_t i, int x, int y)
 {
-    std::unordered_map<AccountUid, std::vector<Title>>::iterator it = titles.find(uid);
-    return it != titles.end() ? it->second.at(i).icon() : NULL;
+    std::unordered_map<AccountUid, TitleList>::iterator it = titles.find(uid);
+    if (it == titles.end() || !SDLH_HasAtlasIcon(titleAt(it->second, i).id())) {
+        return false;
+    }
+    SDLH_QueueAtlasIcon(titleAt(it->second, i).id(), x, y, 128);
+    return true;
 }
 
 std::unordered_map<std::string, std::string> getCompleteTitleList(void)
 {
     std::unordered_map<std::string, std::string> map;
-    for (const auto& pair : titles) {
-        for (auto value : pair.second) {
+    for (auto& pair : titles) {
+        for (auto& value : pair.second.titles) {
             map.insert({StringUtils::format("0x%016llX", value.id()), value.name()});
         }
     }
@@ -25,13 +25,16 @@
  */
 
 #include "util.hpp"
+#include "ftpnamespace.hpp"
 
 void servicesExit(void)
 {
     Logger::getInstance().flush();
 
-    if (g_ftpAvailable)
+    if (g_ftpAvailable) {
         ftp_exit();
+        FtpNamespace::unmount();
+    }
     if (g_notificationLedAvailable)
         hidsysExit();
     pdmqryExit();
@@ -102,6 +105,7 @@ Result servicesInit(void)
     if (R_SUCCEEDED(socinit)) {
         if (R_SUCCEEDED(res = ftp_init())) {
             g_ftpAvailable = true;
+            FtpNamespace::mount();
             Logger::getInstance().log(Logger::INFO, "FTP Server successfully loaded.");
         }
         else {
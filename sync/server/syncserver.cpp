@@ -0,0 +1,306 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+// receiving end of the backup mirror, runs on the host keeping the copies:
+//
+//   checkpoint-sync-server <folder> [port]
+//
+// every console is mirrored to <folder>/<name>, with name set on the console
+
+#include "syncprotocol.hpp"
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_set>
+
+static void createDirectories(const std::string& path)
+{
+    for (size_t pos = path.find('/', 1); pos != std::string::npos; pos = path.find('/', pos + 1)) {
+        mkdir(path.substr(0, pos).c_str(), 0755);
+    }
+    mkdir(path.c_str(), 0755);
+}
+
+// the signature of every full block of fd, at most limit of them
+static std::vector<Sync::Block> signature(int fd, uint32_t block, size_t limit)
+{
+    std::vector<Sync::Block> blocks;
+    if (fd < 0) {
+        return blocks;
+    }
+    std::vector<uint8_t> buf(block);
+    Sync::Rolling rolling;
+    for (off_t offset = 0; blocks.size() < limit && pread(fd, buf.data(), block, offset) == (ssize_t)block; offset += block) {
+        Sync::Block b;
+        rolling.reset(buf.data(), block);
+        b.weak = rolling.value();
+        Sync::strongHash(buf.data(), block, b.strong);
+        blocks.push_back(b);
+    }
+    return blocks;
+}
+
+// removes whatever the console no longer has, and folders left empty
+static void prune(const std::string& base, const std::string& relative, const std::unordered_set<std::string>& files)
+{
+    const std::string folder = relative.empty() ? base : base + "/" + relative;
+    DIR* dir                 = opendir(folder.c_str());
+    if (dir == NULL) {
+        return;
+    }
+    std::vector<std::string> names;
+    struct dirent* ent;
+    while ((ent = readdir(dir)) != NULL) {
+        if (strcmp(ent->d_name, ".") != 0 && strcmp(ent->d_name, "..") != 0) {
+            names.push_back(ent->d_name);
+        }
+    }
+    closedir(dir);
+
+    for (auto& name : names) {
+        const std::string path = relative.empty() ? name : relative + "/" + name;
+        struct stat st;
+        if (lstat((base + "/" + path).c_str(), &st) != 0) {
+            continue;
+        }
+        if (S_ISDIR(st.st_mode)) {
+            prune(base, path, files);
+            rmdir((base + "/" + path).c_str());
+        }
+        else if (files.find(path) == files.end()) {
+            printf("%s: removed\n", path.c_str());
+            unlink((base + "/" + path).c_str());
+        }
+    }
+}
+
+// false once the connection is gone
+static bool receiveFile(Sync::Channel& channel, const std::string& base)
+{
+    const std::string path = channel.getString();
+    const uint64_t size    = channel.get64();
+    const int64_t mtime    = channel.get64();
+    const uint8_t flags    = channel.get8();
+    if (channel.malformed() || !Sync::validPath(path)) {
+        channel.begin(Sync::FAILED);
+        channel.putString("Invalid path.");
+        return channel.end();
+    }
+
+    const std::string target  = base + "/" + path;
+    const std::string partial = target + ".part";
+    const std::string output  = target + ".sync";
+    const bool whole          = flags & Sync::FLAG_WHOLE;
+    // copies are stamped with the mtime they were sent with, a match is the same file
+    struct stat st;
+    if (!whole && stat(target.c_str(), &st) == 0 && (uint64_t)st.st_size == size && st.st_mtime == mtime) {
+        channel.begin(Sync::UPTODATE);
+        return channel.end();
+    }
+
+    // the basis is the current copy followed by what an interrupted transfer left
+    createDirectories(target.substr(0, target.rfind('/')));
+    const uint32_t block = Sync::blockSize(size);
+    const uint32_t limit = (Sync::MAX_MESSAGE - 8) / (4 + Sync::STRONG_SIZE);
+    int basis[2]         = {whole ? -1 : open(target.c_str(), O_RDONLY), whole ? -1 : open(partial.c_str(), O_RDONLY)};
+    const std::vector<Sync::Block> current  = signature(basis[0], block, limit);
+    const std::vector<Sync::Block> leftover = signature(basis[1], block, limit - current.size());
+    const uint32_t counts[2]                = {(uint32_t)current.size(), (uint32_t)leftover.size()};
+    channel.begin(Sync::SIGNATURE);
+    channel.put32(block);
+    channel.put32(counts[0] + counts[1]);
+    for (auto& blocks : {&current, &leftover}) {
+        for (auto& b : *blocks) {
+            channel.put32(b.weak);
+            channel.putBytes(b.strong, sizeof(b.strong));
+        }
+    }
+    bool connected = channel.end();
+
+    int out = open(output.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    SHA256_CTX ctx;
+    sha256_init(&ctx);
+    uint64_t written = 0, literal = 0;
+    bool failed      = out < 0;
+    bool complete    = false;
+    Sync::Digest digest;
+    std::vector<uint8_t> buf(block);
+    uint8_t type;
+    while (connected && !complete && channel.receive(type)) {
+        if (type == Sync::LITERAL) {
+            failed = failed || write(out, channel.payload(), channel.payloadSize()) != (ssize_t)channel.payloadSize();
+            sha256_update(&ctx, channel.payload(), channel.payloadSize());
+            written += channel.payloadSize();
+            literal += channel.payloadSize();
+        }
+        else if (type == Sync::COPY) {
+            const uint32_t first = channel.get32();
+            const uint32_t count = channel.get32();
+            for (uint32_t i = first; i < first + count && !failed; i++) {
+                const int fd       = i < counts[0] ? basis[0] : basis[1];
+                const off_t offset = (off_t)(i < counts[0] ? i : i - counts[0]) * block;
+                failed             = i >= counts[0] + counts[1] || pread(fd, buf.data(), block, offset) != (ssize_t)block ||
+                         write(out, buf.data(), block) != (ssize_t)block;
+                sha256_update(&ctx, buf.data(), block);
+                written += block;
+            }
+        }
+        else if (type == Sync::END) {
+            complete = channel.getBytes(digest, sizeof(digest));
+            break;
+        }
+        else {
+            break;
+        }
+    }
+
+    for (int fd : basis) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+    if (out >= 0) {
+        const struct timespec times[2] = {{0, UTIME_OMIT}, {(time_t)mtime, 0}};
+        failed                         = futimens(out, times) != 0 || failed;
+        close(out);
+    }
+
+    if (!complete) {
+        // keep whichever partial copy got further, the next attempt picks up from it
+        if (!failed && written > 0 && (stat(partial.c_str(), &st) != 0 || (uint64_t)st.st_size < written)) {
+            rename(output.c_str(), partial.c_str());
+            printf("%s: interrupted after %llu bytes\n", path.c_str(), (unsigned long long)written);
+        }
+        else {
+            unlink(output.c_str());
+        }
+        return false;
+    }
+
+    Sync::Digest rebuilt;
+    sha256_final(&ctx, rebuilt);
+    if (failed || written != size || memcmp(rebuilt, digest, sizeof(digest)) != 0) {
+        unlink(output.c_str());
+        printf("%s: rebuilt copy doesn't match\n", path.c_str());
+        channel.begin(failed ? Sync::FAILED : Sync::CORRUPT);
+        if (failed) {
+            channel.putString("Failed to write " + path + " on the server.");
+        }
+        return channel.end();
+    }
+
+    rename(output.c_str(), target.c_str());
+    unlink(partial.c_str());
+    printf("%s: %llu bytes, %llu sent\n", path.c_str(), (unsigned long long)size, (unsigned long long)literal);
+    channel.begin(Sync::STORED);
+    return channel.end();
+}
+
+static void session(int fd, std::string root)
+{
+    Sync::Channel channel(fd);
+    uint8_t type;
+    if (!channel.receive(type) || type != Sync::HELLO) {
+        close(fd);
+        return;
+    }
+    const uint32_t version = channel.get32();
+    const std::string name = channel.getString();
+    channel.begin(Sync::WELCOME);
+    channel.put32(Sync::VERSION);
+    channel.end();
+    if (version != Sync::VERSION || !Sync::validPath(name) || name.find('/') != std::string::npos) {
+        channel.flush();
+        close(fd);
+        return;
+    }
+
+    const std::string base = root + "/" + name;
+    createDirectories(base);
+    bool connected = true;
+    while (connected && channel.receive(type)) {
+        if (type == Sync::FILE) {
+            connected = receiveFile(channel, base);
+        }
+        else if (type == Sync::DONE) {
+            // the list covers files sent over earlier connections of an interrupted mirror too
+            std::unordered_set<std::string> files;
+            for (uint32_t i = 0, count = channel.get32(); i < count && !channel.malformed(); i++) {
+                files.insert(channel.getString());
+            }
+            if (!channel.malformed()) {
+                prune(base, "", files);
+            }
+            channel.begin(Sync::BYE);
+            channel.end();
+            channel.flush();
+            break;
+        }
+        else {
+            break;
+        }
+    }
+    close(fd);
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <folder> [port]\n", argv[0]);
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    int fd  = socket(AF_INET, SOCK_STREAM, 0);
+    int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(argc > 2 ? atoi(argv[2]) : Sync::PORT);
+    addr.sin_addr.s_addr = INADDR_ANY;
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 4) != 0) {
+        perror("listen");
+        return 1;
+    }
+
+    while (true) {
+        int conn = accept(fd, NULL, NULL);
+        if (conn >= 0) {
+            std::thread(session, conn, std::string(argv[1])).detach();
+        }
+    }
+}
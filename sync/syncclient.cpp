@@ -0,0 +1,357 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "syncclient.hpp"
+#include <algorithm>
+#include <dirent.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define READ_SIZE 0x40000
+
+typedef std::unordered_map<uint32_t, std::vector<uint32_t>> WeakIndex;
+
+static void listFiles(const std::string& root, const std::string& relative, std::vector<std::string>& files)
+{
+    DIR* dir = opendir((root + "/" + relative).c_str());
+    if (dir == NULL) {
+        return;
+    }
+    struct dirent* ent;
+    while ((ent = readdir(dir)) != NULL) {
+        const std::string name = ent->d_name;
+        if (name == "." || name == "..") {
+            continue;
+        }
+        const std::string path = relative.empty() ? name : relative + "/" + name;
+        struct stat st;
+        if (stat((root + "/" + path).c_str(), &st) != 0) {
+            continue;
+        }
+        if (S_ISDIR(st.st_mode)) {
+            listFiles(root, path, files);
+        }
+        else if (S_ISREG(st.st_mode)) {
+            files.push_back(path);
+        }
+    }
+    closedir(dir);
+}
+
+static int connectTo(const std::string& host, uint16_t port)
+{
+    struct addrinfo hints, *res;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family   = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &res) != 0) {
+        return -1;
+    }
+    int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if (fd >= 0 && connect(fd, res->ai_addr, res->ai_addrlen) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    return fd;
+}
+
+// slides a block sized window over the file, referencing every block the
+// server has and sending the bytes in between as literals. every byte of the
+// file passes through the window, so it is hashed on the way
+static bool sendDelta(Sync::Channel& channel, int fd, uint32_t block, const WeakIndex& index, const std::vector<Sync::Block>& blocks,
+    Sync::Digest digest, Sync::Stats& stats)
+{
+    SHA256_CTX ctx;
+    sha256_init(&ctx);
+    // enough for a full literal, the window and the byte rolling into it, and a read
+    const size_t capacity = Sync::MAX_LITERAL + 2 * block + READ_SIZE;
+    std::vector<uint8_t> buf(capacity);
+    size_t literal = 0, pos = 0, end = 0;
+    bool eof = false, rolled = false;
+    Sync::Rolling rolling;
+    uint32_t runStart = 0, runCount = 0;
+
+    auto flushRun = [&](void) {
+        if (runCount > 0) {
+            channel.begin(Sync::COPY);
+            channel.put32(runStart);
+            channel.put32(runCount);
+            channel.end();
+            stats.matched += (uint64_t)runCount * block;
+            runCount = 0;
+        }
+    };
+    auto flushLiteral = [&](size_t upto) {
+        if (upto > literal) {
+            flushRun();
+            channel.begin(Sync::LITERAL);
+            channel.putBytes(buf.data() + literal, upto - literal);
+            channel.end();
+            stats.literal += upto - literal;
+        }
+        literal = upto;
+    };
+
+    while (!channel.broken()) {
+        if (end - pos < block + 1 && !eof) {
+            if (capacity - end < READ_SIZE) {
+                memmove(buf.data(), buf.data() + literal, end - literal);
+                pos -= literal;
+                end -= literal;
+                literal = 0;
+            }
+            ssize_t n = read(fd, buf.data() + end, capacity - end);
+            if (n < 0) {
+                return false;
+            }
+            sha256_update(&ctx, buf.data() + end, n);
+            eof = n == 0;
+            end += n;
+            continue;
+        }
+        if (end - pos < block) {
+            break;
+        }
+
+        if (!rolled) {
+            rolling.reset(buf.data() + pos, block);
+            rolled = true;
+        }
+        auto candidates = index.find(rolling.value());
+        if (candidates != index.end()) {
+            uint8_t strong[Sync::STRONG_SIZE];
+            Sync::strongHash(buf.data() + pos, block, strong);
+            int64_t match = -1;
+            for (uint32_t i : candidates->second) {
+                if (memcmp(blocks[i].strong, strong, Sync::STRONG_SIZE) == 0) {
+                    match = i;
+                    // continuing the current run keeps it a single message
+                    if (runCount > 0 && i == runStart + runCount) {
+                        break;
+                    }
+                }
+            }
+            if (match >= 0) {
+                flushLiteral(pos);
+                if (runCount > 0 && (uint32_t)match == runStart + runCount) {
+                    runCount++;
+                }
+                else {
+                    flushRun();
+                    runStart = match;
+                    runCount = 1;
+                }
+                pos += block;
+                literal = pos;
+                rolled  = false;
+                continue;
+            }
+        }
+
+        if (end - pos == block) {
+            // the last full window, nothing left to roll in
+            break;
+        }
+        rolling.roll(buf[pos], buf[pos + block]);
+        pos++;
+        if (pos - literal >= Sync::MAX_LITERAL) {
+            flushLiteral(pos);
+        }
+    }
+
+    flushLiteral(end);
+    flushRun();
+    sha256_final(&ctx, digest);
+    return true;
+}
+
+enum SendResult { FILE_SENT, FILE_RETRY, FILE_FAILED };
+
+static SendResult sendFile(Sync::Channel& channel, const std::string& root, const std::string& path, Sync::Stats& stats, std::string& error)
+{
+    const std::string fullPath = root + "/" + path;
+    struct stat st;
+    if (stat(fullPath.c_str(), &st) != 0) {
+        error = "Failed to read " + path + ".";
+        return FILE_FAILED;
+    }
+
+    // a second attempt only happens when the rebuilt file was corrupt, it goes without a basis
+    for (uint8_t flags = 0; flags <= Sync::FLAG_WHOLE; flags++) {
+        channel.begin(Sync::FILE);
+        channel.putString(path);
+        channel.put64(st.st_size);
+        channel.put64(st.st_mtime);
+        channel.put8(flags);
+        channel.end();
+
+        uint8_t type;
+        if (!channel.receive(type)) {
+            return FILE_RETRY;
+        }
+        if (type == Sync::UPTODATE) {
+            stats.unchanged++;
+            return FILE_SENT;
+        }
+        if (type != Sync::SIGNATURE) {
+            error = type == Sync::FAILED ? channel.getString() : "Unexpected reply from the server.";
+            return FILE_FAILED;
+        }
+
+        const uint32_t block = channel.get32();
+        const uint32_t count = channel.get32();
+        std::vector<Sync::Block> blocks(count);
+        WeakIndex index;
+        for (uint32_t i = 0; i < count && !channel.malformed(); i++) {
+            blocks[i].weak = channel.get32();
+            channel.getBytes(blocks[i].strong, Sync::STRONG_SIZE);
+            index[blocks[i].weak].push_back(i);
+        }
+        if (channel.malformed() || block == 0) {
+            error = "Malformed signature from the server.";
+            return FILE_FAILED;
+        }
+
+        int fd = open(fullPath.c_str(), O_RDONLY);
+        if (fd < 0) {
+            error = "Failed to read " + path + ".";
+            return FILE_FAILED;
+        }
+        Sync::Digest digest;
+        const bool ok = sendDelta(channel, fd, block, index, blocks, digest, stats);
+        close(fd);
+        if (!ok) {
+            error = "Failed to read " + path + ".";
+            return FILE_FAILED;
+        }
+        channel.begin(Sync::END);
+        channel.putBytes(digest, sizeof(digest));
+        channel.end();
+
+        if (!channel.receive(type)) {
+            return FILE_RETRY;
+        }
+        if (type == Sync::STORED) {
+            stats.sent++;
+            return FILE_SENT;
+        }
+        if (type != Sync::CORRUPT) {
+            error = type == Sync::FAILED ? channel.getString() : "Unexpected reply from the server.";
+            return FILE_FAILED;
+        }
+    }
+    error = "The server failed to rebuild " + path + ".";
+    return FILE_FAILED;
+}
+
+bool Sync::mirror(const std::string& host, uint16_t port, const std::string& name, const std::string& root, Stats& stats, std::string& error,
+    const Cancel& cancel)
+{
+    std::vector<std::string> files;
+    listFiles(root, "", files);
+    std::sort(files.begin(), files.end());
+
+    memset(&stats, 0, sizeof(stats));
+    size_t next  = 0;
+    bool skipped = false;
+    for (int attempt = 0; attempt <= RETRIES; attempt++) {
+        if (attempt > 0) {
+            // back off 1, 2, 4... seconds, checking for cancellation in between
+            for (int i = 0; i < 10 << (attempt - 1); i++) {
+                if (cancel && cancel()) {
+                    error = "Mirror cancelled.";
+                    return false;
+                }
+                usleep(100000);
+            }
+        }
+
+        int fd = connectTo(host, port);
+        if (fd < 0) {
+            error = "Failed to connect to " + host + ".";
+            continue;
+        }
+
+        Channel channel(fd);
+        uint8_t type;
+        channel.begin(HELLO);
+        channel.put32(VERSION);
+        channel.putString(name);
+        channel.end();
+        if (!channel.receive(type) || type != WELCOME || channel.get32() != VERSION) {
+            close(fd);
+            error = "The server doesn't speak this protocol version.";
+            continue;
+        }
+
+        bool dropped = false;
+        for (; next < files.size() && !dropped; next++) {
+            if (cancel && cancel()) {
+                close(fd);
+                error = "Mirror cancelled.";
+                return false;
+            }
+            SendResult result = sendFile(channel, root, files[next], stats, error);
+            if (result == FILE_RETRY) {
+                // resume from this file, the server kept what it got of it
+                dropped = true;
+                next--;
+            }
+            else if (result == FILE_FAILED) {
+                skipped = true;
+            }
+        }
+        if (dropped) {
+            close(fd);
+            error = "Lost the connection to " + host + ".";
+            continue;
+        }
+
+        // pruning after a skipped file would delete its remote copy
+        bool done = true;
+        if (!skipped) {
+            channel.begin(DONE);
+            channel.put32(files.size());
+            for (auto& file : files) {
+                channel.putString(file);
+            }
+            channel.end();
+            done = channel.receive(type) && type == BYE;
+        }
+        close(fd);
+        if (!done) {
+            error = "Lost the connection to " + host + ".";
+            continue;
+        }
+        return !skipped;
+    }
+    return false;
+}
@@ -0,0 +1,53 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef SYNCCLIENT_HPP
+#define SYNCCLIENT_HPP
+
+#include "syncprotocol.hpp"
+#include <functional>
+
+namespace Sync {
+    struct Stats {
+        uint32_t sent;
+        uint32_t unchanged;
+        // bytes that went over the wire, and bytes the server had already
+        uint64_t literal;
+        uint64_t matched;
+    };
+
+    // polled between files and while waiting to reconnect, aborts the mirror when it returns true
+    typedef std::function<bool(void)> Cancel;
+
+    // reconnect attempts after the connection drops, the files already mirrored aren't sent again
+    static constexpr int RETRIES = 5;
+
+    // mirrors every file below root to the server, under a folder called name
+    bool mirror(const std::string& host, uint16_t port, const std::string& name, const std::string& root, Stats& stats, std::string& error,
+        const Cancel& cancel = nullptr);
+}
+
+#endif
@@ -0,0 +1,251 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "syncprotocol.hpp"
+#include <errno.h>
+#include <math.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// flush the output buffer once this much is queued
+#define SEND_THRESHOLD 0x10000
+
+// a peer going away mustn't raise SIGPIPE in the host build
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+void Sync::Rolling::reset(const uint8_t* data, size_t size)
+{
+    mA    = 0;
+    mB    = 0;
+    mSize = size;
+    for (size_t i = 0; i < size; i++) {
+        mA += data[i];
+        mB += (size - i) * data[i];
+    }
+    mA &= 0xFFFF;
+    mB &= 0xFFFF;
+}
+
+uint32_t Sync::blockSize(uint64_t size)
+{
+    uint32_t block = (uint32_t)sqrt((double)size) & ~7u;
+    return block < 0x800 ? 0x800 : block > 0x20000 ? 0x20000 : block;
+}
+
+void Sync::strongHash(const uint8_t* data, size_t size, uint8_t* out)
+{
+    BYTE hash[SHA256_BLOCK_SIZE];
+    sha256(hash, (BYTE*)data, size);
+    memcpy(out, hash, STRONG_SIZE);
+}
+
+bool Sync::validPath(const std::string& path)
+{
+    if (path.empty() || path[0] == '/' || path.find('\0') != std::string::npos || path.find(':') != std::string::npos) {
+        return false;
+    }
+    size_t start = 0;
+    while (start <= path.length()) {
+        size_t end              = path.find('/', start);
+        const std::string piece = path.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        if (piece.empty() || piece == "." || piece == "..") {
+            return false;
+        }
+        if (end == std::string::npos) {
+            break;
+        }
+        start = end + 1;
+    }
+    return true;
+}
+
+Sync::Channel::Channel(int fd) : mFd(fd), mMessageStart(0), mInPos(0), mMalformed(false), mBroken(false) {}
+
+void Sync::Channel::begin(uint8_t type)
+{
+    mMessageStart = mOut.size();
+    mOut.push_back(type);
+    mOut.resize(mOut.size() + 4);
+}
+
+void Sync::Channel::put8(uint8_t v)
+{
+    mOut.push_back(v);
+}
+
+void Sync::Channel::put32(uint32_t v)
+{
+    for (int i = 3; i >= 0; i--) {
+        mOut.push_back(v >> (8 * i));
+    }
+}
+
+void Sync::Channel::put64(uint64_t v)
+{
+    put32(v >> 32);
+    put32(v);
+}
+
+void Sync::Channel::putString(const std::string& s)
+{
+    put32(s.length());
+    putBytes(s.data(), s.length());
+}
+
+void Sync::Channel::putBytes(const void* data, size_t size)
+{
+    mOut.insert(mOut.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+}
+
+bool Sync::Channel::end(void)
+{
+    const uint32_t length = mOut.size() - mMessageStart - 5;
+    for (int i = 0; i < 4; i++) {
+        mOut[mMessageStart + 1 + i] = length >> (24 - 8 * i);
+    }
+    return mOut.size() < SEND_THRESHOLD || flush();
+}
+
+bool Sync::Channel::flush(void)
+{
+    const bool ok = sendAll(mOut.data(), mOut.size());
+    mOut.clear();
+    return ok;
+}
+
+bool Sync::Channel::receive(uint8_t& type)
+{
+    uint8_t header[5];
+    if (!flush() || !recvAll(header, sizeof(header))) {
+        return false;
+    }
+    const uint32_t length = (uint32_t)header[1] << 24 | (uint32_t)header[2] << 16 | (uint32_t)header[3] << 8 | header[4];
+    if (length > MAX_MESSAGE) {
+        return false;
+    }
+    type = header[0];
+    mIn.resize(length);
+    mInPos     = 0;
+    mMalformed = false;
+    return recvAll(mIn.data(), length);
+}
+
+uint8_t Sync::Channel::get8(void)
+{
+    uint8_t v = 0;
+    getBytes(&v, 1);
+    return v;
+}
+
+uint32_t Sync::Channel::get32(void)
+{
+    uint8_t b[4] = {0};
+    getBytes(b, 4);
+    return (uint32_t)b[0] << 24 | (uint32_t)b[1] << 16 | (uint32_t)b[2] << 8 | b[3];
+}
+
+uint64_t Sync::Channel::get64(void)
+{
+    const uint64_t high = get32();
+    return high << 32 | get32();
+}
+
+std::string Sync::Channel::getString(void)
+{
+    const uint32_t length = get32();
+    if (length > mIn.size() - mInPos) {
+        mMalformed = true;
+        return "";
+    }
+    std::string s((const char*)mIn.data() + mInPos, length);
+    mInPos += length;
+    return s;
+}
+
+bool Sync::Channel::getBytes(void* data, size_t size)
+{
+    if (size > mIn.size() - mInPos) {
+        mMalformed = true;
+        return false;
+    }
+    memcpy(data, mIn.data() + mInPos, size);
+    mInPos += size;
+    return true;
+}
+
+bool Sync::Channel::sendAll(const uint8_t* data, size_t size)
+{
+    if (mBroken) {
+        return false;
+    }
+    while (size > 0) {
+        struct pollfd pfd = {mFd, POLLOUT, 0};
+        if (poll(&pfd, 1, TIMEOUT) <= 0) {
+            mBroken = true;
+            return false;
+        }
+        ssize_t n = send(mFd, data, size, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) {
+                continue;
+            }
+            mBroken = true;
+            return false;
+        }
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool Sync::Channel::recvAll(uint8_t* data, size_t size)
+{
+    if (mBroken) {
+        return false;
+    }
+    while (size > 0) {
+        struct pollfd pfd = {mFd, POLLIN, 0};
+        if (poll(&pfd, 1, TIMEOUT) <= 0) {
+            mBroken = true;
+            return false;
+        }
+        ssize_t n = recv(mFd, data, size, 0);
+        if (n <= 0) {
+            if (n < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) {
+                continue;
+            }
+            mBroken = true;
+            return false;
+        }
+        data += n;
+        size -= n;
+    }
+    return true;
+}
@@ -0,0 +1,160 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef SYNCPROTOCOL_HPP
+#define SYNCPROTOCOL_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+extern "C" {
+#include "sha256.h"
+}
+
+// mirrors a backup folder to a remote host, sending only the blocks that changed.
+//
+// for every file the client announces its path, size and mtime. the server
+// stamps its copies with the mtime they were sent with, so a copy of the same
+// size and mtime is up to date without reading either side. otherwise it
+// answers with the signature of the data it already has: a weak rolling
+// checksum and a truncated sha256 per block, over its current copy followed by
+// whatever an interrupted transfer left behind. the client slides a window
+// over its file and sends a reference for every block the server has, and the
+// bytes in between verbatim, followed by the sha256 of the whole file. the
+// server rebuilds the file next to its copy and only replaces it once the
+// sha256 matches.
+//
+// every message is a type byte and a big endian u32 length, then the payload
+namespace Sync {
+    static constexpr uint32_t VERSION = 2;
+    static constexpr uint16_t PORT    = 34570;
+    // a connection without progress for this long is considered dead
+    static constexpr int TIMEOUT = 30000;
+    // bytes of the sha256 kept per block, the whole file hash catches collisions
+    static constexpr size_t STRONG_SIZE = 8;
+    static constexpr size_t MAX_LITERAL = 0x10000;
+    static constexpr size_t MAX_MESSAGE = 0x1000000;
+
+    enum Message : uint8_t {
+        // client
+        HELLO   = 1, // u32 version, string name
+        FILE    = 2, // string path, u64 size, u64 mtime, u8 flags
+        LITERAL = 3, // bytes
+        COPY    = 4, // u32 first block, u32 count
+        END     = 5, // sha256: the file is complete
+        DONE    = 6, // u32 count, count * string path: every file the client has, the server drops the rest
+        // server
+        WELCOME   = 16, // u32 version
+        UPTODATE  = 17,
+        SIGNATURE = 18, // u32 block size, u32 count, count * (u32 weak, strong)
+        STORED    = 19,
+        CORRUPT   = 20, // the rebuilt file didn't match, send it again without a basis
+        FAILED    = 21, // string reason
+        BYE       = 22
+    };
+
+    // FILE flags
+    static constexpr uint8_t FLAG_WHOLE = 1;
+
+    typedef uint8_t Digest[SHA256_BLOCK_SIZE];
+
+    // rsync's checksum: a is the sum of the bytes, b the sum of the running sums
+    class Rolling {
+    public:
+        Rolling(void) : mA(0), mB(0), mSize(0) {}
+
+        void reset(const uint8_t* data, size_t size);
+        // slides the window one byte: out leaves it, in enters it
+        void roll(uint8_t out, uint8_t in)
+        {
+            mA = (mA - out + in) & 0xFFFF;
+            mB = (mB - mSize * out + mA) & 0xFFFF;
+        }
+        uint32_t value(void) const { return mA | (mB << 16); }
+
+    private:
+        uint32_t mA, mB, mSize;
+    };
+
+    struct Block {
+        uint32_t weak;
+        uint8_t strong[STRONG_SIZE];
+    };
+
+    // block size for a file of the given size, grows with the square root like rsync's
+    uint32_t blockSize(uint64_t size);
+    void strongHash(const uint8_t* data, size_t size, uint8_t* out);
+
+    // a framed connection with an output buffer, so that the small COPY
+    // messages don't each cost a send
+    class Channel {
+    public:
+        Channel(int fd);
+
+        void begin(uint8_t type);
+        void put8(uint8_t v);
+        void put32(uint32_t v);
+        void put64(uint64_t v);
+        void putString(const std::string& s);
+        void putBytes(const void* data, size_t size);
+        // closes the message started by begin, sends once enough is queued
+        bool end(void);
+        bool flush(void);
+
+        // waits for the next message, flushing first
+        bool receive(uint8_t& type);
+        uint8_t get8(void);
+        uint32_t get32(void);
+        uint64_t get64(void);
+        std::string getString(void);
+        bool getBytes(void* data, size_t size);
+        const uint8_t* payload(void) const { return mIn.data(); }
+        size_t payloadSize(void) const { return mIn.size(); }
+        // true once a get ran past the end of the payload
+        bool malformed(void) const { return mMalformed; }
+        // true once the connection failed, every later call fails right away
+        bool broken(void) const { return mBroken; }
+
+    private:
+        bool sendAll(const uint8_t* data, size_t size);
+        bool recvAll(uint8_t* data, size_t size);
+
+        int mFd;
+        std::vector<uint8_t> mOut;
+        size_t mMessageStart;
+        std::vector<uint8_t> mIn;
+        size_t mInPos;
+        bool mMalformed;
+        bool mBroken;
+    };
+
+    // rejects absolute paths and paths leaving the mirror
+    bool validPath(const std::string& path);
+}
+
+#endif
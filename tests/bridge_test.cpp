@@ -0,0 +1,310 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+// loopback test of the PKSM bridge protocol: framed transfers both ways, the
+// fallbacks for older PKSM builds on either end, a corrupted payload, an
+// oversized header and a cancelled wait, followed by the throughput of a
+// framed transfer
+//
+//   bridge-test
+
+#include "bridgeprotocol.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+#define PORT 34567
+// what older PKSM builds send for Sword and Shield
+#define LEGACY_SIZE 0x180B19
+#define BENCH_SIZE (24 << 20)
+
+static int failures = 0;
+
+#define CHECK(cond)                                                                                                                            \
+    do {                                                                                                                                       \
+        if (!(cond)) {                                                                                                                         \
+            printf("%s:%d: %s failed\n", __FILE__, __LINE__, #cond);                                                                           \
+            failures++;                                                                                                                        \
+        }                                                                                                                                      \
+    } while (0)
+
+static std::string workDir;
+
+static std::string pattern(size_t size, unsigned seed)
+{
+    std::string ret(size, '\0');
+    for (size_t i = 0; i < size; i++) {
+        seed   = seed * 1103515245 + 12345;
+        ret[i] = seed >> 16;
+    }
+    return ret;
+}
+
+static void writeFile(const std::string& path, const std::string& data)
+{
+    FILE* f = fopen(path.c_str(), "wb");
+    fwrite(data.data(), 1, data.size(), f);
+    fclose(f);
+}
+
+static std::string readFile(const std::string& path)
+{
+    std::string ret;
+    FILE* f = fopen(path.c_str(), "rb");
+    if (f != NULL) {
+        char buf[0x10000];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+            ret.append(buf, n);
+        }
+        fclose(f);
+    }
+    return ret;
+}
+
+// a plain blocking client, as older PKSM builds connect
+static int rawConnect(void)
+{
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int fd               = socket(AF_INET, SOCK_STREAM, 0);
+    while (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        usleep(1000);
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+    }
+    return fd;
+}
+
+static int bridgeConnect(void)
+{
+    int fd;
+    while ((fd = Bridge::connect("127.0.0.1", PORT, nullptr)) < 0) {
+        usleep(1000);
+    }
+    return fd;
+}
+
+static int rawAccept(void)
+{
+    int fd  = socket(AF_INET, SOCK_STREAM, 0);
+    int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port   = htons(PORT);
+    bind(fd, (struct sockaddr*)&addr, sizeof(addr));
+    listen(fd, 1);
+    int conn = accept(fd, NULL, NULL);
+    close(fd);
+    return conn;
+}
+
+static std::string rawRecv(int fd, size_t size)
+{
+    std::string ret(size, '\0');
+    size_t total = 0;
+    ssize_t n;
+    while (total < size && (n = recv(fd, &ret[total], size - total, 0)) > 0) {
+        total += n;
+    }
+    ret.resize(total);
+    return ret;
+}
+
+static void testFramed(void)
+{
+    const std::string data = pattern(LEGACY_SIZE, 1);
+    writeFile(workDir + "/framed.src", data);
+
+    std::tuple<bool, int, std::string> received;
+    std::thread receiver([&] {
+        int fd   = Bridge::accept(PORT, nullptr);
+        received = Bridge::recv(fd, workDir + "/framed.dst", 0, Bridge::MAX_LENGTH, nullptr);
+        close(fd);
+    });
+    int fd    = bridgeConnect();
+    auto sent = Bridge::send(fd, workDir + "/framed.src", false, nullptr);
+    close(fd);
+    receiver.join();
+
+    CHECK(std::get<0>(sent));
+    CHECK(std::get<0>(received));
+    CHECK(readFile(workDir + "/framed.dst") == data);
+    CHECK(access((workDir + "/framed.dst.part").c_str(), F_OK) != 0);
+}
+
+// an older PKSM sends the bare save in small pieces
+static void testLegacySender(void)
+{
+    const std::string data = pattern(LEGACY_SIZE, 2);
+
+    std::tuple<bool, int, std::string> received;
+    std::thread receiver([&] {
+        int fd   = Bridge::accept(PORT, nullptr);
+        received = Bridge::recv(fd, workDir + "/legacy.dst", LEGACY_SIZE, Bridge::MAX_LENGTH, nullptr);
+        close(fd);
+    });
+    int fd = rawConnect();
+    for (size_t total = 0; total < data.size(); total += 1024) {
+        send(fd, data.data() + total, std::min((size_t)1024, data.size() - total), 0);
+    }
+    close(fd);
+    receiver.join();
+
+    CHECK(std::get<0>(received));
+    CHECK(readFile(workDir + "/legacy.dst") == data);
+}
+
+// an older PKSM reads the bare save up to its fixed size, and answers nothing
+static void testLegacyReceiver(void)
+{
+    const std::string data = pattern(LEGACY_SIZE, 3);
+    writeFile(workDir + "/old.src", data);
+
+    std::string received;
+    std::thread receiver([&] {
+        int fd   = rawAccept();
+        received = rawRecv(fd, LEGACY_SIZE);
+        close(fd);
+    });
+    int fd    = bridgeConnect();
+    auto sent = Bridge::send(fd, workDir + "/old.src", true, nullptr);
+    close(fd);
+    receiver.join();
+
+    CHECK(std::get<0>(sent));
+    CHECK(received == data);
+}
+
+static void testCorrupted(void)
+{
+    writeFile(workDir + "/corrupt.dst", "kept");
+
+    std::tuple<bool, int, std::string> received;
+    std::thread receiver([&] {
+        int fd   = Bridge::accept(PORT, nullptr);
+        received = Bridge::recv(fd, workDir + "/corrupt.dst", 0, Bridge::MAX_LENGTH, nullptr);
+        close(fd);
+    });
+    int fd = rawConnect();
+    // a header announcing a checksum the payload doesn't have
+    const unsigned char header[Bridge::HEADER_SIZE] = {'P', 'K', 'S', 'M', 'B', 'R', 'D', 'G', 0, 0, 0, 2, 1, 2, 3, 4, 0, 0, 0, 0, 0, 0, 0, 4};
+    send(fd, header, sizeof(header), 0);
+    send(fd, "abcd", 4, 0);
+    const std::string status = rawRecv(fd, 4);
+    close(fd);
+    receiver.join();
+
+    CHECK(status == std::string("\0\0\0\1", 4));
+    CHECK(!std::get<0>(received));
+    CHECK(readFile(workDir + "/corrupt.dst") == "kept");
+    CHECK(access((workDir + "/corrupt.dst.part").c_str(), F_OK) != 0);
+}
+
+// a header announcing more than the save can hold is refused before anything reaches the card
+static void testOversized(void)
+{
+    std::tuple<bool, int, std::string> received;
+    std::thread receiver([&] {
+        int fd   = Bridge::accept(PORT, nullptr);
+        received = Bridge::recv(fd, workDir + "/huge.dst", 0, LEGACY_SIZE, nullptr);
+        close(fd);
+    });
+    int fd = rawConnect();
+    // LEGACY_SIZE + 1 bytes, followed by data the receiver mustn't wait for
+    const unsigned char header[Bridge::HEADER_SIZE] = {'P', 'K', 'S', 'M', 'B', 'R', 'D', 'G', 0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x18, 0x0B, 0x1A};
+    send(fd, header, sizeof(header), 0);
+    send(fd, "abcd", 4, 0);
+    const std::string status = rawRecv(fd, 4);
+    close(fd);
+    receiver.join();
+
+    CHECK(status == std::string("\0\0\0\2", 4));
+    CHECK(!std::get<0>(received) && std::get<1>(received) == EFBIG);
+    CHECK(access((workDir + "/huge.dst.part").c_str(), F_OK) != 0);
+}
+
+static void testCancel(void)
+{
+    const auto start = std::chrono::steady_clock::now();
+    int fd           = Bridge::accept(PORT, [&] { return std::chrono::steady_clock::now() - start > std::chrono::milliseconds(300); });
+    CHECK(fd < 0 && errno == ECANCELED);
+}
+
+static void benchmark(void)
+{
+    writeFile(workDir + "/bench.src", pattern(BENCH_SIZE, 4));
+
+    const auto start = std::chrono::steady_clock::now();
+    std::thread receiver([&] {
+        int fd = Bridge::accept(PORT, nullptr);
+        CHECK(std::get<0>(Bridge::recv(fd, workDir + "/bench.dst", 0, Bridge::MAX_LENGTH, nullptr)));
+        close(fd);
+    });
+    int fd = bridgeConnect();
+    CHECK(std::get<0>(Bridge::send(fd, workDir + "/bench.src", false, nullptr)));
+    close(fd);
+    receiver.join();
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("framed transfer: %.1f MB/s\n", BENCH_SIZE / 1e6 / seconds);
+}
+
+int main(void)
+{
+    char dir[] = "/tmp/checkpoint-bridge-XXXXXX";
+    if (mkdtemp(dir) == NULL) {
+        printf("bridge-test FAILED, unable to create %s\n", dir);
+        return 1;
+    }
+    workDir = dir;
+
+    testFramed();
+    testLegacySender();
+    testLegacyReceiver();
+    testCorrupted();
+    testOversized();
+    testCancel();
+    benchmark();
+
+    system(("rm -rf " + workDir).c_str());
+    printf("%s\n", failures == 0 ? "bridge-test passed" : "bridge-test FAILED");
+    return failures == 0 ? 0 : 1;
+}
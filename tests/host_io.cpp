@@ -0,0 +1,74 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+// the filesystem helpers of switch/source/io.cpp for the host harnesses,
+// io.cpp itself needs the save data mounts of a console
+
+#include "io.hpp"
+#include <stdio.h>
+#include <sys/stat.h>
+
+bool io::fileExists(const std::string& path)
+{
+    struct stat buffer;
+    return (stat(path.c_str(), &buffer) == 0);
+}
+
+Result io::createDirectory(const std::string& path)
+{
+    mkdir(path.c_str(), 0777);
+    return 0;
+}
+
+bool io::directoryExists(const std::string& path)
+{
+    struct stat sb;
+    return (stat(path.c_str(), &sb) == 0 && S_ISDIR(sb.st_mode));
+}
+
+Result io::deleteFolderRecursively(const std::string& path)
+{
+    Directory dir(path);
+    if (!dir.good()) {
+        return dir.error();
+    }
+
+    for (size_t i = 0, sz = dir.size(); i < sz; i++) {
+        if (dir.folder(i)) {
+            std::string newpath = path + "/" + dir.entry(i) + "/";
+            deleteFolderRecursively(newpath);
+            newpath = path + dir.entry(i);
+            rmdir(newpath.c_str());
+        }
+        else {
+            std::string newpath = path + dir.entry(i);
+            std::remove(newpath.c_str());
+        }
+    }
+
+    rmdir(path.c_str());
+    return 0;
+}
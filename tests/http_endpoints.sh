@@ -0,0 +1,67 @@
+#!/bin/bash
+#---------------------------------------------------------------------------------
+# the HTTP endpoints of server-host checked with curl: the cached JSON responses,
+# the backup listing and a backup downloaded as an archive and uploaded again.
+# needs curl and tar, run after make server-host
+#---------------------------------------------------------------------------------
+cd "$(dirname "$0")"
+
+URL=http://127.0.0.1:8000
+TITLE=0x0100000000010000
+
+WORK=$(mktemp -d /tmp/checkpoint-http-XXXXXX)
+./server-host 120 > "$WORK/server.log" 2>&1 &
+SERVER=$!
+trap 'kill $SERVER 2> /dev/null; wait $SERVER 2> /dev/null; rm -rf "$WORK"' EXIT
+
+for i in $(seq 50); do
+    curl -s -o /dev/null $URL/metrics && break
+    sleep 0.1
+done
+SAVES="$(sed -n 's/^server-host serving //p' "$WORK/server.log")/sdmc:/switch/Checkpoint/saves"
+
+failures=0
+expect() {
+    if [ "$2" != "$3" ]; then
+        echo "$1: expected $3, got $2"
+        failures=$((failures + 1))
+    fi
+}
+
+# the status code of a request, the body goes to $OUTPUT if set
+status() {
+    curl -s -o "${OUTPUT:-/dev/null}" -w "%{http_code}" "$@"
+}
+
+expect "/config" "$(status $URL/config)" 200
+expect "/metrics" "$(status $URL/metrics)" 200
+
+# an unchanged title list is answered from the cache
+etag=$(curl -s -D - -o /dev/null $URL/titles | sed -n 's/^ETag: \(.*\)\r$/\1/p')
+expect "/titles etag" "$([ -n "$etag" ] && echo set)" set
+expect "/titles revalidated" "$(status -H "If-None-Match: $etag" $URL/titles)" 304
+expect "/titles stale etag" "$(status -H "If-None-Match: \"0\"" $URL/titles)" 200
+
+backups=$(curl -s $URL/backups)
+expect "/backups lists the title" "$(grep -c "\"$TITLE\"" <<< "$backups")" 1
+expect "/backups lists the backup" "$(grep -c "20190101-120000" <<< "$backups")" 1
+
+# the archive of a backup has to hold exactly its files
+source=$(echo "$SAVES/$TITLE "*/20190101-120000)
+expect "download" "$(OUTPUT="$WORK/backup.tar" status "$URL/backup?title=$TITLE&name=20190101-120000")" 200
+mkdir "$WORK/extracted" && tar -xf "$WORK/backup.tar" -C "$WORK/extracted"
+expect "downloaded archive" "$(diff -r "$source" "$WORK/extracted" > /dev/null && echo same)" same
+expect "download of a missing backup" "$(status "$URL/backup?title=$TITLE&name=19990101-000000")" 404
+expect "download outside the saves" "$(status "$URL/backup?title=$TITLE&name=..")" 404
+
+# and uploading that archive recreates it under a new name
+expect "upload" "$(status -T "$WORK/backup.tar" "$URL/backup?title=$TITLE&name=uploaded")" 200
+expect "uploaded backup" "$(diff -r "$source" "$(dirname "$source")/uploaded" > /dev/null && echo same)" same
+expect "upload over a backup" "$(status -T "$WORK/backup.tar" "$URL/backup?title=$TITLE&name=uploaded")" 409
+expect "/backups lists the upload" "$(curl -s $URL/backups | grep -c '"uploaded"')" 1
+
+if [ $failures -ne 0 ]; then
+    echo "http-endpoints FAILED"
+    exit 1
+fi
+echo "http-endpoints passed"
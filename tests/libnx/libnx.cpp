@@ -0,0 +1,221 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+// host implementation of the libnx subset in switch.h, the save data, names
+// and icons of a synthetic library of LIBRARY_TITLES titles over LIBRARY_USERS users
+
+#include "libnx.hpp"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <time.h>
+#include <vector>
+
+static const char* syllables[] = {"ka", "ro", "mi", "zel", "dra", "to", "nu", "shi", "ver", "lo", "fan", "tor", "é", "qua", "pix", "bo"};
+
+static u64 keysDown, keysHeld, keysPrevious;
+
+void hidSetKeys(u64 down, u64 held)
+{
+    keysPrevious = keysHeld;
+    keysDown     = down;
+    keysHeld     = held;
+}
+
+void hidScanInput(void) {}
+
+u64 hidKeysDown(HidControllerID)
+{
+    return keysDown;
+}
+
+u64 hidKeysHeld(HidControllerID)
+{
+    return keysHeld;
+}
+
+u64 hidKeysUp(HidControllerID)
+{
+    return keysPrevious & ~keysHeld;
+}
+
+void hidTouchRead(touchPosition* pos, u32)
+{
+    memset(pos, 0, sizeof(touchPosition));
+}
+
+u64 armGetSystemTick(void)
+{
+    // 19.2 MHz like the console
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((u64)ts.tv_sec * 1000000000ULL + ts.tv_nsec) * 12 / 625;
+}
+
+void svcSleepThread(s64 nano)
+{
+    struct timespec ts = {(time_t)(nano / 1000000000LL), (long)(nano % 1000000000LL)};
+    nanosleep(&ts, NULL);
+}
+
+AccountUid libraryUser(size_t index)
+{
+    return {{0x1000 + index, 0x2000 + index}};
+}
+
+u64 libraryTitle(size_t index)
+{
+    return 0x0100000000010000ULL + (index << 13);
+}
+
+std::string libraryName(size_t index)
+{
+    const size_t count = sizeof(syllables) / sizeof(syllables[0]);
+    std::string name;
+    size_t seed = index * 2654435761u + 7;
+    for (size_t word = 0, words = 1 + seed % 3; word < words; word++) {
+        std::string part;
+        for (size_t i = 0, n = 2 + (seed >> 4) % 3; i < n; i++) {
+            part += syllables[(seed >> (8 + i * 4)) % count];
+        }
+        part[0] = toupper(part[0]);
+        name += (word ? " " : "") + part;
+        seed = seed * 1103515245u + 12345;
+    }
+    // a few titles too long for the info panel
+    if (index % 17 == 0) {
+        name += ": The Extended Edition of an Overly Long Title";
+    }
+    return name;
+}
+
+// every title has a save for the first user, every third one for the others too
+static bool hasSave(size_t title, size_t user)
+{
+    return user == 0 || title % 3 == 0;
+}
+
+Result fsOpenSaveDataInfoReader(FsSaveDataInfoReader* reader, FsSaveDataSpaceId)
+{
+    reader->next = 0;
+    return 0;
+}
+
+Result fsSaveDataInfoReaderRead(FsSaveDataInfoReader* reader, FsSaveDataInfo* buffer, size_t count, s64* total)
+{
+    *total = 0;
+    while ((size_t)*total < count && reader->next < LIBRARY_TITLES * LIBRARY_USERS) {
+        const size_t title = reader->next / LIBRARY_USERS, user = reader->next % LIBRARY_USERS;
+        reader->next++;
+        if (hasSave(title, user)) {
+            FsSaveDataInfo& info = buffer[(*total)++];
+            memset(&info, 0, sizeof(FsSaveDataInfo));
+            info.save_data_id    = 0x8000000000000000ULL + reader->next;
+            info.uid             = libraryUser(user);
+            info.application_id  = libraryTitle(title);
+            info.save_data_type  = FsSaveDataType_Account;
+        }
+    }
+    return 0;
+}
+
+void fsSaveDataInfoReaderClose(FsSaveDataInfoReader*) {}
+
+// a 128x128 24-bit bitmap in a colour derived from the title id, SDL_image loads it like the jpeg of a real icon
+static size_t writeIcon(u64 id, u8* out, size_t size)
+{
+    const u32 side = 128, row = side * 3, pixels = row * side, total = 54 + pixels;
+    if (size < total) {
+        return 0;
+    }
+    memset(out, 0, 54);
+    const u32 header[] = {total, 0, 54, 40, side, side, 1 | 24 << 16, 0, pixels, 2835, 2835, 0, 0};
+    out[0] = 'B';
+    out[1] = 'M';
+    memcpy(out + 2, header, sizeof(header));
+    for (u32 y = 0; y < side; y++) {
+        for (u32 x = 0; x < side; x++) {
+            u8* pixel = out + 54 + y * row + x * 3;
+            pixel[0]  = (u8)(id >> 13) * 37 + x;
+            pixel[1]  = (u8)(id >> 13) * 91 + y;
+            pixel[2]  = (u8)(id >> 13) * 53;
+        }
+    }
+    return total;
+}
+
+Result nsGetApplicationControlData(NsApplicationControlSource, u64 id, NsApplicationControlData* buffer, size_t size, size_t* outsize)
+{
+    const size_t index = (size_t)((id - libraryTitle(0)) >> 13);
+    if (size < sizeof(NsApplicationControlData) || index >= LIBRARY_TITLES) {
+        return 1;
+    }
+    memset(&buffer->nacp, 0, sizeof(buffer->nacp));
+    snprintf(buffer->nacp.lang[0].name, sizeof(buffer->nacp.lang[0].name), "%s", libraryName(index).c_str());
+    snprintf(buffer->nacp.lang[0].author, sizeof(buffer->nacp.lang[0].author), "Publisher %zu", index % 40);
+    *outsize = sizeof(buffer->nacp) + writeIcon(id, buffer->icon, sizeof(buffer->icon));
+    return 0;
+}
+
+Result nacpGetLanguageEntry(NacpStruct* nacp, NacpLanguageEntry** entry)
+{
+    *entry = &nacp->lang[0];
+    return 0;
+}
+
+Result pdmqryQueryPlayStatisticsByApplicationIdAndUserAccountId(u64 id, AccountUid uid, bool, PdmPlayStatistics* stats)
+{
+    memset(stats, 0, sizeof(PdmPlayStatistics));
+    stats->application_id     = id;
+    stats->playtimeMinutes    = (u32)((id >> 13) * 7919 + uid.uid[0]) % 6000;
+    stats->last_timestampUser = 1500000000 + (u32)((id >> 13) * 104729 % 100000000);
+    return 0;
+}
+
+Result plGetSharedFontByType(PlFontData* font, PlSharedFontType type)
+{
+    static std::vector<u8> data;
+    if (data.empty()) {
+        const char* path = getenv("CHECKPOINT_FONT");
+        FILE* f          = fopen(path != NULL ? path : LIBRARY_FONT, "rb");
+        if (f == NULL) {
+            return 1;
+        }
+        fseek(f, 0, SEEK_END);
+        data.resize(ftell(f));
+        fseek(f, 0, SEEK_SET);
+        data.resize(fread(data.data(), 1, data.size(), f));
+        fclose(f);
+    }
+    // the extension font only adds button glyphs, both are served from the same file
+    font->type    = type;
+    font->offset  = 0;
+    font->size    = data.size();
+    font->address = data.data();
+    return data.empty() ? 1 : 0;
+}
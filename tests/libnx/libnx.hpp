@@ -0,0 +1,52 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef LIBNX_HPP
+#define LIBNX_HPP
+
+#include <string>
+#include <switch.h>
+
+// size of the synthetic library
+#ifndef LIBRARY_TITLES
+#define LIBRARY_TITLES 600
+#endif
+#ifndef LIBRARY_USERS
+#define LIBRARY_USERS 2
+#endif
+// shared font used when CHECKPOINT_FONT is not set
+#ifndef LIBRARY_FONT
+#define LIBRARY_FONT "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf"
+#endif
+
+// pad state returned by the hidKeys functions until the next call
+void hidSetKeys(u64 down, u64 held);
+
+AccountUid libraryUser(size_t index);
+u64 libraryTitle(size_t index);
+std::string libraryName(size_t index);
+
+#endif
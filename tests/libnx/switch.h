@@ -0,0 +1,205 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+// the subset of libnx the Switch UI is built against, so the real screens can be
+// compiled and driven on a host, see ui_alloc_count.cpp and libnx.cpp
+
+#ifndef SWITCH_H
+#define SWITCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+typedef u32 Result;
+
+#define BIT(n) (1U << (n))
+#define R_SUCCEEDED(res) ((res) == 0)
+#define R_FAILED(res) ((res) != 0)
+
+typedef struct {
+    u64 uid[2];
+} AccountUid;
+
+// hid, the pad state of the current frame is set by the host with hidSetKeys in libnx.hpp
+typedef enum {
+    KEY_A      = BIT(0),
+    KEY_B      = BIT(1),
+    KEY_X      = BIT(2),
+    KEY_Y      = BIT(3),
+    KEY_LSTICK = BIT(4),
+    KEY_RSTICK = BIT(5),
+    KEY_L      = BIT(6),
+    KEY_R      = BIT(7),
+    KEY_ZL     = BIT(8),
+    KEY_ZR     = BIT(9),
+    KEY_PLUS   = BIT(10),
+    KEY_MINUS  = BIT(11),
+    KEY_DLEFT  = BIT(12),
+    KEY_DUP    = BIT(13),
+    KEY_DRIGHT = BIT(14),
+    KEY_DDOWN  = BIT(15),
+    KEY_TOUCH  = BIT(26),
+    KEY_UP     = KEY_DUP,
+    KEY_DOWN   = KEY_DDOWN,
+    KEY_LEFT   = KEY_DLEFT,
+    KEY_RIGHT  = KEY_DRIGHT,
+} HidControllerKeys;
+
+typedef enum {
+    CONTROLLER_P1_AUTO = 10,
+} HidControllerID;
+
+typedef struct {
+    u32 px, py;
+    u32 dx, dy;
+    u32 angle;
+} touchPosition;
+
+typedef struct {
+    u8 baseMiniCycleDuration;
+    u8 totalMiniCycles;
+    u8 totalFullCycles;
+    u8 startIntensity;
+} HidsysNotificationLedPattern;
+
+void hidScanInput(void);
+u64 hidKeysDown(HidControllerID id);
+u64 hidKeysHeld(HidControllerID id);
+u64 hidKeysUp(HidControllerID id);
+void hidTouchRead(touchPosition* pos, u32 point);
+
+u64 armGetSystemTick(void);
+void svcSleepThread(s64 nano);
+
+// fs, the save data of the synthetic library
+typedef struct {
+    u32 handle;
+} FsFileSystem;
+
+typedef struct {
+    u32 next;
+} FsSaveDataInfoReader;
+
+typedef enum {
+    FsSaveDataSpaceId_System = 0,
+    FsSaveDataSpaceId_User   = 1,
+} FsSaveDataSpaceId;
+
+typedef enum {
+    FsSaveDataType_System  = 0,
+    FsSaveDataType_Account = 1,
+    FsSaveDataType_Bcat    = 2,
+    FsSaveDataType_Device  = 3,
+} FsSaveDataType;
+
+typedef struct {
+    u64 save_data_id;
+    AccountUid uid;
+    u64 system_save_data_id;
+    u64 application_id;
+    u64 size;
+    u16 save_data_index;
+    u8 save_data_rank;
+    u8 save_data_type;
+    u8 save_data_space_id;
+} FsSaveDataInfo;
+
+Result fsOpenSaveDataInfoReader(FsSaveDataInfoReader* reader, FsSaveDataSpaceId spaceId);
+Result fsSaveDataInfoReaderRead(FsSaveDataInfoReader* reader, FsSaveDataInfo* buffer, size_t count, s64* total);
+void fsSaveDataInfoReaderClose(FsSaveDataInfoReader* reader);
+
+// ns, names and icons of the synthetic library
+typedef struct {
+    char name[0x200];
+    char author[0x100];
+} NacpLanguageEntry;
+
+typedef struct {
+    NacpLanguageEntry lang[16];
+    u8 reserved[0x1000];
+} NacpStruct;
+
+typedef struct {
+    NacpStruct nacp;
+    u8 icon[0x20000];
+} NsApplicationControlData;
+
+typedef enum {
+    NsApplicationControlSource_CacheOnly = 0,
+    NsApplicationControlSource_Storage   = 1,
+} NsApplicationControlSource;
+
+Result nsGetApplicationControlData(NsApplicationControlSource source, u64 id, NsApplicationControlData* buffer, size_t size, size_t* outsize);
+Result nacpGetLanguageEntry(NacpStruct* nacp, NacpLanguageEntry** entry);
+
+// pdm
+typedef struct {
+    u64 application_id;
+    u32 first_entry_index;
+    u32 first_timestampUser;
+    u32 first_timestampNetwork;
+    u32 last_entry_index;
+    u32 last_timestampUser;
+    u32 last_timestampNetwork;
+    u32 playtimeMinutes;
+    u32 totalLaunches;
+} PdmPlayStatistics;
+
+Result pdmqryQueryPlayStatisticsByApplicationIdAndUserAccountId(u64 id, AccountUid uid, bool same, PdmPlayStatistics* stats);
+
+// pl, the shared fonts are read from CHECKPOINT_FONT or a system font
+typedef enum {
+    PlSharedFontType_Standard    = 0,
+    PlSharedFontType_NintendoExt = 5,
+} PlSharedFontType;
+
+typedef struct {
+    u32 type;
+    u32 offset;
+    u32 size;
+    void* address;
+} PlFontData;
+
+Result plGetSharedFontByType(PlFontData* font, PlSharedFontType type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,245 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+// host test of the Wii U metadata scanner and its cache, run against a
+// synthetic usr/save tree created in a temporary folder
+//
+//   meta-test
+
+#include "meta.hpp"
+#include <atomic>
+#include <dirent.h>
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <utime.h>
+#include <vector>
+
+#define TITLES_PER_STORAGE 40
+
+static int failures = 0;
+
+#define CHECK(cond)                                                                                                                            \
+    do {                                                                                                                                       \
+        if (!(cond)) {                                                                                                                         \
+            printf("%s:%d: %s failed\n", __FILE__, __LINE__, #cond);                                                                           \
+            failures++;                                                                                                                        \
+        }                                                                                                                                      \
+    } while (0)
+
+static std::atomic<int> parses(0);
+
+static bool countingParse(const std::string& path, TitleMeta& meta)
+{
+    parses++;
+    return Meta::parse(path, meta);
+}
+
+static void createDirectories(const std::string& path)
+{
+    for (size_t pos = path.find('/', 1); pos != std::string::npos; pos = path.find('/', pos + 1)) {
+        mkdir(path.substr(0, pos).c_str(), 0755);
+    }
+    mkdir(path.c_str(), 0755);
+}
+
+static void writeFile(const std::string& path, const std::string& data)
+{
+    FILE* out = fopen(path.c_str(), "wb");
+    fwrite(data.c_str(), 1, data.size(), out);
+    fclose(out);
+}
+
+// a meta.xml close to the real ones: the elements we need are spread over
+// several read chunks and surrounded by others with similar names
+static std::string metaXml(uint64_t id, const std::string& name, const std::string& publisher)
+{
+    char hexId[17];
+    snprintf(hexId, sizeof(hexId), "%016llX", (unsigned long long)id);
+    std::string xml = "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<menu type=\"complex\" access=\"777\">\n";
+    xml += "  <version type=\"unsignedInt\" length=\"4\">33</version>\n";
+    xml += "  <title_id_ex type=\"hexBinary\" length=\"8\">FFFFFFFFFFFFFFFF</title_id_ex>\n";
+    xml += std::string("  <title_id type=\"hexBinary\" length=\"8\">") + hexId + "</title_id>\n";
+    for (int i = 0; i < 200; i++) {
+        xml += "  <reserved_flag" + std::to_string(i) + " type=\"hexBinary\" length=\"4\">00000000</reserved_flag" + std::to_string(i) + ">\n";
+    }
+    xml += "  <shortname_ja type=\"string\" length=\"512\">japanese</shortname_ja>\n";
+    xml += "  <shortname_en type=\"string\" length=\"512\">" + name + "</shortname_en>\n";
+    for (int i = 0; i < 100; i++) {
+        xml += "  <longname_" + std::to_string(i) + " type=\"string\" length=\"512\">filler</longname_" + std::to_string(i) + ">\n";
+    }
+    xml += "  <publisher_en type=\"string\" length=\"256\">" + publisher + "</publisher_en>\n</menu>\n";
+    return xml;
+}
+
+static std::string bannerBin(const std::string& name)
+{
+    std::string banner(0x60A0 + 48 * 48 * 2, '\0');
+    memcpy(&banner[0], "WIBN", 4);
+    for (size_t i = 0; i < name.length(); i++) {
+        banner[0x20 + i * 2 + 1] = name[i];
+    }
+    // first pixel opaque red in RGB5, second one in RGB4A3
+    banner[0x60A0]     = (char)0xFC;
+    banner[0x60A0 + 1] = 0x00;
+    banner[0x60A0 + 2] = 0x70;
+    banner[0x60A0 + 3] = 0x0F;
+    return banner;
+}
+
+static std::vector<std::string> folders(const std::string& path)
+{
+    std::vector<std::string> entries;
+    DIR* dir = opendir(path.c_str());
+    struct dirent* entry;
+    while (dir != NULL && (entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] != '.') {
+            entries.push_back(path + "/" + entry->d_name);
+        }
+    }
+    if (dir != NULL) {
+        closedir(dir);
+    }
+    return entries;
+}
+
+static int removeEntry(const char* path, const struct stat*, int, struct FTW*)
+{
+    return remove(path);
+}
+
+// both storages are scanned at once, as loadTitles does
+static void scan(const std::vector<std::string>& roots, std::vector<TitleMeta>& found)
+{
+    std::vector<std::vector<TitleMeta>> results(roots.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < roots.size(); i++) {
+        threads.emplace_back([&, i] {
+            for (auto& save : folders(roots[i])) {
+                TitleMeta meta;
+                if (Meta::get(save + "/meta/meta.xml", meta, countingParse)) {
+                    results[i].push_back(meta);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    found.clear();
+    for (auto& result : results) {
+        found.insert(found.end(), result.begin(), result.end());
+    }
+}
+
+int main(void)
+{
+    char base[] = "/tmp/checkpoint-meta-XXXXXX";
+    if (mkdtemp(base) == NULL || chdir(base) != 0) {
+        perror("mkdtemp");
+        return 1;
+    }
+    createDirectories("wiiu/Checkpoint");
+
+    const std::vector<std::string> roots = {"storage_mlc/usr/save/00050000", "storage_usb/usr/save/00050000"};
+    for (size_t r = 0; r < roots.size(); r++) {
+        for (uint64_t i = 0; i < TITLES_PER_STORAGE; i++) {
+            const uint64_t id = 0x0005000010100000ULL + r * 0x1000 + i;
+            char folder[9];
+            snprintf(folder, sizeof(folder), "%08llx", (unsigned long long)(id & 0xFFFFFFFF));
+            const std::string path = roots[r] + "/" + folder + "/meta";
+            createDirectories(path);
+            writeFile(path + "/meta.xml", metaXml(id, "Title &amp; " + std::to_string(id), "Publisher &lt;" + std::to_string(r) + "&gt;"));
+        }
+    }
+    // saves without a title id are not titles
+    createDirectories(roots[0] + "/broken/meta");
+    writeFile(roots[0] + "/broken/meta/meta.xml", "<menu><shortname_en>broken</shortname_en></menu>");
+
+    // a first scan parses everything and fills the cache
+    std::vector<TitleMeta> found;
+    Meta::loadCache();
+    scan(roots, found);
+    CHECK(found.size() == 2 * TITLES_PER_STORAGE);
+    CHECK(parses == 2 * TITLES_PER_STORAGE + 1);
+    bool fields = true;
+    for (auto& meta : found) {
+        fields = fields && meta.name == "Title & " + std::to_string(meta.id) && meta.publisher.compare(0, 10, "Publisher ") == 0 &&
+                 meta.publisher.back() == '>';
+    }
+    CHECK(fields);
+    Meta::saveCache();
+
+    // the next start only reads the cache
+    parses = 0;
+    Meta::loadCache();
+    scan(roots, found);
+    CHECK(found.size() == 2 * TITLES_PER_STORAGE);
+    CHECK(parses == 1);
+
+    // a modified meta.xml is parsed again
+    const std::string touched = folders(roots[1]).front() + "/meta/meta.xml";
+    struct utimbuf times      = {1000000000, 1000000000};
+    utime(touched.c_str(), &times);
+    parses = 0;
+    scan(roots, found);
+    CHECK(parses == 2);
+    Meta::saveCache();
+
+    // truncated or hand-edited caches are ignored entry by entry, not trusted
+    const std::vector<std::string> caches = {"{\"a\":{\"mtime\":1,\"id\":\"0\",\"na", "[1, 2]", "{\"a\": 1, \"b\": null}",
+        "{\"a\":{\"id\":\"00050000101000AA\",\"name\":\"x\",\"publisher\":\"y\"}}",
+        "{\"a\":{\"mtime\":\"1\",\"id\":\"00050000101000AA\",\"name\":\"x\",\"publisher\":\"y\"}}",
+        "{\"" + touched + "\":{\"mtime\":1000000000,\"id\":\"00050000101000AA\",\"name\":\"x\"}}", ""};
+    for (auto& cache : caches) {
+        writeFile(Meta::CACHEPATH, cache);
+        parses = 0;
+        Meta::loadCache();
+        scan(roots, found);
+        CHECK(found.size() == 2 * TITLES_PER_STORAGE);
+        CHECK(parses == 2 * TITLES_PER_STORAGE + 1);
+    }
+
+    // vWii titles are named by their banner
+    createDirectories("storage_mlc/usr/save/00010000/52414245/data");
+    const std::string banner = "storage_mlc/usr/save/00010000/52414245/data/banner.bin";
+    writeFile(banner, bannerBin("  Wii Title  "));
+    TitleMeta meta;
+    CHECK(Meta::get(banner, meta, Meta::parseBanner));
+    CHECK(meta.name == "Wii Title");
+    std::vector<uint32_t> pixels;
+    CHECK(Meta::bannerIcon(banner, pixels));
+    CHECK(pixels.size() == 48 * 48 && pixels[0] == 0xFF0000FF && pixels[1] == 0x0000FFFF);
+
+    nftw(base, removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+    printf("%s\n", failures == 0 ? "meta-test passed" : "meta-test FAILED");
+    return failures == 0 ? 0 : 1;
+}
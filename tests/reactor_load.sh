@@ -0,0 +1,95 @@
+#!/bin/bash
+#---------------------------------------------------------------------------------
+# load test of the network thread: FTP downloads and uploads run next to bursts of
+# HTTP requests against server-host, every transfer is checked for corruption and
+# an idle server must not burn CPU. needs curl, run after make server-host
+#---------------------------------------------------------------------------------
+cd "$(dirname "$0")"
+
+SIZE_MB=${SIZE_MB:-64}
+STREAMS=${STREAMS:-4}
+REQUESTS=${REQUESTS:-400}
+
+WORK=$(mktemp -d /tmp/checkpoint-load-XXXXXX)
+./server-host 300 > "$WORK/server.log" 2>&1 &
+SERVER=$!
+trap 'kill $SERVER 2> /dev/null; wait $SERVER 2> /dev/null; rm -rf "$WORK"' EXIT
+
+for i in $(seq 50); do
+    curl -s -o /dev/null http://127.0.0.1:8000/metrics && break
+    sleep 0.1
+done
+
+failures=0
+fail() {
+    echo "$1"
+    failures=$((failures + 1))
+}
+
+elapsed() {
+    local start=$(date +%s.%N)
+    "$@"
+    awk -v s="$start" -v e="$(date +%s.%N)" 'BEGIN { printf "%.2f", e - s }'
+}
+
+# every stream of a round transfers the same file, all of them have to arrive intact
+head -c $((SIZE_MB << 20)) /dev/urandom > "$WORK/source.bin"
+SUM=$(md5sum < "$WORK/source.bin")
+check_sums() {
+    for f in "$@"; do
+        [ "$(md5sum < "$f")" = "$SUM" ] || fail "$(basename "$f") differs from the source"
+    done
+}
+
+retr() {
+    for i in $(seq "$1"); do
+        curl -s -o "$WORK/retr$i" "ftp://127.0.0.1:50000$WORK/source.bin" &
+    done
+    wait
+}
+
+stor() {
+    for i in $(seq "$1"); do
+        curl -s -T "$WORK/source.bin" "ftp://127.0.0.1:50000$WORK/stor$i" &
+    done
+    wait
+}
+
+# concurrent HTTP requests, prints the slowest response in ms
+http_burst() {
+    seq "$REQUESTS" | xargs -P 8 -I{} curl -s -o /dev/null -w "%{time_total}\n" "http://127.0.0.1:8000/titles" |
+        sort -n | tail -1 | awk '{ printf "%.1f", $1 * 1000 }'
+}
+
+echo "RETR 1x${SIZE_MB}MB: $(elapsed retr 1) s"
+check_sums "$WORK/retr1"
+echo "RETR ${STREAMS}x${SIZE_MB}MB: $(elapsed retr "$STREAMS") s"
+check_sums "$WORK"/retr*
+echo "STOR 1x${SIZE_MB}MB: $(elapsed stor 1) s"
+check_sums "$WORK/stor1"
+echo "STOR ${STREAMS}x${SIZE_MB}MB: $(elapsed stor "$STREAMS") s"
+check_sums "$WORK"/stor*
+rm -f "$WORK"/retr* "$WORK"/stor*
+
+echo "HTTP ${REQUESTS} requests, idle server: slowest $(http_burst) ms"
+retr "$STREAMS" &
+TRANSFERS=$!
+echo "HTTP ${REQUESTS} requests, ${STREAMS} downloads running: slowest $(http_burst) ms"
+wait $TRANSFERS
+check_sums "$WORK"/retr*
+
+# the reactor sleeps in poll while nothing happens
+ticks() {
+    awk '{ print $14 + $15 }' /proc/$SERVER/stat
+}
+before=$(ticks)
+sleep 3
+idle=$(($(ticks) - before))
+echo "idle CPU over 3 s: ${idle} ticks"
+[ "$idle" -le 5 ] || fail "the idle server keeps waking up"
+
+if [ $failures -ne 0 ]; then
+    echo "reactor-load FAILED"
+    exit 1
+fi
+echo "reactor-load passed"
@@ -0,0 +1,123 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+// host benchmark of the title search index: types queries one key at a time
+// over a synthetic library, checks every result against a linear scan and
+// reports the time each keystroke takes
+//
+//   searchindex-bench [titles]
+
+#include "searchindex.hpp"
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#define FRAME_BUDGET_US 16667
+
+static const char* words[] = {"Super", "Mario", "Zelda", "Legend", "Kart", "Party", "Pokemon", "Fire", "Emblem", "Xenoblade", "Chronicles",
+    "Splatoon", "Metroid", "Dread", "Kirby", "Star", "Allies", "Donkey", "Kong", "Animal", "Crossing", "Smash", "Bros", "Ultimate", "Odyssey",
+    "Breath", "Wild", "Tears", "Kingdom", "Octo", "Expansion", "Deluxe", "Edition", "Remastered", "Racing", "Tennis", "Golf", "Arms"};
+
+static std::string lower(std::string str)
+{
+    for (auto& c : str) {
+        if (c >= 'A' && c <= 'Z') {
+            c += 'a' - 'A';
+        }
+    }
+    return str;
+}
+
+static uint64_t elapsed(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv)
+{
+    const size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000;
+    srand(1);
+
+    std::vector<std::string> names;
+    std::vector<uint64_t> ids;
+    for (size_t i = 0; i < count; i++) {
+        std::string name = words[rand() % (sizeof(words) / sizeof(*words))];
+        for (int n = rand() % 4; n >= 0; n--) {
+            name += std::string(" ") + words[rand() % (sizeof(words) / sizeof(*words))];
+        }
+        names.push_back(name + " " + std::to_string(i));
+        ids.push_back(0x0100000000000000ULL | ((uint64_t)rand() << 16) | (i & 0xFFFF));
+    }
+
+    SearchIndex index;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++) {
+        index.add(names[i], ids[i]);
+    }
+    printf("indexed %zu titles in %llu us\n", count, (unsigned long long)elapsed(start));
+
+    // whole words, word fragments, id prefixes and queries that match nothing
+    const std::vector<std::string> queries = {"zelda breath", "mario kart deluxe", "kong 12", "0100", "ultimate edi", "xyzzy", "ro"};
+    uint64_t total = 0, worst = 0, keystrokes = 0;
+    bool ok        = true;
+    for (auto& query : queries) {
+        for (size_t len = 1; len <= query.length(); len++) {
+            const std::string typed     = query.substr(0, len);
+            start                       = std::chrono::steady_clock::now();
+            std::vector<size_t> results = index.find(typed);
+            const uint64_t us           = elapsed(start);
+            total += us;
+            worst = std::max(worst, us);
+            keystrokes++;
+
+            std::vector<size_t> expected;
+            char hexId[17];
+            for (size_t i = 0; i < count; i++) {
+                snprintf(hexId, sizeof(hexId), "%016llx", (unsigned long long)ids[i]);
+                if ((lower(names[i]) + '\n' + hexId).find(lower(typed)) != std::string::npos) {
+                    expected.push_back(i);
+                }
+            }
+            if (results != expected) {
+                printf("mismatch for \"%s\": %zu results, expected %zu\n", typed.c_str(), results.size(), expected.size());
+                ok = false;
+            }
+        }
+        // the next query starts from an empty field again
+        index.find("");
+    }
+
+    printf("%llu keystrokes, %llu us average, %llu us worst\n", (unsigned long long)keystrokes, (unsigned long long)(total / keystrokes),
+        (unsigned long long)worst);
+    if (worst > FRAME_BUDGET_US) {
+        printf("a keystroke took longer than a frame\n");
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}
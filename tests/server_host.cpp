@@ -0,0 +1,157 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+// host build of the Switch network thread: the HTTP server of configuration.cpp
+// and the FTP server with the /checkpoint namespace, run by the reactor the way
+// networkLoop does, over a temporary sdmc: with backups of the synthetic library
+//
+//   server-host [seconds]
+//
+// serves HTTP on 8000 and FTP on 50000 until it is interrupted or the seconds
+// passed, see reactor_load.sh and http_endpoints.sh
+
+#include "configuration.hpp"
+#include "ftpnamespace.hpp"
+#include "libnx.hpp"
+#include "main.hpp"
+#include "reactor.hpp"
+#include <ftw.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <unistd.h>
+extern "C" {
+#include "ftp.h"
+}
+
+// titles that get backups, each one a backup more than the previous
+#define BACKUP_TITLES 8
+
+static char workDir[] = "/tmp/checkpoint-server-XXXXXX";
+
+// romfs:/ and sdmc:/ paths are relative, they resolve inside a temporary working directory
+static bool enterWorkDir(void)
+{
+    if (mkdtemp(workDir) == NULL || symlink(SERVER_ROMFS, (std::string(workDir) + "/romfs:").c_str()) != 0) {
+        return false;
+    }
+    return chdir(workDir) == 0;
+}
+
+static int removeEntry(const char* path, const struct stat*, int, struct FTW*)
+{
+    return remove(path);
+}
+
+static void writeFile(const std::string& path, size_t size, unsigned seed)
+{
+    FILE* f = fopen(path.c_str(), "wb");
+    if (f != NULL) {
+        for (size_t i = 0; i < size; i++) {
+            seed = seed * 1103515245u + 12345;
+            fputc(seed >> 16, f);
+        }
+        fclose(f);
+    }
+}
+
+static void createBackups(void)
+{
+    io::createDirectory("sdmc:");
+    io::createDirectory("sdmc:/switch");
+    io::createDirectory("sdmc:/switch/Checkpoint");
+    io::createDirectory("sdmc:/switch/Checkpoint/saves");
+    for (size_t i = 0; i < BACKUP_TITLES; i++) {
+        const std::string folder = StringUtils::format("sdmc:/switch/Checkpoint/saves/0x%016llX ", libraryTitle(i)) +
+                                   StringUtils::removeForbiddenCharacters(libraryName(i));
+        io::createDirectory(folder);
+        for (size_t backup = 0; backup <= i; backup++) {
+            const std::string path = folder + StringUtils::format("/2019010%zu-120000", backup + 1);
+            io::createDirectory(path);
+            io::createDirectory(path + "/data");
+            writeFile(path + "/save.bin", 0x10000 << backup, i * 31 + backup);
+            writeFile(path + "/data/progress.dat", 1000 + 333 * backup, i * 17 + backup);
+        }
+    }
+}
+
+static void stop(int)
+{
+    Reactor::getInstance().stop();
+}
+
+int main(int argc, char** argv)
+{
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+
+    if (!enterWorkDir()) {
+        printf("server-host FAILED, unable to create %s\n", workDir);
+        return 1;
+    }
+    createBackups();
+
+    Configuration::getInstance();
+    if (ftp_init() == 0) {
+        g_ftpAvailable = true;
+        FtpNamespace::mount();
+    }
+    printf("server-host serving %s\n", workDir);
+    fflush(stdout);
+
+    // the sources of networkLoop in main.cpp
+    Reactor& reactor = Reactor::getInstance();
+    reactor.add([](std::vector<struct pollfd>& fds) { return Configuration::getInstance().serverPollfds(fds); },
+        [](const struct pollfd*, size_t) { Configuration::getInstance().pollServer(); });
+    reactor.add(
+        [](std::vector<struct pollfd>& fds) {
+            if (g_ftpAvailable) {
+                const size_t offset = fds.size();
+                fds.resize(offset + ftp_pollfds(NULL, 0));
+                ftp_pollfds(fds.data() + offset, fds.size() - offset);
+            }
+            return -1;
+        },
+        [](const struct pollfd* fds, size_t count) { ftp_dispatch(fds, count); });
+
+    if (argc > 1) {
+        std::thread([seconds = atoi(argv[1])]() {
+            sleep(seconds);
+            Reactor::getInstance().stop();
+        }).detach();
+    }
+    reactor.run();
+
+    if (g_ftpAvailable) {
+        ftp_exit();
+        FtpNamespace::unmount();
+    }
+    nftw(workDir, removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+    printf("server-host stopped\n");
+    return 0;
+}
@@ -0,0 +1,53 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+// host stand-ins for what the Switch servers take from the UI: the loaded
+// titles are the synthetic library of libnx/ and the notification led is a no-op
+
+#include "libnx.hpp"
+#include "title.hpp"
+#include "util.hpp"
+
+SDL_Color FC_MakeColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+    return {r, g, b, a};
+}
+
+void blinkLed(u8) {}
+
+u32 titlesRevision(void)
+{
+    return 1;
+}
+
+std::unordered_map<std::string, std::string> getCompleteTitleList(void)
+{
+    std::unordered_map<std::string, std::string> map;
+    for (size_t i = 0; i < LIBRARY_TITLES; i++) {
+        map.insert({StringUtils::format("0x%016llX", libraryTitle(i)), libraryName(i)});
+    }
+    return map;
+}
@@ -0,0 +1,288 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+// host test of the UTF-8 decoder and the glyph width table, followed by a
+// benchmark against the map and FIFO cache the 3DS measured text with before
+//
+//   textmetrics-test
+
+#include "textmetrics.hpp"
+#include <chrono>
+#include <map>
+#include <math.h>
+#include <queue>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#define BENCH_ROUNDS 2000
+
+static int failures = 0;
+
+#define CHECK(cond)                                                                                                                            \
+    do {                                                                                                                                       \
+        if (!(cond)) {                                                                                                                         \
+            printf("%s:%d: %s failed\n", __FILE__, __LINE__, #cond);                                                                           \
+            failures++;                                                                                                                        \
+        }                                                                                                                                      \
+    } while (0)
+
+static size_t lookups = 0;
+
+// a stub font: every codepoint gets its own width so mixed up lookups show
+static float stubWidth(uint32_t codepoint)
+{
+    lookups++;
+    return 4.0f + codepoint % 13;
+}
+
+static std::vector<uint32_t> decodeAll(const std::string& str)
+{
+    std::vector<uint32_t> ret;
+    const char* p   = str.c_str();
+    const char* end = p + str.length();
+    while (p < end) {
+        ret.push_back(UTF8::decode(p, end));
+    }
+    return ret;
+}
+
+static std::string encode(uint32_t codepoint)
+{
+    std::string ret;
+    if (codepoint < 0x80) {
+        ret += (char)codepoint;
+    }
+    else if (codepoint < 0x800) {
+        ret += (char)(0xC0 | codepoint >> 6);
+        ret += (char)(0x80 | (codepoint & 0x3F));
+    }
+    else if (codepoint < 0x10000) {
+        ret += (char)(0xE0 | codepoint >> 12);
+        ret += (char)(0x80 | (codepoint >> 6 & 0x3F));
+        ret += (char)(0x80 | (codepoint & 0x3F));
+    }
+    else {
+        ret += (char)(0xF0 | codepoint >> 18);
+        ret += (char)(0x80 | (codepoint >> 12 & 0x3F));
+        ret += (char)(0x80 | (codepoint >> 6 & 0x3F));
+        ret += (char)(0x80 | (codepoint & 0x3F));
+    }
+    return ret;
+}
+
+static void testDecode(void)
+{
+    typedef std::vector<uint32_t> V;
+    CHECK(decodeAll("Save 1") == V({'S', 'a', 'v', 'e', ' ', '1'}));
+    CHECK(decodeAll("\xC3\xA9\xE2\x82\xAC") == V({0xE9, 0x20AC}));
+    // astral plane
+    CHECK(decodeAll("\xF0\x9F\x98\x80!") == V({0x1F600, '!'}));
+    CHECK(decodeAll("\xF4\x8F\xBF\xBF") == V({0x10FFFF}));
+
+    // malformed input yields U+FFFD one byte at a time, and resyncs on the next character
+    CHECK(decodeAll("\x80" "a") == V({0xFFFD, 'a'}));
+    CHECK(decodeAll("\xFF\xF8" "a") == V({0xFFFD, 0xFFFD, 'a'}));
+    CHECK(decodeAll("\xE2\x41\x42") == V({0xFFFD, 'A', 'B'}));
+    // truncated at the end of the string
+    CHECK(decodeAll("a\xE2\x82") == V({'a', 0xFFFD, 0xFFFD}));
+    CHECK(decodeAll("\xF0\x9F\x98") == V({0xFFFD, 0xFFFD, 0xFFFD}));
+    // overlong forms
+    CHECK(decodeAll("\xC0\x80") == V({0xFFFD, 0xFFFD}));
+    CHECK(decodeAll("\xC1\xBF") == V({0xFFFD, 0xFFFD}));
+    CHECK(decodeAll("\xE0\x80\xAF") == V({0xFFFD, 0xFFFD, 0xFFFD}));
+    CHECK(decodeAll("\xF0\x8F\xBF\xBF") == V({0xFFFD, 0xFFFD, 0xFFFD, 0xFFFD}));
+    // surrogates and values past U+10FFFF
+    CHECK(decodeAll("\xED\xA0\x80") == V({0xFFFD, 0xFFFD, 0xFFFD}));
+    CHECK(decodeAll("\xF4\x90\x80\x80") == V({0xFFFD, 0xFFFD, 0xFFFD, 0xFFFD}));
+    CHECK(decodeAll("\xF7\xBF\xBF\xBF") == V({0xFFFD, 0xFFFD, 0xFFFD, 0xFFFD}));
+
+    // valid text round trips
+    srand(1);
+    bool roundTrip = true;
+    for (int i = 0; i < 10000; i++) {
+        std::string str;
+        V expected;
+        for (int n = rand() % 16; n > 0; n--) {
+            uint32_t codepoint = rand() % 0x110000;
+            if (codepoint >= 0xD800 && codepoint <= 0xDFFF) {
+                continue;
+            }
+            str += encode(codepoint);
+            expected.push_back(codepoint);
+        }
+        roundTrip = roundTrip && decodeAll(str) == expected;
+    }
+    CHECK(roundTrip);
+
+    // random bytes always move forward, never past the end, and only yield valid codepoints
+    bool bounded = true;
+    for (int i = 0; i < 10000; i++) {
+        std::string str;
+        for (int n = rand() % 16; n > 0; n--) {
+            str += (char)(rand() & 0xFF);
+        }
+        const char* p   = str.c_str();
+        const char* end = p + str.length();
+        while (p < end) {
+            const char* before       = p;
+            const uint32_t codepoint = UTF8::decode(p, end);
+            bounded = bounded && p > before && p <= end && p - before <= 4 && codepoint <= 0x10FFFF &&
+                      !(codepoint >= 0xD800 && codepoint <= 0xDFFF);
+        }
+    }
+    CHECK(bounded);
+}
+
+static void testMetrics(void)
+{
+    TextMetrics metrics(stubWidth);
+
+    lookups = 0;
+    CHECK(metrics.charWidth('A') == stubWidth('A'));
+    CHECK(metrics.charWidth('A') == stubWidth('A'));
+    // pages are filled one codepoint at a time
+    CHECK(lookups == 3);
+    CHECK(metrics.charWidth('B') == stubWidth('B'));
+    CHECK(metrics.charWidth(0xFFFF) == stubWidth(0xFFFF));
+
+    // a line is the sum of its characters, the text as wide as its widest line
+    const float abc = stubWidth('a') + stubWidth('b') + stubWidth('c');
+    CHECK(metrics.width("abc", 1.0f) == abc);
+    CHECK(metrics.width("ab\nabc\na", 0.5f) == abc * 0.5f);
+    CHECK(metrics.width("", 1.0f) == 0.0f);
+    CHECK(metrics.width("\xC3\xA9\xF0\x9F\x98\x80", 1.0f) == stubWidth(0xE9) + stubWidth(0x1F600));
+    CHECK(metrics.width("\xFF", 1.0f) == stubWidth(0xFFFD));
+
+    // codepoints outside the BMP aren't tabled, they always reach the provider
+    lookups = 0;
+    metrics.charWidth(0x1F600);
+    metrics.charWidth(0x1F600);
+    CHECK(lookups == 2);
+
+    // clearing the table asks the provider again
+    metrics.clear();
+    lookups = 0;
+    metrics.charWidth('A');
+    CHECK(lookups == 1);
+}
+
+// what StringUtils::textWidth did before the width table, with the provider
+// standing in for the system font
+static std::map<uint16_t, float> legacyCache;
+static std::queue<uint16_t> legacyOrder;
+
+static float legacyWidth(const std::string& text, float scaleX)
+{
+    float ret        = 0.0f;
+    float largestRet = 0.0f;
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i] == '\n') {
+            largestRet = std::max(largestRet, ret);
+            ret        = 0.0f;
+            continue;
+        }
+        uint16_t codepoint = 0xFFFF;
+        if (text[i] & 0x80 && text[i] & 0x40 && text[i] & 0x20 && !(text[i] & 0x10) && i + 2 < text.size()) {
+            codepoint = text[i] & 0x0F;
+            codepoint = codepoint << 6 | (text[i + 1] & 0x3F);
+            codepoint = codepoint << 6 | (text[i + 2] & 0x3F);
+            i += 2;
+        }
+        else if (text[i] & 0x80 && text[i] & 0x40 && !(text[i] & 0x20) && i + 1 < text.size()) {
+            codepoint = text[i] & 0x1F;
+            codepoint = codepoint << 6 | (text[i + 1] & 0x3F);
+            i += 1;
+        }
+        else if (!(text[i] & 0x80)) {
+            codepoint = text[i];
+        }
+        auto width = legacyCache.find(codepoint);
+        if (width == legacyCache.end()) {
+            width = legacyCache.insert({codepoint, stubWidth(codepoint)}).first;
+            legacyOrder.push(codepoint);
+            if (legacyCache.size() > 1000) {
+                legacyCache.erase(legacyOrder.front());
+                legacyOrder.pop();
+                width = legacyCache.find(codepoint);
+            }
+        }
+        ret += width->second * scaleX;
+    }
+    return std::max(largestRet, ret);
+}
+
+static void benchmark(void)
+{
+    // title names and messages in latin, accented and japanese text
+    std::vector<std::string> texts;
+    srand(2);
+    for (int i = 0; i < 200; i++) {
+        std::string text;
+        for (int n = 0; n < 40; n++) {
+            const int kind = rand() % 4;
+            text += kind == 0 ? encode(0x3040 + rand() % 0x60) : kind == 1 ? encode(0xC0 + rand() % 0x40) : encode('a' + rand() % 26);
+            if (n % 16 == 15) {
+                text += '\n';
+            }
+        }
+        texts.push_back(text);
+    }
+
+    TextMetrics metrics(stubWidth);
+    float legacyTotal = 0.0f, tableTotal = 0.0f;
+    auto start        = std::chrono::steady_clock::now();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        for (auto& text : texts) {
+            legacyTotal += legacyWidth(text, 0.5f);
+        }
+    }
+    const auto legacy = std::chrono::steady_clock::now() - start;
+    start             = std::chrono::steady_clock::now();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        for (auto& text : texts) {
+            tableTotal += metrics.width(text, 0.5f);
+        }
+    }
+    const auto table = std::chrono::steady_clock::now() - start;
+
+    // both measure the same widths
+    CHECK(fabsf(legacyTotal - tableTotal) <= legacyTotal * 1e-4f);
+    const size_t strings = BENCH_ROUNDS * texts.size();
+    printf("map and FIFO cache: %.1f ns per string\n", std::chrono::duration<double, std::nano>(legacy).count() / strings);
+    printf("width table: %.1f ns per string\n", std::chrono::duration<double, std::nano>(table).count() / strings);
+}
+
+int main(void)
+{
+    testDecode();
+    testMetrics();
+    benchmark();
+
+    printf("%s\n", failures == 0 ? "textmetrics-test passed" : "textmetrics-test FAILED");
+    return failures == 0 ? 0 : 1;
+}
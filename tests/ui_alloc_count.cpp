@@ -0,0 +1,167 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+// heap allocations per frame of the Switch UI on a host: the real screens, overlays
+// and SDL helpers driven over a synthetic library, see libnx/. this has only been
+// built against stand-in SDL libraries that draw nothing, so it is no render
+// benchmark and the frame times of the built-in benchmark are left out
+//
+//   ui-alloc-count
+//
+// the first frame holds MINUS and presses UP like a user starting the built-in
+// benchmark, which then replays its steps
+
+#include "MainScreen.hpp"
+#include "benchmark.hpp"
+#include "framescheduler.hpp"
+#include "libnx.hpp"
+#include "main.hpp"
+#include "profiler.hpp"
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// upper bound of the frames drawn, the benchmark normally ends well before
+#define MAX_FRAMES 20000
+// titles get up to one backup less than this
+#define BACKUPS_PER_TITLE 12
+
+static char workDir[] = "/tmp/checkpoint-render-XXXXXX";
+
+// romfs:/ and sdmc:/ paths are relative, they resolve inside a temporary working directory
+static bool enterWorkDir(void)
+{
+    if (mkdtemp(workDir) == NULL || symlink(UI_ROMFS, (std::string(workDir) + "/romfs:").c_str()) != 0) {
+        return false;
+    }
+    return chdir(workDir) == 0;
+}
+
+// drops the frame times from the lines of Benchmark::report, keeping the step, its frames and the counts
+static std::string allocationsOnly(const std::string& report)
+{
+    std::string ret = report;
+    for (size_t line = 0; line < ret.size(); line = ret.find('\n', line) + 1) {
+        const size_t times = ret.find(" frames, ", line);
+        const size_t worst = ret.find(" ms worst", line);
+        if (times == std::string::npos || worst == std::string::npos || worst > ret.find('\n', line)) {
+            break;
+        }
+        ret.erase(times + 7, worst + 9 - (times + 7));
+    }
+    return ret;
+}
+
+static int removeEntry(const char* path, const struct stat*, int, struct FTW*)
+{
+    return remove(path);
+}
+
+int main(void)
+{
+    setenv("SDL_VIDEODRIVER", "dummy", 0);
+    setenv("SDL_RENDER_DRIVER", "software", 0);
+
+    if (!enterWorkDir() || !SDLH_Init()) {
+        printf("ui-alloc-count FAILED, unable to initialize\n");
+        return 1;
+    }
+    io::createDirectory("sdmc:");
+    io::createDirectory("sdmc:/switch");
+    io::createDirectory("sdmc:/switch/Checkpoint");
+    io::createDirectory("sdmc:/switch/Checkpoint/saves");
+    g_screen = std::make_unique<MainScreen>();
+
+    loadTitles();
+    g_currentUId = Account::ids().at(0);
+
+    // a few backups per title of the first user, the backup list is read when a title gets focused
+    for (size_t i = 0, count = getTitleCount(g_currentUId); i < count; i++) {
+        Title title;
+        getTitle(title, g_currentUId, i);
+        for (size_t backup = 0; backup < i % BACKUPS_PER_TITLE; backup++) {
+            io::createDirectory(title.path() + StringUtils::format("/20190%zu01-1200%02zu", 1 + backup % 9, backup));
+        }
+    }
+
+    std::string characters;
+    for (const auto& title : getCompleteTitleList()) {
+        characters += title.second;
+    }
+    SDLH_PrewarmGlyphs(characters);
+    printf("%zu titles loaded, allocations per frame over stand-in SDL:\n", getTitleCount(g_currentUId));
+
+    FrameScheduler& scheduler = FrameScheduler::getInstance();
+    Profiler& profiler        = Profiler::getInstance();
+    Benchmark& benchmark      = Benchmark::getInstance();
+    bool started              = false;
+    size_t frames             = 0;
+    for (; frames < MAX_FRAMES && !(started && !benchmark.running()); frames++) {
+        touchPosition touch;
+        hidSetKeys(frames == 0 ? KEY_DUP : 0, frames == 0 ? KEY_MINUS : 0);
+        hidScanInput();
+        hidTouchRead(&touch, 0);
+
+        const bool benchmarking = benchmark.running();
+        // every frame is drawn, like a pad that never goes idle
+        scheduler.invalidate();
+        if (benchmarking) {
+            benchmark.beginFrame();
+        }
+
+        if (scheduler.beginFrame(SDL_GetTicks())) {
+            g_screen->doDraw();
+            if (!benchmarking) {
+                g_screen->doUpdate(&touch);
+            }
+            else {
+                benchmark.endFrame();
+            }
+            SDLH_Render();
+            profiler.endFrame();
+            scheduler.endFrame(SDL_GetTicks());
+        }
+        else {
+            g_screen->doUpdate(&touch);
+            svcSleepThread(scheduler.sleepTime() * 1000000ULL);
+        }
+        started = started || benchmark.running();
+    }
+
+    const std::string report = benchmark.report();
+    printf("%s", allocationsOnly(report).c_str());
+    SDLH_Exit();
+    nftw(workDir, removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+
+    if (!started || benchmark.running() || report.empty()) {
+        printf("ui-alloc-count FAILED after %zu frames\n", frames);
+        return 1;
+    }
+    printf("ui-alloc-count passed\n");
+    return 0;
+}
@@ -0,0 +1,169 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+// host stand-ins for the parts of the Switch build ui-alloc-count does not draw:
+// accounts, configuration, cheats, the keyboard, backups and the PKSM bridge
+
+#include "cheatmanager.hpp"
+#include "configuration.hpp"
+#include "io.hpp"
+#include "libnx.hpp"
+#include "pksmbridge.hpp"
+#include "util.hpp"
+#include <string.h>
+extern "C" {
+#include "ftp.h"
+}
+
+Result Account::init(void)
+{
+    return 0;
+}
+
+void Account::exit(void) {}
+
+std::vector<AccountUid> Account::ids(void)
+{
+    std::vector<AccountUid> ids;
+    for (size_t i = 0; i < LIBRARY_USERS; i++) {
+        ids.push_back(libraryUser(i));
+    }
+    return ids;
+}
+
+SDL_Texture* Account::icon(AccountUid)
+{
+    return NULL;
+}
+
+AccountUid Account::selectAccount(void)
+{
+    return g_currentUId;
+}
+
+std::string Account::username(AccountUid id)
+{
+    return StringUtils::format("User %llu", id.uid[0] - libraryUser(0).uid[0] + 1);
+}
+
+std::string Account::shortName(AccountUid id)
+{
+    return username(id);
+}
+
+Configuration::Configuration(void)
+{
+    PKSMBridgeEnabled = false;
+    FTPEnabled        = false;
+}
+
+Configuration::~Configuration(void) {}
+
+bool Configuration::filter(u64)
+{
+    return false;
+}
+
+bool Configuration::favorite(u64 id)
+{
+    return (id >> 13) % 11 == 0;
+}
+
+bool Configuration::isPKSMBridgeEnabled(void)
+{
+    return PKSMBridgeEnabled;
+}
+
+bool Configuration::isFTPEnabled(void)
+{
+    return FTPEnabled;
+}
+
+std::vector<std::string> Configuration::additionalSaveFolders(u64)
+{
+    return {};
+}
+
+CheatManager::CheatManager(void)
+{
+    mCheats = nullptr;
+}
+
+bool CheatManager::areCheatsAvailable(const std::string&)
+{
+    return false;
+}
+
+void CheatManager::save(const std::string&, const std::vector<std::string>&) {}
+
+KeyboardManager::KeyboardManager(void)
+{
+    res                     = 0;
+    systemKeyboardAvailable = false;
+}
+
+std::pair<bool, std::string> KeyboardManager::keyboard(const std::string& suggestion)
+{
+    return std::make_pair(false, suggestion);
+}
+
+std::tuple<bool, Result, std::string> io::backup(size_t, AccountUid, size_t)
+{
+    return std::make_tuple(false, 1, "Backups are not available on the host.");
+}
+
+std::tuple<bool, Result, std::string> io::restore(size_t, AccountUid, size_t, const std::string&)
+{
+    return std::make_tuple(false, 1, "Restores are not available on the host.");
+}
+
+bool isPKSMBridgeTitle(u64)
+{
+    return false;
+}
+
+std::tuple<bool, Result, std::string> sendToPKSMBrigde(size_t, AccountUid, size_t)
+{
+    return std::make_tuple(false, 1, "The PKSM bridge is not available on the host.");
+}
+
+std::tuple<bool, Result, std::string> recvFromPKSMBridge(size_t, AccountUid, size_t)
+{
+    return std::make_tuple(false, 1, "The PKSM bridge is not available on the host.");
+}
+
+// search keys are not part of the benchmark, names are indexed as they are
+std::string StringUtils::removeAccents(std::string str)
+{
+    return str;
+}
+
+void blinkLed(u8) {}
+
+void ftp_stats(ftp_stats_t* stats)
+{
+    memset(stats, 0, sizeof(ftp_stats_t));
+}
@@ -34,6 +34,7 @@
 #include <utility>
 #include <locale>
 #include <codecvt>
+#include <functional>
 
 class KeyboardManager {
 public:
@@ -48,7 +49,7 @@ public:
 
     bool init();
     void shutdown();
-    std::pair<bool, std::string> keyboard(const std::string& suggestion);
+    std::pair<bool, std::string> keyboard(const std::string& suggestion, std::function<void(const std::string&)> onChange = nullptr);
     bool isInitialized() { return initialized; }
 
     static const size_t CUSTOM_PATH_LEN = 49;
@@ -57,7 +58,7 @@ private:
     KeyboardManager(void);
     virtual ~KeyboardManager(void){};
 
-    void update();
+    void update(bool drawScreen = false);
     void hide();
 
     bool hidden() { return nn::swkbd::GetStateInputForm() == nn::swkbd::State::Hidden; }
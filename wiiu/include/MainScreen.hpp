@@ -31,6 +31,7 @@
 #include "InfoOverlay.hpp"
 #include "Screen.hpp"
 #include "YesNoOverlay.hpp"
+#include "benchmark.hpp"
 #include "AccountSelectOverlay.hpp"
 #include "clickable.hpp"
 #include "hid.hpp"
@@ -62,6 +63,8 @@ protected:
     void index(entryType_t type, size_t i);
     void resetIndex(entryType_t type);
     void updateButtons(void);
+    // replays scrolling, overlays and multiselection, toggled with - and up
+    void runBenchmark(void);
     std::string sortMode(void) const;
 
 private:
@@ -3,12 +3,16 @@
 
 #include "SDL_FontCache.h"
 #include "colors.hpp"
+#include "framescheduler.hpp"
 #include "logger.hpp"
 #include "main.hpp"
+#include "profiler.hpp"
+#include "textlayout.hpp"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <coreinit/memory.h>
 
@@ -24,11 +28,21 @@ void SDLH_DrawImage(SDL_Texture* texture, int x, int y);
 void SDLH_DrawImageScale(SDL_Texture* texture, int x, int y, int w, int h);
 void SDLH_DrawIcon(std::string icon, int x, int y);
 void SDLH_GetTextDimensions(int size, const char* text, uint32_t* w, uint32_t* h);
+// breaks text into lines no wider than maxWidth
+std::string SDLH_WrapText(int size, const std::string& text, int maxWidth);
 void SDLH_DrawTextBox(int size, int x, int y, SDL_Color color, int max, const char* text);
 void SDLH_Render(void);
+// title icons, downscaled when added and drawn in batches from shared atlas pages
+bool SDLH_AddAtlasIcon(uint64_t id, uint8_t* buff, size_t size, bool tga);
+bool SDLH_AddAtlasIcon(uint64_t id, const uint32_t* pixels, int w, int h);
+bool SDLH_HasAtlasIcon(uint64_t id);
+void SDLH_QueueAtlasIcon(uint64_t id, int x, int y, int size);
+void SDLH_FlushAtlasIcons(void);
 
 void drawOutline(uint32_t x, uint32_t y, uint16_t w, uint16_t h, uint8_t size, SDL_Color color);
 void drawPulsingOutline(uint32_t x, uint32_t y, uint16_t w, uint16_t h, uint8_t size, SDL_Color color);
+// stage timings of the last frames, toggled with - and down
+void drawProfiler(void);
 std::string trimToFit(const std::string& text, uint32_t maxsize, size_t textsize);
 
 #endif
\ No newline at end of file
@@ -30,6 +30,7 @@
 #include "io.hpp"
 #include "util.hpp"
 #include "json.hpp"
+#include <mutex>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -65,6 +66,8 @@ private:
     void operator=(Configuration const&) = delete;
 
     nlohmann::json mJson;
+    // guards the sets parse() rebuilds
+    std::mutex mMutex;
     std::unordered_set<uint64_t> mFilterIds, mFavoriteIds;
     std::unordered_map<uint64_t, std::vector<std::string>> mAdditionalSaveFolders;
 };
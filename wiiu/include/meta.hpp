@@ -0,0 +1,57 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef META_HPP
+#define META_HPP
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+struct TitleMeta {
+    uint64_t id = 0;
+    std::string name;
+    std::string publisher;
+};
+
+namespace Meta {
+    // reads meta.xml only up to the last element we need
+    bool parse(const std::string& path, TitleMeta& meta);
+    // reads the name from the header of a vWii banner.bin, the id is not stored there
+    bool parseBanner(const std::string& path, TitleMeta& meta);
+    // decodes the first 48x48 icon frame of a vWii banner.bin to RGBA8888
+    bool bannerIcon(const std::string& path, std::vector<uint32_t>& pixels);
+    // parse through the persistent cache, safe to call from several threads
+    bool get(const std::string& path, TitleMeta& meta, bool (*parser)(const std::string&, TitleMeta&) = parse);
+    void loadCache(void);
+    void saveCache(void);
+
+    inline const std::string CACHEPATH = "wiiu/Checkpoint/metacache.json";
+
+    inline constexpr int BANNER_ICON_SIZE = 48;
+}
+
+#endif
@@ -31,14 +31,17 @@
 #include "account.hpp"
 #include "configuration.hpp"
 #include "io.hpp"
+#include "meta.hpp"
+#include "searchindex.hpp"
 #include <algorithm>
+#include <numeric>
 #include <stdlib.h>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 #include <malloc.h>
-#include <tinyxml2.h>
+#include <thread>
 
 #include <coreinit/mcp.h>
 #include <nn/act.h>
@@ -49,13 +52,13 @@ typedef uint32_t AccountUid;
 class Title {
 public:
     void init(uint64_t titleid, AccountUid userID, const std::string& name, const std::string& author);
-    void initvWii(const std::string&name, const std::string& author);
+    void initvWii(uint64_t titleid, AccountUid userID, const std::string& name);
     ~Title(void){};
 
     bool isvWii(void);
     std::string author(void);
     std::pair<std::string, std::string> displayName(void);
-    SDL_Texture* icon(void);
+    bool hasIcon(void);
     uint64_t id(void);
     std::string name(void);
     std::string path(void);
@@ -68,6 +71,8 @@ public:
     void lastPlayedTimestamp(uint32_t lastPlayedTimestamp);
     std::string fullPath(size_t index);
     void refreshDirectories(void);
+    void invalidateDirectories(void);
+    bool directoriesOutdated(bool checkTimestamp);
     uint64_t saveId();
     void saveId(uint64_t id);
     std::vector<std::string> saves(void);
@@ -76,6 +81,8 @@ public:
     std::string userName(void);
 
 private:
+    time_t directoriesTimestamp(void);
+
     bool misvWii;
     uint64_t mId;
     bool mCommonSave;
@@ -88,6 +95,8 @@ private:
     std::string mSourcePath;
     std::vector<std::string> mSaves;
     std::vector<std::string> mFullSavePaths;
+    bool mDirectoriesLoaded;
+    time_t mDirectoriesTimestamp;
     std::pair<std::string, std::string> mDisplayName;
     uint32_t mPlayTimeMinutes;
     uint32_t mLastPlayedTimestamp;
@@ -98,10 +107,12 @@ size_t getTitleCount(AccountUid uid);
 void loadTitles();
 void sortTitles(void);
 void rotateSortMode(void);
+void searchTitles(const std::string& query);
+std::string titleSearchQuery(void);
 void refreshDirectories(uint64_t id);
 bool favorite(AccountUid uid, int i);
-void freeIcons(void);
-SDL_Texture* smallIcon(AccountUid uid, size_t i);
+// queues the grid icon of a title, returns false if it has none
+bool queueSmallIcon(AccountUid uid, size_t i, int x, int y);
 std::unordered_map<std::string, std::string> getCompleteTitleList(void);
 
 #endif
\ No newline at end of file
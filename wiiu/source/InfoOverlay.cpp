@@ -28,7 +28,7 @@
 
 InfoOverlay::InfoOverlay(Screen& screen, const std::string& mtext) : Overlay(screen)
 {
-    text = mtext;
+    text = SDLH_WrapText(28, mtext, 600);
     SDLH_GetTextDimensions(28, text.c_str(), &textw, &texth);
     button = std::make_unique<Clickable>(322, 462, 636, 56, theme().c3, theme().c6, "OK", true);
     button->selected(true);
@@ -67,7 +67,7 @@ void KeyboardManager::shutdown()
     initialized = false;
 }
 
-std::pair<bool, std::string> KeyboardManager::keyboard(const std::string& suggestion)
+std::pair<bool, std::string> KeyboardManager::keyboard(const std::string& suggestion, std::function<void(const std::string&)> onChange)
 {
     if (nn::swkbd::AppearInputForm(appearArg)) {
         // convert the suggestion to a char16_t
@@ -77,9 +77,20 @@ std::pair<bool, std::string> KeyboardManager::keyboard(const std::string& sugges
         }
 
         nn::swkbd::SetInputFormString(wsuggestion);
+        std::u16string lastInput(wsuggestion);
 
         for (;;) {
-            update();
+            // keep the screen behind the keyboard live when the caller reacts to each keystroke
+            update(onChange != nullptr);
+
+            if (onChange != nullptr) {
+                const char16_t* inputString = nn::swkbd::GetInputFormString();
+                std::u16string input(inputString != nullptr ? inputString : u"");
+                if (input != lastInput) {
+                    lastInput = input;
+                    onChange(std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t>().to_bytes(input));
+                }
+            }
 
             if (nn::swkbd::IsDecideOkButton(nullptr)) {
                 std::u16string output(nn::swkbd::GetInputFormString());
@@ -97,7 +108,7 @@ std::pair<bool, std::string> KeyboardManager::keyboard(const std::string& sugges
     return std::make_pair(false, suggestion);
 }
 
-void KeyboardManager::update()
+void KeyboardManager::update(bool drawScreen)
 {
     // Update controller
     Input::update();
@@ -119,7 +130,12 @@ void KeyboardManager::update()
     }
 
     // draw keyboard
-    SDLH_ClearScreen(theme().c1);
+    if (drawScreen && g_screen != nullptr) {
+        g_screen->doDraw();
+    }
+    else {
+        SDLH_ClearScreen(theme().c1);
+    }
     nn::swkbd::DrawDRC();
     nn::swkbd::DrawTV();
     SDLH_Render();
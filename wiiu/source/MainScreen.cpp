@@ -71,17 +71,17 @@ void MainScreen::draw() const
     SDLH_GetTextDimensions(13, username.c_str(), &username_w, &username_h);
     SDLH_DrawTextBox(13, 1280 - SIDEBAR_w + (SIDEBAR_w - username_w) / 2, 720 - 28 + (28 - username_h) / 2, theme().c6, SIDEBAR_w, username.c_str());
 
-    // title icons
+    // title icons, drawn in a single batch before their badges
     for (size_t k = hid.page() * entries; k < hid.page() * entries + max; k++) {
-        int selectorx = selectorX(k);
-        int selectory = selectorY(k);
-        if (smallIcon(g_currentUId, k) != NULL) {
-            SDLH_DrawImageScale(smallIcon(g_currentUId, k), selectorx, selectory, 128, 128);
-        }
-        else {
-            SDLH_DrawRect(selectorx, selectory, 128, 128, theme().c0);
+        if (!queueSmallIcon(g_currentUId, k, selectorX(k), selectorY(k))) {
+            SDLH_DrawRect(selectorX(k), selectorY(k), 128, 128, theme().c0);
         }
+    }
+    SDLH_FlushAtlasIcons();
 
+    for (size_t k = hid.page() * entries; k < hid.page() * entries + max; k++) {
+        int selectorx = selectorX(k);
+        int selectory = selectorY(k);
         if (!selEnt.empty() && std::find(selEnt.begin(), selEnt.end(), k) != selEnt.end()) {
             SDLH_DrawIcon("checkbox", selectorx + 86, selectory + 86);
         }
@@ -111,9 +111,10 @@ void MainScreen::draw() const
             backupList->push_back(theme().c2, theme().c6, dirs.at(i), i == backupList->index());
         }
 
-        if (title.icon() != NULL) {
+        if (title.hasIcon()) {
             drawOutline(1018, 6, 256, 256, 4, theme().c3);
-            SDLH_DrawImageScale(title.icon(), 1018, 6, 256, 256);
+            SDLH_QueueAtlasIcon(title.id(), 1018, 6, 256);
+            SDLH_FlushAtlasIcons();
         }
 
         // draw infos
@@ -184,6 +185,7 @@ void MainScreen::draw() const
         SDLH_DrawText(27, 1205, 646, theme().c6, "\ue085\ue086");
         SDLH_DrawText(24, 58, 69, theme().c6, "\ue058 Tap to select title");
         SDLH_DrawText(24, 58, 109, theme().c6, ("\ue026 Sort: " + sortMode()).c_str());
+        SDLH_DrawText(24, 58, 149, theme().c6, ("Left stick to search: " + titleSearchQuery()).c_str());
         SDLH_DrawText(24, 100, 270, theme().c6, "\ue006 \ue080 to scroll between titles");
         SDLH_DrawText(24, 100, 300, theme().c6, "\ue004 \ue005 to scroll between pages");
         SDLH_DrawText(24, 100, 330, theme().c6, "\ue000 to enter the selected title");
@@ -247,6 +249,11 @@ void MainScreen::handleEvents(touchPosition* touch)
     uint32_t kdown = Input::getDown();
     uint32_t kheld = Input::getHeld();
 
+    if ((kheld & Input::BUTTON_MINUS) && (kdown & Input::BUTTON_UP)) {
+        runBenchmark();
+        return;
+    }
+
     if (kdown & Input::BUTTON_ZL || kdown & Input::BUTTON_ZR)
     {
         currentOverlay = std::make_shared<AccountSelectOverlay>
@@ -368,6 +375,19 @@ void MainScreen::handleEvents(touchPosition* touch)
         }
     }
 
+    // Handle pressing the left stick: filter the titles by name or title id while typing
+    if (kdown & Input::BUTTON_STICK_L && !g_backupScrollEnabled) {
+        std::string oldQuery = titleSearchQuery();
+        std::pair<bool, std::string> query =
+            KeyboardManager::get().keyboard(oldQuery, [this](const std::string& text) {
+                searchTitles(text);
+                this->index(TITLES, 0);
+            });
+        searchTitles(query.first ? query.second : oldQuery);
+        MS::clearSelectedEntries();
+        this->index(TITLES, 0);
+    }
+
     // Handle pressing Y
     // Backup list active:   Deactivate backup list, select title, and
     //                       enable backup button
@@ -532,3 +552,37 @@ std::string MainScreen::sortMode() const
     }
     return "";
 }
+
+void MainScreen::runBenchmark(void)
+{
+    const size_t entries = hid.maxVisibleEntries();
+    const size_t count   = getTitleCount(g_currentUId);
+    std::vector<Benchmark::Step> steps;
+
+    steps.push_back({"idle", 60, [this]() { this->index(TITLES, 0); }});
+    for (size_t i = 0; i < std::min(count, entries); i++) {
+        steps.push_back({"move", 2, [this, i]() { this->index(TITLES, i); }});
+    }
+    for (size_t i = 0; i < count; i += entries) {
+        steps.push_back({"page", 10, [this, i]() { this->index(TITLES, i); }});
+    }
+    steps.push_back({"info overlay", 60, [this]() {
+                         this->index(TITLES, 0);
+                         currentOverlay = std::make_shared<InfoOverlay>(*this,
+                             "This is a message long enough to be wrapped over a few lines, the way backup and restore results usually are.");
+                     }});
+    steps.push_back({"yes/no overlay", 60, [this]() { currentOverlay = std::make_shared<YesNoOverlay>(*this, "Restore selected save?", []() {}, []() {}); }});
+    steps.push_back({"multiselect", 60, [this, entries, count]() {
+                         removeOverlay();
+                         for (size_t i = 0; i < std::min(count, entries); i++) {
+                             MS::addSelectedEntry(i);
+                         }
+                     }});
+    steps.push_back({"report", 1, [this]() {
+                         MS::clearSelectedEntries();
+                         const std::string report = Benchmark::getInstance().report();
+                         Logger::getInstance().log(Logger::INFO, "Benchmark results:\n%s", report.c_str());
+                         currentOverlay = std::make_shared<InfoOverlay>(*this, report);
+                     }});
+    Benchmark::getInstance().start(steps);
+}
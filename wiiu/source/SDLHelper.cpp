@@ -9,6 +9,49 @@ static void* fontData = nullptr;
 static uint32_t fontSize = 0;
 
 static std::unordered_map<int, FC_Font*> s_fonts;
+static std::unordered_map<int, TextMetrics> s_metrics;
+
+#define TEXT_DIMENSIONS_CACHE_SIZE 1024
+
+struct TextRun {
+    SDL_Texture* texture;
+    int w;
+    int h;
+    uint64_t frame;
+};
+
+// labels are rendered once to a texture and blitted on later frames, runs that
+// weren't drawn during a frame are released once it gets presented
+static bool s_renderTargets = false;
+static uint64_t s_frame     = 0;
+static std::unordered_map<std::string, TextRun> s_textRuns;
+static std::unordered_map<std::string, std::pair<uint32_t, uint32_t>> s_textDimensions;
+
+#define ATLAS_ICON_SIZE 128
+#define ATLAS_PAGE_SIZE 1024
+#define ATLAS_PAGES 2
+#define ATLAS_PAGE_IDLE_FRAMES 600
+
+struct AtlasSlot {
+    uint64_t id;
+    uint64_t frame;
+    bool used;
+};
+
+struct AtlasQuad {
+    int slot;
+    SDL_Rect dst;
+};
+
+// title icons are downscaled once when loaded and uploaded on demand into a few
+// shared pages, icons that weren't drawn lately give their slot to visible ones
+static constexpr int s_atlasSlotsPerRow  = ATLAS_PAGE_SIZE / ATLAS_ICON_SIZE;
+static constexpr int s_atlasSlotsPerPage = s_atlasSlotsPerRow * s_atlasSlotsPerRow;
+static SDL_Texture* s_atlasPages[ATLAS_PAGES];
+static AtlasSlot s_atlasSlots[ATLAS_PAGES * s_atlasSlotsPerPage];
+static std::unordered_map<uint64_t, int> s_atlasResident;
+static std::unordered_map<uint64_t, std::vector<Uint32>> s_atlasPixels;
+static std::vector<AtlasQuad> s_atlasQueue;
 
 static FC_Font* getFontFromMap(int size)
 {
@@ -22,6 +65,202 @@ static FC_Font* getFontFromMap(int size)
     return got->second;
 }
 
+static TextMetrics& metricsFromMap(int size)
+{
+    auto it = s_metrics.find(size);
+    if (it == s_metrics.end()) {
+        it = s_metrics
+                 .emplace(size, TextMetrics([size](uint32_t codepoint) -> float {
+                     FC_GlyphData glyph;
+                     FC_Font* font = getFontFromMap(size);
+                     return FC_GetGlyphData(font, &glyph, codepoint) || FC_GetGlyphData(font, &glyph, ' ') ? glyph.rect.w : 0;
+                 }))
+                 .first;
+    }
+    return it->second;
+}
+
+static SDL_Rect atlasRect(int slot)
+{
+    const int cell = slot % s_atlasSlotsPerPage;
+    return {(cell % s_atlasSlotsPerRow) * ATLAS_ICON_SIZE, (cell / s_atlasSlotsPerRow) * ATLAS_ICON_SIZE, ATLAS_ICON_SIZE, ATLAS_ICON_SIZE};
+}
+
+static bool addAtlasIcon(uint64_t id, SDL_Surface* surface, bool opaque)
+{
+    SDL_Surface* converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA8888, 0);
+    if (converted == NULL) {
+        return false;
+    }
+
+    std::vector<Uint32>& pixels = s_atlasPixels[id];
+    pixels.assign(ATLAS_ICON_SIZE * ATLAS_ICON_SIZE, 0);
+    if (converted->w == converted->h && converted->w % ATLAS_ICON_SIZE == 0) {
+        // integer downscale, every atlas pixel is the average of a block of source pixels
+        const int factor  = converted->w / ATLAS_ICON_SIZE;
+        const Uint32 area = factor * factor;
+        SDL_LockSurface(converted);
+        for (int y = 0; y < ATLAS_ICON_SIZE; y++) {
+            for (int x = 0; x < ATLAS_ICON_SIZE; x++) {
+                Uint32 r = 0, g = 0, b = 0, a = 0;
+                for (int dy = 0; dy < factor; dy++) {
+                    const Uint32* row = (const Uint32*)((const Uint8*)converted->pixels + (y * factor + dy) * converted->pitch) + x * factor;
+                    for (int dx = 0; dx < factor; dx++) {
+                        r += row[dx] >> 24;
+                        g += (row[dx] >> 16) & 0xFF;
+                        b += (row[dx] >> 8) & 0xFF;
+                        a += row[dx] & 0xFF;
+                    }
+                }
+                pixels[y * ATLAS_ICON_SIZE + x] = (r / area) << 24 | (g / area) << 16 | (b / area) << 8 | (a / area);
+            }
+        }
+        SDL_UnlockSurface(converted);
+    }
+    else {
+        SDL_Surface* scaled = SDL_CreateRGBSurfaceWithFormatFrom(
+            pixels.data(), ATLAS_ICON_SIZE, ATLAS_ICON_SIZE, 32, ATLAS_ICON_SIZE * sizeof(Uint32), SDL_PIXELFORMAT_RGBA8888);
+        if (scaled != NULL) {
+            SDL_SetSurfaceBlendMode(converted, SDL_BLENDMODE_NONE);
+            SDL_BlitScaled(converted, NULL, scaled, NULL);
+            SDL_FreeSurface(scaled);
+        }
+    }
+    SDL_FreeSurface(converted);
+
+    if (opaque) {
+        for (auto& pixel : pixels) {
+            pixel |= 0xFF;
+        }
+    }
+
+    // a reloaded icon has to be uploaded again
+    auto it = s_atlasResident.find(id);
+    if (it != s_atlasResident.end()) {
+        s_atlasSlots[it->second].used = false;
+        s_atlasResident.erase(it);
+    }
+    return true;
+}
+
+static int atlasSlot(uint64_t id)
+{
+    auto it = s_atlasResident.find(id);
+    if (it != s_atlasResident.end()) {
+        s_atlasSlots[it->second].frame = s_frame;
+        return it->second;
+    }
+
+    auto pixels = s_atlasPixels.find(id);
+    if (pixels == s_atlasPixels.end()) {
+        return -1;
+    }
+
+    // take a free slot, or the one drawn the longest time ago
+    int slot = -1;
+    for (int i = 0; i < ATLAS_PAGES * s_atlasSlotsPerPage; i++) {
+        if (!s_atlasSlots[i].used) {
+            slot = i;
+            break;
+        }
+        if (s_atlasSlots[i].frame != s_frame && (slot == -1 || s_atlasSlots[i].frame < s_atlasSlots[slot].frame)) {
+            slot = i;
+        }
+    }
+    if (slot == -1) {
+        return -1;
+    }
+
+    const int page = slot / s_atlasSlotsPerPage;
+    if (s_atlasPages[page] == NULL) {
+        s_atlasPages[page] = SDL_CreateTexture(s_renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE);
+        if (s_atlasPages[page] == NULL) {
+            return -1;
+        }
+        SDL_SetTextureBlendMode(s_atlasPages[page], SDL_BLENDMODE_BLEND);
+    }
+
+    if (s_atlasSlots[slot].used) {
+        s_atlasResident.erase(s_atlasSlots[slot].id);
+    }
+    const SDL_Rect rect = atlasRect(slot);
+    SDL_UpdateTexture(s_atlasPages[page], &rect, pixels->second.data(), ATLAS_ICON_SIZE * sizeof(Uint32));
+    s_atlasSlots[slot]  = {id, s_frame, true};
+    s_atlasResident[id] = slot;
+    return slot;
+}
+
+static void releaseIdleAtlasPages(void)
+{
+    // the first page holds a whole grid page, further ones only fill up while scrolling
+    for (int page = 1; page < ATLAS_PAGES; page++) {
+        if (s_atlasPages[page] == NULL) {
+            continue;
+        }
+
+        AtlasSlot* slots = s_atlasSlots + page * s_atlasSlotsPerPage;
+        bool idle        = true;
+        for (int i = 0; i < s_atlasSlotsPerPage && idle; i++) {
+            idle = !slots[i].used || slots[i].frame + ATLAS_PAGE_IDLE_FRAMES < s_frame;
+        }
+        if (idle) {
+            for (int i = 0; i < s_atlasSlotsPerPage; i++) {
+                if (slots[i].used) {
+                    s_atlasResident.erase(slots[i].id);
+                    slots[i].used = false;
+                }
+            }
+            SDL_DestroyTexture(s_atlasPages[page]);
+            s_atlasPages[page] = NULL;
+        }
+    }
+}
+
+static std::string textKey(int size, SDL_Color color, int max, const char* text)
+{
+    char prefix[40];
+    snprintf(prefix, sizeof(prefix), "%d:%02X%02X%02X%02X:%d:", size, color.r, color.g, color.b, color.a, max);
+    return prefix + std::string(text);
+}
+
+static const TextRun* textRun(int size, SDL_Color color, int max, const char* text)
+{
+    if (!s_renderTargets) {
+        return nullptr;
+    }
+
+    const std::string key = textKey(size, color, max, text);
+    auto it               = s_textRuns.find(key);
+    if (it == s_textRuns.end()) {
+        uint32_t w, h;
+        SDLH_GetTextDimensions(size, text, &w, &h);
+        TextRun run{nullptr, max > 0 ? max : (int)w, (int)h, 0};
+        if (run.w > 0 && run.h > 0) {
+            run.texture = SDL_CreateTexture(s_renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, run.w, run.h);
+        }
+        if (run.texture == nullptr) {
+            return nullptr;
+        }
+
+        // clear to the transparent text colour so that blending the glyphs doesn't darken their edges
+        SDL_SetTextureBlendMode(run.texture, SDL_BLENDMODE_BLEND);
+        SDL_SetRenderTarget(s_renderer, run.texture);
+        SDL_SetRenderDrawColor(s_renderer, color.r, color.g, color.b, 0);
+        SDL_RenderClear(s_renderer);
+        if (max > 0) {
+            FC_DrawBoxColor(getFontFromMap(size), s_renderer, FC_MakeRect(0, 0, max, h), color, text);
+        }
+        else {
+            FC_DrawColor(getFontFromMap(size), s_renderer, 0, 0, color, text);
+        }
+        SDL_SetRenderTarget(s_renderer, NULL);
+        it = s_textRuns.emplace(key, run).first;
+    }
+
+    it->second.frame = s_frame;
+    return &it->second;
+}
+
 bool SDLH_Init(void)
 {
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER) < 0) {
@@ -40,6 +279,7 @@ bool SDLH_Init(void)
     }
     SDL_SetRenderDrawBlendMode(s_renderer, SDL_BLENDMODE_BLEND);
     SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "2");
+    s_renderTargets = SDL_RenderTargetSupported(s_renderer);
 
     const int img_flags = IMG_INIT_PNG | IMG_INIT_JPG;
     if ((IMG_Init(img_flags) & img_flags) != img_flags) {
@@ -61,6 +301,19 @@ bool SDLH_Init(void)
 
 void SDLH_Exit(void)
 {
+    for (auto& value : s_textRuns) {
+        SDL_DestroyTexture(value.second.texture);
+    }
+    s_textRuns.clear();
+    s_metrics.clear();
+
+    for (auto& page : s_atlasPages) {
+        SDL_DestroyTexture(page);
+        page = NULL;
+    }
+    s_atlasResident.clear();
+    s_atlasPixels.clear();
+
     for (auto& value : s_fonts) {
         FC_FreeFont(value.second);
     }
@@ -84,6 +337,18 @@ void SDLH_Render(void)
 {
     g_currentTime = SDL_GetTicks() / 1000.f;
     SDL_RenderPresent(s_renderer);
+
+    for (auto it = s_textRuns.begin(); it != s_textRuns.end();) {
+        if (it->second.frame != s_frame) {
+            SDL_DestroyTexture(it->second.texture);
+            it = s_textRuns.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+    releaseIdleAtlasPages();
+    s_frame++;
 }
 
 void SDLH_DrawRect(int x, int y, int w, int h, SDL_Color color)
@@ -99,11 +364,24 @@ void SDLH_DrawRect(int x, int y, int w, int h, SDL_Color color)
 
 void SDLH_DrawText(int size, int x, int y, SDL_Color color, const char* text)
 {
+    const TextRun* run = textRun(size, color, 0, text);
+    if (run != nullptr) {
+        SDL_Rect rect = {x, y, run->w, run->h};
+        SDL_RenderCopy(s_renderer, run->texture, NULL, &rect);
+        return;
+    }
     FC_DrawColor(getFontFromMap(size), s_renderer, x, y, color, text);
 }
 
 void SDLH_DrawTextBox(int size, int x, int y, SDL_Color color, int max, const char* text)
 {
+    const TextRun* run = textRun(size, color, max, text);
+    if (run != nullptr) {
+        SDL_Rect rect = {x, y, run->w, run->h};
+        SDL_RenderCopy(s_renderer, run->texture, NULL, &rect);
+        return;
+    }
+
     uint32_t h;
     FC_Font* font = getFontFromMap(size);
     SDLH_GetTextDimensions(size, text, NULL, &h);
@@ -160,11 +438,102 @@ void SDLH_DrawImageScale(SDL_Texture* texture, int x, int y, int w, int h)
 
 void SDLH_GetTextDimensions(int size, const char* text, uint32_t* w, uint32_t* h)
 {
-    FC_Font* f = getFontFromMap(size);
+    // constant labels are measured on every frame, only measure them once
+    if (s_textDimensions.size() > TEXT_DIMENSIONS_CACHE_SIZE) {
+        s_textDimensions.clear();
+    }
+
+    const std::string key = std::to_string(size) + ":" + text;
+    auto it               = s_textDimensions.find(key);
+    if (it == s_textDimensions.end()) {
+        FC_Font* f = getFontFromMap(size);
+        it         = s_textDimensions.emplace(key, std::make_pair(FC_GetWidth(f, text), FC_GetHeight(f, text))).first;
+    }
+
     if (w != NULL)
-        *w = FC_GetWidth(f, text);
+        *w = it->second.first;
     if (h != NULL)
-        *h = FC_GetHeight(f, text);
+        *h = it->second.second;
+}
+
+std::string SDLH_WrapText(int size, const std::string& text, int maxWidth)
+{
+    return TextLayout::join(text, TextLayout::wrap(text, maxWidth, metricsFromMap(size), 1.0f));
+}
+
+bool SDLH_AddAtlasIcon(uint64_t id, uint8_t* buff, size_t size, bool tga)
+{
+    SDL_Surface* surface = tga ? IMG_LoadTGA_RW(SDL_RWFromMem(buff, size)) : IMG_Load_RW(SDL_RWFromMem(buff, size), 1);
+    if (surface == NULL) {
+        return false;
+    }
+    const bool ret = addAtlasIcon(id, surface, true);
+    SDL_FreeSurface(surface);
+    return ret;
+}
+
+bool SDLH_AddAtlasIcon(uint64_t id, const uint32_t* pixels, int w, int h)
+{
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom((void*)pixels, w, h, 32, w * sizeof(uint32_t), SDL_PIXELFORMAT_RGBA8888);
+    if (surface == NULL) {
+        return false;
+    }
+    const bool ret = addAtlasIcon(id, surface, false);
+    SDL_FreeSurface(surface);
+    return ret;
+}
+
+bool SDLH_HasAtlasIcon(uint64_t id)
+{
+    return s_atlasPixels.find(id) != s_atlasPixels.end();
+}
+
+void SDLH_QueueAtlasIcon(uint64_t id, int x, int y, int size)
+{
+    const int slot = atlasSlot(id);
+    if (slot != -1) {
+        s_atlasQueue.push_back({slot, {x, y, size, size}});
+    }
+}
+
+void SDLH_FlushAtlasIcons(void)
+{
+    // a single draw per page, quads are grouped by the page they sample from
+    for (int page = 0; page < ATLAS_PAGES; page++) {
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+        static std::vector<SDL_Vertex> vertices;
+        static std::vector<int> indices;
+        vertices.clear();
+        indices.clear();
+        for (const auto& quad : s_atlasQueue) {
+            if (quad.slot / s_atlasSlotsPerPage != page) {
+                continue;
+            }
+            const SDL_Rect src    = atlasRect(quad.slot);
+            const float u0        = (float)src.x / ATLAS_PAGE_SIZE, v0 = (float)src.y / ATLAS_PAGE_SIZE;
+            const float u1        = (float)(src.x + src.w) / ATLAS_PAGE_SIZE, v1 = (float)(src.y + src.h) / ATLAS_PAGE_SIZE;
+            const float x0        = quad.dst.x, y0 = quad.dst.y, x1 = quad.dst.x + quad.dst.w, y1 = quad.dst.y + quad.dst.h;
+            const SDL_Color white = {255, 255, 255, 255};
+            const int base        = vertices.size();
+            vertices.push_back({{x0, y0}, white, {u0, v0}});
+            vertices.push_back({{x1, y0}, white, {u1, v0}});
+            vertices.push_back({{x1, y1}, white, {u1, v1}});
+            vertices.push_back({{x0, y1}, white, {u0, v1}});
+            indices.insert(indices.end(), {base, base + 1, base + 2, base, base + 2, base + 3});
+        }
+        if (!vertices.empty()) {
+            SDL_RenderGeometry(s_renderer, s_atlasPages[page], vertices.data(), vertices.size(), indices.data(), indices.size());
+        }
+#else
+        for (const auto& quad : s_atlasQueue) {
+            if (quad.slot / s_atlasSlotsPerPage == page) {
+                const SDL_Rect src = atlasRect(quad.slot);
+                SDL_RenderCopy(s_renderer, s_atlasPages[page], &src, &quad.dst);
+            }
+        }
+#endif
+    }
+    s_atlasQueue.clear();
 }
 
 void SDLH_DrawIcon(std::string icon, int x, int y)
@@ -193,12 +562,47 @@ void drawOutline(uint32_t x, uint32_t y, uint16_t w, uint16_t h, uint8_t size, S
 
 void drawPulsingOutline(uint32_t x, uint32_t y, uint16_t w, uint16_t h, uint8_t size, SDL_Color color)
 {
-    float highlight_multiplier = fmax(0.0, fabs(fmod(g_currentTime, 1.0) - 0.5) / 0.5);
+    // the pulse stops once the app is idle, so that the frame doesn't need to be redrawn
+    FrameScheduler::getInstance().animate();
+    float highlight_multiplier = FrameScheduler::getInstance().idle() ? 0 : fmax(0.0, fabs(fmod(g_currentTime, 1.0) - 0.5) / 0.5);
     color                      = FC_MakeColor(color.r + (255 - color.r) * highlight_multiplier, color.g + (255 - color.g) * highlight_multiplier,
         color.b + (255 - color.b) * highlight_multiplier, 255);
     drawOutline(x, y, w, h, size, color);
 }
 
+void drawProfiler(void)
+{
+    static const char* columns[] = {"last", "min", "avg", "p99"};
+    const int x = 860, y = 20, w = 400, rowh = 26, graphh = 90;
+
+    const auto report = Profiler::getInstance().report();
+    const auto frames = Profiler::getInstance().history("frame");
+    const int h       = rowh * (report.size() + 1) + graphh + 30;
+
+    SDLH_DrawRect(x, y, w, h, COLOR_OVERLAY);
+    SDLH_DrawText(20, x + 10, y + 8, COLOR_GREEN, "ms");
+    for (int i = 0; i < 4; i++) {
+        SDLH_DrawText(20, x + 150 + 62 * i, y + 8, COLOR_GREEN, columns[i]);
+    }
+    for (size_t i = 0; i < report.size(); i++) {
+        const int rowy           = y + 8 + rowh * (i + 1);
+        const Profiler::Stats& s = report[i].second;
+        const float values[]     = {s.last, s.min, s.avg, s.p99};
+        SDLH_DrawText(20, x + 10, rowy, COLOR_WHITE, report[i].first.c_str());
+        for (int j = 0; j < 4; j++) {
+            SDLH_DrawText(20, x + 150 + 62 * j, rowy, COLOR_WHITE, StringUtils::format("%.2f", values[j]).c_str());
+        }
+    }
+
+    // one bar per frame, the full height is two frames at 60 fps
+    const int graphx = x + 20, graphy = y + h - 20;
+    for (size_t i = 0; i < frames.size(); i++) {
+        const int barh = std::min(graphh, (int)(frames[i] * graphh / 33.3f));
+        SDLH_DrawRect(graphx + 3 * i, graphy - barh, 2, barh, frames[i] > 16.7f ? COLOR_RED : COLOR_GREEN);
+    }
+    SDLH_DrawRect(graphx, graphy - graphh / 2, 3 * Profiler::HISTORY_SIZE, 1, COLOR_WHITEMASK);
+}
+
 std::string trimToFit(const std::string& text, uint32_t maxsize, size_t textsize)
 {
     uint32_t width;
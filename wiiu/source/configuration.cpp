@@ -124,16 +124,20 @@ void Configuration::store(void)
 
 bool Configuration::filter(uint64_t id)
 {
+    std::lock_guard<std::mutex> lock(mMutex);
     return mFilterIds.find(id) != mFilterIds.end();
 }
 
 bool Configuration::favorite(uint64_t id)
 {
+    std::lock_guard<std::mutex> lock(mMutex);
     return mFavoriteIds.find(id) != mFavoriteIds.end();
 }
 
 std::vector<std::string> Configuration::additionalSaveFolders(uint64_t id)
 {
+    // the folders are copied out under the lock, parse() may replace the map meanwhile
+    std::lock_guard<std::mutex> lock(mMutex);
     std::vector<std::string> emptyvec;
     auto folders = mAdditionalSaveFolders.find(id);
     return folders == mAdditionalSaveFolders.end() ? emptyvec : folders->second;
@@ -163,20 +167,20 @@ void Configuration::load(void)
 
 void Configuration::parse(void)
 {
-    mFilterIds.clear();
-    mFavoriteIds.clear();
-    mAdditionalSaveFolders.clear();
+    // built aside and swapped in under the lock, like on the Switch
+    std::unordered_set<uint64_t> filterIds, favoriteIds;
+    std::unordered_map<uint64_t, std::vector<std::string>> additionalSaveFolders;
 
     // parse filters
     std::vector<std::string> filter = mJson["filter"];
     for (auto& id : filter) {
-        mFilterIds.emplace(strtoull(id.c_str(), NULL, 16));
+        filterIds.emplace(strtoull(id.c_str(), NULL, 16));
     }
 
     // parse favorites
     std::vector<std::string> favorites = mJson["favorites"];
     for (auto& id : favorites) {
-        mFavoriteIds.emplace(strtoull(id.c_str(), NULL, 16));
+        favoriteIds.emplace(strtoull(id.c_str(), NULL, 16));
     }
 
     // parse additional save folders
@@ -187,8 +191,13 @@ void Configuration::parse(void)
         for (auto& folder : folders) {
             sfolders.push_back(folder);
         }
-        mAdditionalSaveFolders.emplace(strtoull(it.key().c_str(), NULL, 16), sfolders);
+        additionalSaveFolders.emplace(strtoull(it.key().c_str(), NULL, 16), sfolders);
     }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mFilterIds.swap(filterIds);
+    mFavoriteIds.swap(favoriteIds);
+    mAdditionalSaveFolders.swap(additionalSaveFolders);
 }
 
 const char* Configuration::c_str(void)
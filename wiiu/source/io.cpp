@@ -282,6 +282,13 @@ std::tuple<bool, int32_t, std::string> io::restore(size_t index, AccountUid uid,
         Logger::getInstance().log(Logger::WARN, "Failed to flush usb");
     } 
 
+    if (title.isvWii()) {
+        res = flushVolume("/vol/storage_slccmpt");
+        if (res != 0) {
+            Logger::getInstance().log(Logger::WARN, "Failed to flush slccmpt");
+        }
+    }
+
     blinkLed(4);
     ret = std::make_tuple(true, 0, nameFromCell + "\nhas been restored successfully.");
     Logger::getInstance().log(Logger::INFO, "Restore succeeded.");
@@ -26,7 +26,12 @@
 
 #include "main.hpp"
 #include "MainScreen.hpp"
+#include "benchmark.hpp"
+#include "framescheduler.hpp"
 #include "input.hpp"
+#include "profiler.hpp"
+#include <coreinit/thread.h>
+#include <coreinit/time.h>
 #include <whb/proc.h>
 
 int main(void)
@@ -46,14 +51,67 @@ int main(void)
     // set g_currentUId to the current user
     g_currentUId = nn::act::GetPersistentId();
 
+    FrameScheduler& scheduler = FrameScheduler::getInstance();
+    Profiler& profiler        = Profiler::getInstance();
+    const auto frameStage     = profiler.stage("frame");
+    Benchmark& benchmark      = Benchmark::getInstance();
+    uint32_t oldHeld          = 0;
     while (WHBProcIsRunning()) {
-        g_screen->doDraw();
+        touchPosition touch;
+        {
+            ProfileScope scope("input");
+            Input::update();
+            touch = Input::getTouch();
+        }
 
-        Input::update();
-        touchPosition touch = Input::getTouch();
-        g_screen->doUpdate(&touch);
-        
-        SDLH_Render();
+        if ((Input::getHeld() & Input::BUTTON_MINUS) && (Input::getDown() & Input::BUTTON_DOWN)) {
+            profiler.toggle();
+        }
+
+        // releasing a button changes the held state as well
+        if (Input::getDown() || Input::getHeld() || Input::getHeld() != oldHeld || touch.touched) {
+            scheduler.invalidate();
+        }
+        oldHeld = Input::getHeld();
+
+        // a running benchmark draws every frame and stands in for the input
+        const bool benchmarking = benchmark.running();
+        if (benchmarking) {
+            scheduler.invalidate();
+            benchmark.beginFrame();
+        }
+
+        if (scheduler.beginFrame(SDL_GetTicks())) {
+            const uint64_t frameStart = Profiler::now();
+            {
+                ProfileScope scope("draw");
+                g_screen->doDraw();
+                if (profiler.visible()) {
+                    drawProfiler();
+                }
+            }
+            if (!benchmarking) {
+                ProfileScope scope("input");
+                g_screen->doUpdate(&touch);
+            }
+            else {
+                benchmark.endFrame();
+            }
+            {
+                ProfileScope scope("present");
+                SDLH_Render();
+            }
+            profiler.add(frameStage, Profiler::now() - frameStart);
+            profiler.endFrame();
+            scheduler.endFrame(SDL_GetTicks());
+        }
+        else {
+            {
+                ProfileScope scope("input");
+                g_screen->doUpdate(&touch);
+            }
+            OSSleepTicks(OSMillisecondsToTicks(scheduler.sleepTime()));
+        }
     }
 
     servicesExit();
@@ -0,0 +1,307 @@
+/*
+ *   This file is part of Checkpoint
+ *   Copyright (C) 2017-2019 Bernardo Giordano, FlagBrew
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "meta.hpp"
+#include "common.hpp"
+#include "json.hpp"
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unordered_map>
+#include <unordered_set>
+
+#define META_CHUNK_SIZE 0x1000
+
+// vWii banner.bin layout, all fields are big endian
+#define BANNER_MAGIC 0x5749424E // WIBN
+#define BANNER_TITLE_OFFSET 0x20
+#define BANNER_TITLE_LENGTH 0x20 // UTF-16 code units
+#define BANNER_ICON_OFFSET 0x60A0
+#define BANNER_ICON_BYTES (Meta::BANNER_ICON_SIZE * Meta::BANNER_ICON_SIZE * 2)
+
+struct CachedMeta {
+    time_t mtime;
+    TitleMeta meta;
+};
+
+static std::mutex cacheMutex;
+static std::unordered_map<std::string, CachedMeta> cache;
+static std::unordered_set<std::string> usedPaths;
+static bool cacheChanged = false;
+
+static std::string decodeEntities(const std::string& str)
+{
+    static const std::pair<std::string, char> entities[] = {{"&amp;", '&'}, {"&lt;", '<'}, {"&gt;", '>'}, {"&quot;", '"'}, {"&apos;", '\''}};
+
+    std::string ret;
+    ret.reserve(str.length());
+    for (size_t i = 0, sz = str.length(); i < sz; i++) {
+        bool decoded = false;
+        if (str[i] == '&') {
+            for (const auto& entity : entities) {
+                if (str.compare(i, entity.first.length(), entity.first) == 0) {
+                    ret += entity.second;
+                    i += entity.first.length() - 1;
+                    decoded = true;
+                    break;
+                }
+            }
+        }
+        if (!decoded) {
+            ret += str[i];
+        }
+    }
+    return ret;
+}
+
+// looks for <tag ...>text</tag> in the bytes read so far
+static bool extract(const std::string& buf, const std::string& tag, std::string& out)
+{
+    const std::string open = "<" + tag;
+    size_t pos             = 0;
+    while ((pos = buf.find(open, pos)) != std::string::npos) {
+        pos += open.length();
+        if (pos < buf.length() && (buf[pos] == '>' || buf[pos] == ' ')) {
+            break;
+        }
+    }
+    if (pos == std::string::npos) {
+        return false;
+    }
+
+    size_t start = buf.find('>', pos);
+    if (start == std::string::npos) {
+        return false;
+    }
+    size_t end = buf.find("</", start);
+    if (end == std::string::npos) {
+        return false;
+    }
+
+    out = decodeEntities(buf.substr(start + 1, end - start - 1));
+    return true;
+}
+
+bool Meta::parse(const std::string& path, TitleMeta& meta)
+{
+    FILE* in = fopen(path.c_str(), "rb");
+    if (in == NULL) {
+        return false;
+    }
+
+    std::string buf, id;
+    char chunk[META_CHUNK_SIZE];
+    bool hasId = false, hasName = false, hasPublisher = false;
+    size_t count;
+    while (!(hasId && hasName && hasPublisher) && (count = fread(chunk, 1, META_CHUNK_SIZE, in)) > 0) {
+        buf.append(chunk, count);
+        hasId        = hasId || extract(buf, "title_id", id);
+        hasName      = hasName || extract(buf, "shortname_en", meta.name);
+        hasPublisher = hasPublisher || extract(buf, "publisher_en", meta.publisher);
+    }
+    fclose(in);
+
+    if (!hasId) {
+        return false;
+    }
+
+    meta.id = strtoull(id.c_str(), NULL, 16);
+    return true;
+}
+
+bool Meta::parseBanner(const std::string& path, TitleMeta& meta)
+{
+    FILE* in = fopen(path.c_str(), "rb");
+    if (in == NULL) {
+        return false;
+    }
+
+    // magic and title are all we need, the banner and icon images follow them
+    uint8_t header[BANNER_TITLE_OFFSET + BANNER_TITLE_LENGTH * 2];
+    size_t count = fread(header, 1, sizeof(header), in);
+    fclose(in);
+
+    uint32_t magic = header[0] << 24 | header[1] << 16 | header[2] << 8 | header[3];
+    if (count != sizeof(header) || magic != BANNER_MAGIC) {
+        return false;
+    }
+
+    std::u16string name;
+    for (size_t i = 0; i < BANNER_TITLE_LENGTH; i++) {
+        char16_t c = header[BANNER_TITLE_OFFSET + i * 2] << 8 | header[BANNER_TITLE_OFFSET + i * 2 + 1];
+        if (c == 0) {
+            break;
+        }
+        name += c;
+    }
+
+    meta.id        = 0;
+    meta.name      = StringUtils::UTF16toUTF8(name);
+    meta.publisher = "";
+    StringUtils::trim(meta.name);
+    return !meta.name.empty();
+}
+
+bool Meta::bannerIcon(const std::string& path, std::vector<uint32_t>& pixels)
+{
+    FILE* in = fopen(path.c_str(), "rb");
+    if (in == NULL) {
+        return false;
+    }
+
+    uint8_t data[BANNER_ICON_BYTES];
+    size_t count = 0;
+    if (fseek(in, BANNER_ICON_OFFSET, SEEK_SET) == 0) {
+        count = fread(data, 1, sizeof(data), in);
+    }
+    fclose(in);
+
+    if (count != sizeof(data)) {
+        return false;
+    }
+
+    // RGB5A3, stored in 4x4 tiles
+    pixels.resize(BANNER_ICON_SIZE * BANNER_ICON_SIZE);
+    size_t i = 0;
+    for (int ty = 0; ty < BANNER_ICON_SIZE; ty += 4) {
+        for (int tx = 0; tx < BANNER_ICON_SIZE; tx += 4) {
+            for (int y = ty; y < ty + 4; y++) {
+                for (int x = tx; x < tx + 4; x++, i += 2) {
+                    uint16_t px = data[i] << 8 | data[i + 1];
+                    uint8_t r, g, b, a;
+                    if (px & 0x8000) {
+                        r = ((px >> 10) & 0x1F) * 255 / 31;
+                        g = ((px >> 5) & 0x1F) * 255 / 31;
+                        b = (px & 0x1F) * 255 / 31;
+                        a = 0xFF;
+                    }
+                    else {
+                        r = ((px >> 8) & 0xF) * 0x11;
+                        g = ((px >> 4) & 0xF) * 0x11;
+                        b = (px & 0xF) * 0x11;
+                        a = ((px >> 12) & 0x7) * 255 / 7;
+                    }
+                    pixels[y * BANNER_ICON_SIZE + x] = r << 24 | g << 16 | b << 8 | a;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool Meta::get(const std::string& path, TitleMeta& meta, bool (*parser)(const std::string&, TitleMeta&))
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        usedPaths.insert(path);
+        auto it = cache.find(path);
+        if (it != cache.end() && it->second.mtime == st.st_mtime) {
+            meta = it->second.meta;
+            return true;
+        }
+    }
+
+    if (!parser(path, meta)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    cache[path]  = {st.st_mtime, meta};
+    cacheChanged = true;
+    return true;
+}
+
+void Meta::loadCache(void)
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    cache.clear();
+    usedPaths.clear();
+    cacheChanged = false;
+
+    FILE* in = fopen(CACHEPATH.c_str(), "rt");
+    if (in == NULL) {
+        return;
+    }
+    nlohmann::json json = nlohmann::json::parse(in, nullptr, false);
+    fclose(in);
+
+    if (!json.is_object()) {
+        return;
+    }
+    for (auto it = json.begin(); it != json.end(); ++it) {
+        // the file may have been truncated or edited by hand, entries missing a field are skipped
+        const nlohmann::json& entry = it.value();
+        if (!entry.is_object()) {
+            continue;
+        }
+        auto mtime     = entry.find("mtime");
+        auto id        = entry.find("id");
+        auto name      = entry.find("name");
+        auto publisher = entry.find("publisher");
+        if (mtime != entry.end() && mtime->is_number() && id != entry.end() && id->is_string() && name != entry.end() && name->is_string() &&
+            publisher != entry.end() && publisher->is_string()) {
+            CachedMeta cached;
+            cached.mtime          = mtime->get<time_t>();
+            cached.meta.id        = strtoull(id->get<std::string>().c_str(), NULL, 16);
+            cached.meta.name      = name->get<std::string>();
+            cached.meta.publisher = publisher->get<std::string>();
+            cache.emplace(it.key(), cached);
+        }
+    }
+}
+
+void Meta::saveCache(void)
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    // rewrite only if titles were parsed or uninstalled since the last scan
+    if (!cacheChanged && usedPaths.size() == cache.size()) {
+        return;
+    }
+
+    nlohmann::json json = nlohmann::json::object();
+    for (const auto& path : usedPaths) {
+        auto it = cache.find(path);
+        if (it != cache.end()) {
+            char id[17];
+            snprintf(id, sizeof(id), "%016llX", (unsigned long long)it->second.meta.id);
+            json[path] = {{"mtime", it->second.mtime}, {"id", id}, {"name", it->second.meta.name}, {"publisher", it->second.meta.publisher}};
+        }
+    }
+
+    std::string writeData = json.dump();
+    FILE* out             = fopen(CACHEPATH.c_str(), "wt");
+    if (out != NULL) {
+        fwrite(writeData.c_str(), 1, writeData.size(), out);
+        fclose(out);
+    }
+    cacheChanged = false;
+}
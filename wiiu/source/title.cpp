@@ -26,30 +26,147 @@
 
 #include "title.hpp"
 
-static std::unordered_map<AccountUid, std::vector<Title>> titles;
-static std::unordered_map<uint64_t, SDL_Texture*> icons;
+struct TitleSortKey {
+    bool favorite;
+    std::string name;
+    uint32_t lastPlayedTimestamp;
+    uint32_t playTimeMinutes;
+};
+
+// titles are stored in load order, together with their sort keys and a
+// precomputed ordering for every sort mode
+struct TitleList {
+    std::vector<Title> titles;
+    std::vector<TitleSortKey> keys;
+    std::vector<size_t> orders[SORT_MODES_COUNT];
+    SearchIndex index;
+    // active ordering restricted to the titles matching the search query
+    std::vector<size_t> view;
+};
+
+static std::unordered_map<AccountUid, TitleList> titles;
+static std::string searchQuery;
+static void loadIcon(uint64_t id, uint8_t* icon, size_t iconsize)
+{
+    if (!SDLH_HasAtlasIcon(id)) {
+        SDLH_AddAtlasIcon(id, icon, iconsize, true);
+    }
+}
 
-void freeIcons(void)
+static void loadIcon(uint64_t id, const uint32_t* pixels, int w, int h)
 {
-    for (auto& i : icons) {
-        SDL_DestroyTexture(i.second);
+    if (!SDLH_HasAtlasIcon(id)) {
+        SDLH_AddAtlasIcon(id, pixels, w, h);
     }
 }
 
-static void loadIcon(uint64_t id, uint8_t* icon, size_t iconsize)
+struct SaveDirectory {
+    std::string path;
+    bool hasMeta;
+    TitleMeta meta;
+    std::vector<uint8_t> icon;
+    std::vector<std::string> users;
+};
+
+// only touches the filesystem, textures and titles are created by the caller
+static void scanSaveDirectories(const std::vector<std::string>& paths, std::vector<SaveDirectory>& saves)
 {
-    auto it = icons.find(id);
-    if (it == icons.end()) {
-        SDL_Texture* texture;
-        SDLH_LoadImage(&texture, icon, iconsize, true);
-        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_NONE);
-        icons.insert({id, texture});
+    for (const auto& path : paths) {
+        Directory dir(path);
+        if (!dir.good()) {
+            continue;
+        }
+
+        for (size_t i = 0, sz = dir.size(); i < sz; i++) {
+            if (!dir.folder(i)) {
+                continue;
+            }
+
+            SaveDirectory save;
+            save.path    = path + "/" + dir.entry(i);
+            save.hasMeta = Meta::get(save.path + "/meta/meta.xml", save.meta);
+            if (save.hasMeta && (save.meta.id == 0 || Configuration::getInstance().filter(save.meta.id))) {
+                continue;
+            }
+
+            if (save.hasMeta) {
+                FILE* iconFile = fopen((save.path + "/meta/iconTex.tga").c_str(), "rb");
+                if (iconFile) {
+                    fseek(iconFile, 0, SEEK_END);
+                    save.icon.resize(ftell(iconFile));
+                    rewind(iconFile);
+                    save.icon.resize(fread(save.icon.data(), 1, save.icon.size(), iconFile));
+                    fclose(iconFile);
+                }
+
+                Directory userdir(save.path + "/user");
+                if (userdir.good()) {
+                    for (size_t j = 0, usz = userdir.size(); j < usz; j++) {
+                        if (userdir.folder(j)) {
+                            save.users.push_back(userdir.entry(j));
+                        }
+                    }
+                }
+            }
+
+            saves.push_back(save);
+        }
+    }
+}
+
+struct VWiiSave {
+    uint64_t id;
+    std::string path;
+    TitleMeta meta;
+    std::vector<uint32_t> icon;
+};
+
+// banner.bin holds the name and icon of a vWii title, only the header and the
+// first icon frame are read, and the name is served by the metadata cache
+static void scanvWiiDirectories(const std::vector<std::string>& paths, std::vector<VWiiSave>& saves)
+{
+    for (const auto& path : paths) {
+        Directory dir(path);
+        if (!dir.good()) {
+            continue;
+        }
+
+        uint64_t high = strtoull(path.substr(path.rfind('/') + 1).c_str(), NULL, 16);
+        for (size_t i = 0, sz = dir.size(); i < sz; i++) {
+            if (!dir.folder(i)) {
+                continue;
+            }
+
+            char* end;
+            uint64_t low = strtoull(dir.entry(i).c_str(), &end, 16);
+            if (*end != '\0') {
+                continue;
+            }
+
+            VWiiSave save;
+            save.id   = high << 32 | low;
+            save.path = path + "/" + dir.entry(i) + "/data";
+            if (Configuration::getInstance().filter(save.id)) {
+                continue;
+            }
+
+            // titles without save data don't have a banner
+            const std::string banner = save.path + "/banner.bin";
+            if (!Meta::get(banner, save.meta, Meta::parseBanner)) {
+                continue;
+            }
+            save.meta.id = save.id;
+            Meta::bannerIcon(banner, save.icon);
+
+            saves.push_back(save);
+        }
     }
 }
 
 void Title::init(uint64_t id, AccountUid userID, const std::string& name, const std::string& author)
 {
     mId           = id;
+    misvWii       = false;
     mUserId       = userID;
     mUserName     = Account::username(userID);
     mAuthor       = author;
@@ -86,12 +203,15 @@ void Title::init(uint64_t id, AccountUid userID, const std::string& name, const
         io::createDirectory(mPath);
     }
 
-    refreshDirectories();
+    // backup lists are built lazily, the first time the title gets focused
+    mDirectoriesLoaded    = false;
+    mDirectoriesTimestamp = 0;
 }
 
-void initvWii(const std::string&name, const std::string& author)
+void Title::initvWii(uint64_t id, AccountUid userID, const std::string& name)
 {
-
+    init(id, userID, name, "");
+    misvWii = true;
 }
 
 bool Title::isvWii(void)
@@ -154,10 +274,9 @@ std::vector<std::string> Title::saves()
     return mSaves;
 }
 
-SDL_Texture* Title::icon(void)
+bool Title::hasIcon(void)
 {
-    auto it = icons.find(mId);
-    return it != icons.end() ? it->second : NULL;
+    return SDLH_HasAtlasIcon(mId);
 }
 
 uint32_t Title::playTimeMinutes(void)
@@ -222,242 +341,301 @@ void Title::refreshDirectories(void)
             }
         }
     }
+
+    mDirectoriesTimestamp = directoriesTimestamp();
+    mDirectoriesLoaded    = true;
+}
+
+void Title::invalidateDirectories(void)
+{
+    mDirectoriesLoaded = false;
+}
+
+bool Title::directoriesOutdated(bool checkTimestamp)
+{
+    return !mDirectoriesLoaded || (checkTimestamp && directoriesTimestamp() != mDirectoriesTimestamp);
+}
+
+time_t Title::directoriesTimestamp(void)
+{
+    // creating or deleting a backup folder updates the modification time of its parent
+    time_t timestamp = 0;
+    struct stat st;
+    if (stat(mPath.c_str(), &st) == 0) {
+        timestamp = st.st_mtime;
+    }
+
+    std::vector<std::string> additionalFolders = Configuration::getInstance().additionalSaveFolders(mId);
+    for (std::vector<std::string>::const_iterator it = additionalFolders.begin(); it != additionalFolders.end(); ++it) {
+        if (stat(it->c_str(), &st) == 0) {
+            timestamp = std::max(timestamp, st.st_mtime);
+        }
+    }
+
+    return timestamp;
+}
+
+static TitleSortKey sortKey(Title& title)
+{
+    std::string name = StringUtils::removeAccents(title.name());
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    return {Configuration::getInstance().favorite(title.id()), name, title.lastPlayedTimestamp(), title.playTimeMinutes()};
 }
 
 void loadTitles()
 {
+    ProfileScope scope("titles");
     titles.clear();
 
     /* Wii U Titles */
 
-    std::vector<std::string> paths { 
+    // USB is scanned concurrently with the internal storages, metadata comes from the cache when meta.xml or banner.bin didn't change
+    static const std::vector<std::string> mlcPaths{
         "storage_mlc:/usr/save/00050000", // eShop title in internal storage
         "storage_mlc:/usr/save/00050002", // eShop title demo / Kiosk Interactive Demo in internal storage
+    };
+    static const std::vector<std::string> usbPaths{
         "storage_usb:/usr/save/00050000", // eShop title on USB
         "storage_usb:/usr/save/00050002", // eShop title demo / Kiosk Interactive Demo on USB
-    }; 
-
-    for (const auto& path : paths) {
-        Directory dir(path);
-        if (dir.good()) {
-            for (uint32_t i = 0; i < dir.size(); i++) {
-                if (dir.folder(i)) {
-                    uint64_t titleId = 0;
-                    std::string titleName;
-                    std::string titlePublisher;
-
-                    // Read metadata from meta.xml
-                    std::string metaXmlPath = path + "/" + dir.entry(i) + "/meta/meta.xml";
-                    FILE* metaXmlFile = fopen(metaXmlPath.c_str(), "rb");
-                    if (metaXmlFile) {
-                        // Get size
-                        fseek(metaXmlFile, 0, SEEK_END);
-                        size_t meta_size = ftell(metaXmlFile);
-                        rewind(metaXmlFile);
-
-                        char* metaXml = (char*) malloc(meta_size);
-                        fread(metaXml, 1, meta_size, metaXmlFile);
-                        fclose(metaXmlFile);
-
-                        tinyxml2::XMLDocument doc;
-                        int res = doc.Parse(metaXml, meta_size);
-                        free(metaXml);
-
-                        if (res != 0) {
-                            continue;
-                        }
-
-                        tinyxml2::XMLElement* root = doc.FirstChildElement();
-                        if (!root) {
-                            continue;
-                        }
+    };
 
-                        tinyxml2::XMLElement* titleIdElement = root->FirstChildElement("title_id");
-                        if (titleIdElement) {
-                            const char* titleIdText = titleIdElement->GetText();
-                            titleId = strtoull(titleIdText, NULL, 16);
-                        }
+    static const std::vector<std::string> vWiiPaths{
+        "slccmpt:/title/00010000", "slccmpt:/title/00010004", // Disc-based games
+        "slccmpt:/title/00010001"                             // Downloaded channels
+    };
+
+    Meta::loadCache();
+    std::vector<SaveDirectory> mlcSaves, usbSaves;
+    std::vector<VWiiSave> vWiiSaves;
+    std::thread usbThread(scanSaveDirectories, std::cref(usbPaths), std::ref(usbSaves));
+    scanSaveDirectories(mlcPaths, mlcSaves);
+    scanvWiiDirectories(vWiiPaths, vWiiSaves);
+    usbThread.join();
+    Meta::saveCache();
+
+    for (auto saves : {&mlcSaves, &usbSaves}) {
+        for (auto& save : *saves) {
+            if (!save.hasMeta) {
+                Logger::getInstance().log(Logger::WARN, "No meta.xml for save " + save.path);
+                continue;
+            }
 
-                        if (Configuration::getInstance().filter(titleId)) {
-                            continue;
-                        }
+            if (!save.icon.empty()) {
+                loadIcon(save.meta.id, save.icon.data(), save.icon.size());
+            }
 
-                        tinyxml2::XMLElement* titleNameElement = root->FirstChildElement("shortname_en");
-                        if (titleNameElement) {
-                            titleName = titleNameElement->GetText();
-                        }
+            for (const auto& user : save.users) {
+                AccountUid uid = 0;
 
-                        tinyxml2::XMLElement* titlePublisherElement = root->FirstChildElement("publisher_en");
-                        if (titlePublisherElement) {
-                            titlePublisher = titlePublisherElement->GetText();
-                        }
-                    }
-                    else {
-                        Logger::getInstance().log(Logger::WARN, "No meta.xml for save " + path + dir.entry(i));
+                // common save
+                if (user == "common") {
+                    uid = COMMONSAVE_ID;
+                }
+                else {
+                    char* ptr;
+                    uid = (AccountUid)strtoul(user.c_str(), &ptr, 16);
+                    if (!ptr) {
                         continue;
                     }
+                }
 
-                    if (titleId == 0) {
-                        continue;
+                Title title;
+                title.init(save.meta.id, uid, save.meta.name, save.meta.publisher);
+                title.sourcePath(save.path + "/user/" + user);
+
+                if (uid != COMMONSAVE_ID) {
+                    nn::act::SlotNo accountSlot = accountIdToSlotNo(uid);
+                    if (accountSlot > 0) {
+                        // load play statistics
+                        nn::pdm::PlayStats stats;
+                        uint32_t res = nn::pdm::GetPlayStatsOfTitleId(&stats, accountSlot, save.meta.id);
+                        title.playTimeMinutes(res == 0 ? stats.playtime : 0);
+                        title.lastPlayedTimestamp(res == 0 ? stats.last_time_played : 0);
                     }
+                }
 
-                    std::string iconPath = path + "/" + dir.entry(i) + "/meta/iconTex.tga";
-                    FILE* iconFile = fopen(iconPath.c_str(), "rb");
-                    if (iconFile) {
-                        fseek(iconFile, 0, SEEK_END);
-                        size_t icon_size = ftell(iconFile);
-                        rewind(iconFile);
+                TitleList& list = titles[uid];
+                list.titles.push_back(title);
+                list.keys.push_back(sortKey(title));
+                list.index.add(StringUtils::removeAccents(title.name()), title.id());
+            }
+        }
+    }
 
-                        uint8_t* icon = (uint8_t*) malloc(icon_size);
-                        fread(icon, 1, icon_size, iconFile);
-                        fclose(iconFile);
+    /* vWii titles */
 
-                        loadIcon(titleId, icon, icon_size);
-                        free(icon);
-                    }
+    // vWii saves are shared by every account, so they are listed for all of them
+    std::vector<AccountUid> users;
+    for (nn::act::SlotNo slot = 1; slot <= 12; slot++) {
+        if (nn::act::IsSlotOccupied(slot)) {
+            users.push_back(nn::act::GetPersistentIdEx(slot));
+        }
+    }
 
-                    Directory userdir(path + "/" + dir.entry(i) + "/user");
-                    if (userdir.good()) {
-                        for (uint32_t j = 0; j < userdir.size(); j++) {
-                            if (userdir.folder(j)) {
-                                AccountUid uid = 0;
-
-                                // common save
-                                if (std::strcmp(userdir.entry(j).c_str(), "common") == 0) {
-                                    uid = COMMONSAVE_ID;
-                                }
-                                else {
-                                    char* ptr;
-                                    uid = (AccountUid) strtoul(userdir.entry(j).c_str(), &ptr, 16);
-                                    if (!ptr) {
-                                        continue;
-                                    }
-                                }
-
-                                Title title;
-                                title.init(titleId, uid, titleName, titlePublisher);
-                                title.sourcePath(path + "/" + dir.entry(i) + "/user/" + userdir.entry(j));
-
-                                if (uid != COMMONSAVE_ID) {
-                                    nn::act::SlotNo accountSlot = accountIdToSlotNo(uid);
-                                    if (accountSlot > 0) {
-                                        // load play statistics
-                                        nn::pdm::PlayStats stats;
-                                        uint32_t res = nn::pdm::GetPlayStatsOfTitleId(&stats, accountSlot, titleId);
-                                        title.playTimeMinutes(res == 0 ? stats.playtime : 0);
-                                        title.lastPlayedTimestamp(res == 0 ? stats.last_time_played : 0);
-                                    }
-                                }
-
-                                // check if the vector is already created
-                                std::unordered_map<AccountUid, std::vector<Title>>::iterator it = titles.find(uid);
-                                if (it != titles.end())  {
-                                    // found
-                                    it->second.push_back(title);
-                                }
-                                else  {
-                                    // not found, insert into map
-                                    std::vector<Title> v;
-                                    v.push_back(title);
-                                    titles.emplace(uid, v);
-                                }
-                            }
-                        }
-                    }
-                }
-            }
+    for (auto& save : vWiiSaves) {
+        if (!save.icon.empty()) {
+            loadIcon(save.id, save.icon.data(), Meta::BANNER_ICON_SIZE, Meta::BANNER_ICON_SIZE);
+        }
+
+        for (AccountUid uid : users) {
+            Title title;
+            title.initvWii(save.id, uid, save.meta.name);
+            title.sourcePath(save.path);
+            title.playTimeMinutes(0);
+            title.lastPlayedTimestamp(0);
+
+            TitleList& list = titles[uid];
+            list.titles.push_back(title);
+            list.keys.push_back(sortKey(title));
+            list.index.add(StringUtils::removeAccents(title.name()), title.id());
         }
     }
 
-    /* TODO vWii titles */
+    sortTitles();
+}
 
-    std::vector<std::string> vWiiPaths { 
-        "slccmpt:/title/00010000", "slccmpt:/title/00010004", // Disc-based games
-        "slccmpt:/title/00010001"                             // Downloaded channels
-    }; 
+static bool compareTitles(const TitleSortKey& l, const TitleSortKey& r, sort_t mode)
+{
+    if (l.favorite != r.favorite) {
+        return l.favorite;
+    }
+    switch (mode) {
+        case SORT_LAST_PLAYED:
+            return l.lastPlayedTimestamp > r.lastPlayedTimestamp;
+        case SORT_PLAY_TIME:
+            return l.playTimeMinutes > r.playTimeMinutes;
+        case SORT_ALPHA:
+        default:
+            return l.name < r.name;
+    }
+}
 
-    for (const auto& path : vWiiPaths) {
-        Directory dir(path);
-        if (dir.good()) {
-            for (uint32_t i = 0; i < dir.size(); i++) {
-                if (dir.folder(i)) {
-                    
-                }
+static const std::vector<size_t>& visibleOrder(const TitleList& list)
+{
+    return searchQuery.empty() ? list.orders[g_sortMode] : list.view;
+}
+
+static void updateViews(void)
+{
+    if (searchQuery.empty()) {
+        return;
+    }
+
+    for (auto& pair : titles) {
+        TitleList& list = pair.second;
+        std::vector<bool> matches(list.titles.size(), false);
+        for (size_t i : list.index.find(searchQuery)) {
+            matches.at(i) = true;
+        }
+
+        list.view.clear();
+        for (size_t i : list.orders[g_sortMode]) {
+            if (matches.at(i)) {
+                list.view.push_back(i);
             }
         }
     }
-
-    sortTitles();
 }
 
 void sortTitles(void)
 {
-    for (auto& vect : titles) {
-        std::sort(vect.second.begin(), vect.second.end(), [](Title& l, Title& r) {
-            if (Configuration::getInstance().favorite(l.id()) != Configuration::getInstance().favorite(r.id())) {
-                return Configuration::getInstance().favorite(l.id());
-            }
-            switch (g_sortMode) {
-                case SORT_LAST_PLAYED:
-                    return l.lastPlayedTimestamp() > r.lastPlayedTimestamp();
-                case SORT_PLAY_TIME:
-                    return l.playTimeMinutes() > r.playTimeMinutes();
-                case SORT_ALPHA:
-                default:
-                    return l.name() < r.name();
-            }
-        });
+    for (auto& pair : titles) {
+        TitleList& list = pair.second;
+        for (int mode = 0; mode < SORT_MODES_COUNT; mode++) {
+            std::vector<size_t>& order = list.orders[mode];
+            order.resize(list.titles.size());
+            std::iota(order.begin(), order.end(), 0);
+            std::stable_sort(order.begin(), order.end(),
+                [&list, mode](size_t l, size_t r) { return compareTitles(list.keys.at(l), list.keys.at(r), static_cast<sort_t>(mode)); });
+        }
     }
+    updateViews();
 }
 
 void rotateSortMode(void)
 {
     g_sortMode = static_cast<sort_t>((g_sortMode + 1) % SORT_MODES_COUNT);
-    sortTitles();
+    updateViews();
+}
+
+void searchTitles(const std::string& query)
+{
+    searchQuery = StringUtils::removeAccents(query);
+    StringUtils::trim(searchQuery);
+    updateViews();
+}
+
+std::string titleSearchQuery(void)
+{
+    return searchQuery;
+}
+
+static void validateDirectories(Title& title)
+{
+    // only hit the sd card when the focus moves to another title or user: the cached
+    // list is otherwise kept until a backup, restore or delete invalidates it
+    static uint64_t focusedId    = 0;
+    static AccountUid focusedUid = 0;
+    const bool focusChanged      = title.id() != focusedId || title.userId() != focusedUid;
+    focusedId                    = title.id();
+    focusedUid                   = title.userId();
+    if (title.directoriesOutdated(focusChanged)) {
+        title.refreshDirectories();
+    }
+}
+
+static Title& titleAt(TitleList& list, size_t i)
+{
+    return list.titles.at(visibleOrder(list).at(i));
 }
 
 void getTitle(Title& dst, AccountUid uid, size_t i)
 {
-    std::unordered_map<AccountUid, std::vector<Title>>::iterator it = titles.find(uid);
+    std::unordered_map<AccountUid, TitleList>::iterator it = titles.find(uid);
     if (it != titles.end() && i < getTitleCount(uid)) {
-        dst = it->second.at(i);
+        validateDirectories(titleAt(it->second, i));
+        dst = titleAt(it->second, i);
     }
 }
 
 size_t getTitleCount(AccountUid uid)
 {
-    std::unordered_map<AccountUid, std::vector<Title>>::iterator it = titles.find(uid);
-    return it != titles.end() ? it->second.size() : 0;
+    std::unordered_map<AccountUid, TitleList>::iterator it = titles.find(uid);
+    return it != titles.end() ? visibleOrder(it->second).size() : 0;
 }
 
 bool favorite(AccountUid uid, int i)
 {
-    std::unordered_map<AccountUid, std::vector<Title>>::iterator it = titles.find(uid);
-    return it != titles.end() ? Configuration::getInstance().favorite(it->second.at(i).id()) : false;
+    std::unordered_map<AccountUid, TitleList>::iterator it = titles.find(uid);
+    return it != titles.end() ? it->second.keys.at(visibleOrder(it->second).at(i)).favorite : false;
 }
 
 void refreshDirectories(uint64_t id)
 {
     for (auto& pair : titles) {
-        for (size_t i = 0; i < pair.second.size(); i++) {
-            if (pair.second.at(i).id() == id) {
-                pair.second.at(i).refreshDirectories();
+        for (auto& title : pair.second.titles) {
+            if (title.id() == id) {
+                title.invalidateDirectories();
             }
         }
     }
 }
 
-SDL_Texture* smallIcon(AccountUid uid, size_t i)
+bool queueSmallIcon(AccountUid uid, size_t i, int x, int y)
 {
-    std::unordered_map<AccountUid, std::vector<Title>>::iterator it = titles.find(uid);
-    return it != titles.end() ? it->second.at(i).icon() : NULL;
+    std::unordered_map<AccountUid, TitleList>::iterator it = titles.find(uid);
+    if (it == titles.end() || !titleAt(it->second, i).hasIcon()) {
+        return false;
+    }
+    SDLH_QueueAtlasIcon(titleAt(it->second, i).id(), x, y, 128);
+    return true;
 }
 
 std::unordered_map<std::string, std::string> getCompleteTitleList(void)
 {
     std::unordered_map<std::string, std::string> map;
     for (const auto& pair : titles) {
-        for (auto value : pair.second) {
+        for (auto value : pair.second.titles) {
             map.insert({StringUtils::format("0x%016llX", value.id()), value.name()});
         }
     }
@@ -33,7 +33,6 @@ static void some_func(IOSError err, void *arg) { (void)arg; }
 void servicesExit(void)
 {
     Input::finalize();
-    freeIcons();
 
     unmount_fs("storage_mlc");
     unmount_fs("storage_usb");